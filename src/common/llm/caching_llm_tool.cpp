@@ -0,0 +1,204 @@
+#include "common/llm/caching_llm_tool.h"
+#include "common/utils/cache_dir.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace agenticdsl {
+
+namespace {
+
+constexpr int kFormatVersion = 1;
+
+std::uint64_t fnv1a(std::string_view data) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+CachingLLMTool::CachingLLMTool(std::unique_ptr<ILLMTool> inner, Options options)
+    : inner_(std::move(inner)), options_(std::move(options)) {
+    if (!inner_) {
+        throw std::invalid_argument("CachingLLMTool requires an inner tool");
+    }
+    if (options_.model_id.empty()) {
+        throw std::invalid_argument("CachingLLMTool requires a model_id");
+    }
+}
+
+bool CachingLLMTool::is_deterministic(const LLMParams& params) {
+    return params.temperature <= 0.0f || params.seed >= 0;
+}
+
+std::filesystem::path CachingLLMTool::default_directory() {
+    if (const char* dir = std::getenv("AGENTICDSL_LLM_CACHE_DIR"); dir && *dir) {
+        return std::filesystem::path(dir);
+    }
+    return user_cache_directory("agenticdsl-llm-cache");
+}
+
+std::string CachingLLMTool::cache_key(const std::string& prompt, const LLMParams& params) const {
+    // n_ctx / n_threads 不影响输出，不参与键
+    nlohmann::json key = nlohmann::json::array({
+        kFormatVersion, options_.model_id, params.model, prompt,
+        params.temperature, params.max_tokens, params.top_p, params.top_k, params.min_p, params.seed, params.grammar,
+    });
+    return key.dump();
+}
+
+LLMResult CachingLLMTool::generate(const std::string& prompt, const LLMParams& params) {
+    return generate_stream(prompt, nullptr, params);
+}
+
+LLMResult CachingLLMTool::generate_stream(const std::string& prompt, const StreamCallback& on_chunk, const LLMParams& params) {
+    if (!is_deterministic(params)) {
+        return on_chunk ? inner_->generate_stream(prompt, on_chunk, params) : inner_->generate(prompt, params);
+    }
+
+    const std::string key = cache_key(prompt, params);
+    const std::uint64_t hash = fnv1a(key);
+    if (auto entry = lookup(hash, key)) {
+        LLMResult result;
+        result.success = true;
+        result.text = std::move(entry->text);
+        result.tokens_generated = entry->tokens_generated;
+        if (on_chunk && !result.text.empty()) {
+            result.stopped = !on_chunk(result.text);
+        }
+        return result;
+    }
+
+    LLMResult result = on_chunk ? inner_->generate_stream(prompt, on_chunk, params) : inner_->generate(prompt, params);
+    if (result.success && !result.stopped) {
+        store(hash, Entry{key, result.text, result.tokens_generated});
+    }
+    return result;
+}
+
+std::optional<CachingLLMTool::Entry> CachingLLMTool::lookup(std::uint64_t hash, const std::string& key) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(hash);
+        if (it != index_.end() && it->second->second.key == key) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            ++hits_;
+            return it->second->second;
+        }
+    }
+
+    // 内存未命中再查磁盘；读文件不持锁
+    if (!options_.directory.empty()) {
+        if (auto entry = read_entry(hash); entry && entry->key == key) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++hits_;
+            remember(hash, *entry);
+            return entry;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++misses_;
+    return std::nullopt;
+}
+
+void CachingLLMTool::store(std::uint64_t hash, Entry entry) {
+    if (!options_.directory.empty()) {
+        write_entry(hash, entry);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    remember(hash, std::move(entry));
+}
+
+void CachingLLMTool::remember(std::uint64_t hash, Entry entry) {
+    if (options_.capacity == 0) return;
+    if (auto it = index_.find(hash); it != index_.end()) {
+        lru_.erase(it->second); // 同一哈希只保留最新条目
+    }
+    lru_.emplace_front(hash, std::move(entry));
+    index_[hash] = lru_.begin();
+    while (lru_.size() > options_.capacity) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+std::filesystem::path CachingLLMTool::entry_path(std::uint64_t hash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.json", static_cast<unsigned long long>(hash));
+    return options_.directory / name;
+}
+
+std::optional<CachingLLMTool::Entry> CachingLLMTool::read_entry(std::uint64_t hash) const {
+    std::ifstream file(entry_path(hash), std::ios::binary);
+    if (!file) return std::nullopt;
+    try {
+        nlohmann::json j = nlohmann::json::parse(file);
+        Entry entry;
+        entry.key = j.at("key").get<std::string>();
+        entry.text = j.at("text").get<std::string>();
+        entry.tokens_generated = j.value("tokens_generated", 0);
+        return entry;
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] Ignoring corrupt LLM cache entry " << entry_path(hash) << ": " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+void CachingLLMTool::write_entry(std::uint64_t hash, const Entry& entry) const {
+    std::error_code ec;
+    std::filesystem::create_directories(options_.directory, ec);
+    if (ec) return;
+
+    nlohmann::json j;
+    j["key"] = entry.key;
+    j["text"] = entry.text;
+    j["tokens_generated"] = entry.tokens_generated;
+    const std::string data = j.dump();
+
+    // 先写临时文件再 rename，并发进程不会读到半截条目
+    const auto target = entry_path(hash);
+    auto tmp = target;
+    tmp += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()) ^
+                                   static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) return;
+        f.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!f) {
+            f.close();
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp, target, ec);
+    if (ec) std::filesystem::remove(tmp, ec);
+}
+
+bool CachingLLMTool::is_available() const {
+    return inner_->is_available();
+}
+
+std::string CachingLLMTool::name() const {
+    return inner_->name();
+}
+
+size_t CachingLLMTool::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+size_t CachingLLMTool::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+} // namespace agenticdsl
@@ -0,0 +1,76 @@
+#ifndef AGENTICDSL_LLM_CACHING_LLM_TOOL_H
+#define AGENTICDSL_LLM_CACHING_LLM_TOOL_H
+
+#include "common/llm/llm_tool.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace agenticdsl {
+
+// ILLMTool 的缓存装饰器：以 (模型, prompt, 采样参数) 为键缓存生成结果，
+// 内存中按 LRU 保留最近的条目，可选地落盘供后续进程复用。
+// 只缓存确定性采样（temperature <= 0 或固定 seed）的完整结果；其余调用直接透传
+class CachingLLMTool : public ILLMTool {
+public:
+    struct Options {
+        size_t capacity = 1024;              // 内存条目上限；0 = 不做内存缓存
+        std::filesystem::path directory;     // 磁盘缓存目录；空 = 只用内存
+        std::string model_id;                // 参与键计算的模型标识，必填（如 LlamaTool::model_id()）；
+                                             // inner->name() 不区分模型文件，不能代替
+    };
+
+    // inner 为空或 options.model_id 为空时抛出 std::invalid_argument
+    CachingLLMTool(std::unique_ptr<ILLMTool> inner, Options options);
+
+    LLMResult generate(const std::string& prompt, const LLMParams& params = {}) override;
+    // 命中时整段文本作为一个块回调；未命中时透传流式回调，提前停止的结果不缓存
+    LLMResult generate_stream(const std::string& prompt, const StreamCallback& on_chunk, const LLMParams& params = {}) override;
+    bool is_available() const override;
+    std::string name() const override;
+
+    // 同一 prompt 与参数是否必然得到相同输出
+    static bool is_deterministic(const LLMParams& params);
+
+    // 默认磁盘目录：$AGENTICDSL_LLM_CACHE_DIR，否则为当前用户的缓存目录（见 user_cache_directory）；
+    // 返回空路径时只用内存缓存
+    static std::filesystem::path default_directory();
+
+    size_t hits() const;
+    size_t misses() const;
+
+private:
+    struct Entry {
+        std::string key; // 完整键，用于排除哈希碰撞
+        std::string text;
+        int tokens_generated = 0;
+    };
+
+    std::string cache_key(const std::string& prompt, const LLMParams& params) const;
+    std::optional<Entry> lookup(std::uint64_t hash, const std::string& key);
+    void store(std::uint64_t hash, Entry entry);
+    void remember(std::uint64_t hash, Entry entry); // 放入 LRU；调用方持有 mutex_
+
+    std::filesystem::path entry_path(std::uint64_t hash) const;
+    std::optional<Entry> read_entry(std::uint64_t hash) const;
+    void write_entry(std::uint64_t hash, const Entry& entry) const;
+
+    std::unique_ptr<ILLMTool> inner_;
+    Options options_;
+
+    mutable std::mutex mutex_; // 保护 LRU 与计数
+    std::list<std::pair<std::uint64_t, Entry>> lru_; // 表头为最近使用
+    std::unordered_map<std::uint64_t, std::list<std::pair<std::uint64_t, Entry>>::iterator> index_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_LLM_CACHING_LLM_TOOL_H
@@ -1,4 +1,7 @@
 #include "llama_adapter.h"
+#include "model_registry.h"
+#include <algorithm>
+#include <iostream>
 #include <stdexcept>
 #include <vector>
 #include <cstdlib>
@@ -8,23 +11,21 @@ namespace agenticdsl {
 
 LlamaAdapter::LlamaAdapter(const Config& config)
     : config_(config),
-      model_(nullptr, llama_model_free),
-      ctx_(nullptr, llama_free),
-      sampler_(nullptr, llama_sampler_free) {
+      ctx_(nullptr, llama_free) {
 
-    // Load model
-    llama_model_params model_params = llama_model_default_params();
-    model_params.n_gpu_layers = 99; // Use all GPU layers if available
-
-    llama_model* raw_model = llama_model_load_from_file(config_.model_path.c_str(), model_params);
-    if (!raw_model) {
+    // Load model (shared); use all GPU layers if available
+    model_ = ModelRegistry::instance().acquire(config_.model_path, 99);
+    if (!model_) {
         throw std::runtime_error("Failed to load model: " + config_.model_path);
     }
-    model_.reset(raw_model);
 
     // Create context
+    const int n_parallel = std::max(1, config_.n_parallel);
     llama_context_params ctx_params = llama_context_default_params();
     ctx_params.n_ctx = config_.n_ctx;
+    ctx_params.n_seq_max = static_cast<uint32_t>(n_parallel);
+    ctx_params.n_batch = static_cast<uint32_t>(std::max(1, config_.n_batch));
+    ctx_params.n_ubatch = std::min(ctx_params.n_batch, static_cast<uint32_t>(std::max(1, config_.n_ubatch)));
     ctx_params.n_threads = config_.n_threads;
     ctx_params.n_threads_batch = config_.n_threads;
 
@@ -33,23 +34,112 @@ LlamaAdapter::LlamaAdapter(const Config& config)
         throw std::runtime_error("Failed to create context");
     }
     ctx_.reset(raw_ctx);
+    n_ctx_seq_ = sequence_window(llama_n_ctx(ctx_.get()), n_parallel);
+
+    // 每个 slot 一条采样链（dist 采样器带有随机状态，不能在序列间共享）
+    slots_.resize(n_parallel);
+    for (int i = 0; i < n_parallel; ++i) {
+        slots_[i].seq_id = i;
+        slots_[i].sampling = default_sampling();
+        slots_[i].sampler.reset(make_sampler(slots_[i].sampling));
+    }
+
+    if (!config_.draft_model_path.empty() && config_.n_draft > 0) {
+        init_draft();
+    }
+
+    worker_ = std::thread([this] { run(); });
+}
+
+void LlamaAdapter::init_draft() {
+    // 草稿模型是可选加速，加载失败不影响主模型
+    auto disable = [this](const std::string& reason) {
+        std::cerr << "[WARNING] Speculative decoding disabled: " << reason << std::endl;
+        draft_ctx_.reset();
+        draft_model_.reset();
+    };
 
-    // Create sampler chain
+    draft_model_ = ModelRegistry::instance().acquire(config_.draft_model_path, 99);
+    if (!draft_model_) {
+        return disable("failed to load draft model " + config_.draft_model_path);
+    }
+    if (llama_vocab_n_tokens(llama_model_get_vocab(draft_model_.get())) !=
+        llama_vocab_n_tokens(llama_model_get_vocab(model_.get()))) {
+        return disable("draft model vocabulary differs from " + config_.model_path);
+    }
+
+    // 与主 context 相同的序列数与窗口，slot 的 seq_id 在两边一一对应
+    llama_context_params ctx_params = llama_context_default_params();
+    ctx_params.n_ctx = llama_n_ctx(ctx_.get());
+    ctx_params.n_seq_max = static_cast<uint32_t>(slots_.size());
+    ctx_params.n_batch = llama_n_batch(ctx_.get());
+    ctx_params.n_ubatch = llama_n_ubatch(ctx_.get());
+    ctx_params.n_threads = config_.n_threads;
+    ctx_params.n_threads_batch = config_.n_threads;
+    draft_ctx_.reset(llama_init_from_model(draft_model_.get(), ctx_params));
+    if (!draft_ctx_) {
+        return disable("failed to create draft context");
+    }
+
+    // 草稿只取最可能的 token，接受与否由主模型的采样决定
+    draft_sampler_.reset(llama_sampler_chain_init(llama_sampler_chain_default_params()));
+    llama_sampler_chain_add(draft_sampler_.get(), llama_sampler_init_greedy());
+    draft_batch_ = llama_batch_init(static_cast<int32_t>(ctx_params.n_batch), 0, 1);
+}
+
+LlamaAdapter::~LlamaAdapter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+    if (draft_ctx_) llama_batch_free(draft_batch_);
+}
+
+LlamaAdapter::SamplingParams LlamaAdapter::default_sampling() const {
+    SamplingParams sampling;
+    sampling.temperature = config_.temperature;
+    sampling.min_p = config_.min_p;
+    sampling.n_predict = config_.n_predict;
+    return sampling;
+}
+
+llama_sampler* LlamaAdapter::make_sampler(const SamplingParams& sampling) const {
     auto smpl_params = llama_sampler_chain_default_params();
     llama_sampler* raw_sampler = llama_sampler_chain_init(smpl_params);
-    llama_sampler_chain_add(raw_sampler, llama_sampler_init_min_p(config_.min_p, 1));
-    llama_sampler_chain_add(raw_sampler, llama_sampler_init_temp(config_.temperature));
-    llama_sampler_chain_add(raw_sampler, llama_sampler_init_dist(LLAMA_DEFAULT_SEED));
-    sampler_.reset(raw_sampler);
+    if (!sampling.grammar.empty()) {
+        // 放在链首：先屏蔽语法不允许的 token，再做截断与采样
+        llama_sampler* grammar = llama_sampler_init_grammar(llama_model_get_vocab(model_.get()),
+                                                            sampling.grammar.c_str(), "root");
+        if (!grammar) {
+            llama_sampler_free(raw_sampler);
+            return nullptr;
+        }
+        llama_sampler_chain_add(raw_sampler, grammar);
+    }
+    if (sampling.temperature <= 0.0f) {
+        llama_sampler_chain_add(raw_sampler, llama_sampler_init_greedy());
+        return raw_sampler;
+    }
+    if (sampling.top_k > 0) {
+        llama_sampler_chain_add(raw_sampler, llama_sampler_init_top_k(sampling.top_k));
+    }
+    if (sampling.top_p > 0.0f && sampling.top_p < 1.0f) {
+        llama_sampler_chain_add(raw_sampler, llama_sampler_init_top_p(sampling.top_p, 1));
+    }
+    llama_sampler_chain_add(raw_sampler, llama_sampler_init_min_p(sampling.min_p, 1));
+    llama_sampler_chain_add(raw_sampler, llama_sampler_init_temp(sampling.temperature));
+    llama_sampler_chain_add(raw_sampler, llama_sampler_init_dist(sampling.seed));
+    return raw_sampler;
 }
 
-LlamaAdapter::~LlamaAdapter() = default;
-
 std::vector<llama_token> LlamaAdapter::tokenize(const std::string& text, bool add_bos) {
     const llama_vocab* vocab = llama_model_get_vocab(model_.get());
     int32_t n_tokens = llama_tokenize(vocab, text.data(), static_cast<int32_t>(text.size()),
                                       nullptr, 0, add_bos, true);
-    if (n_tokens < 0) return {};
+    // 缓冲区不足时返回所需 token 数的相反数
+    if (n_tokens < 0) n_tokens = -n_tokens;
 
     std::vector<llama_token> tokens(n_tokens);
     if (llama_tokenize(vocab, text.data(), static_cast<int32_t>(text.size()),
@@ -67,53 +157,419 @@ std::string LlamaAdapter::detokenize(llama_token token) {
     return std::string(buf, n);
 }
 
-std::string LlamaAdapter::generate(const std::string& prompt) {
+size_t LlamaAdapter::reusable_prefix(const std::vector<llama_token>& cached, const std::vector<llama_token>& prompt) {
+    size_t n = 0;
+    const size_t limit = std::min(cached.size(), prompt.size());
+    while (n < limit && cached[n] == prompt[n]) ++n;
+    if (n == prompt.size() && n > 0) --n;
+    return n;
+}
+
+size_t LlamaAdapter::keep_tokens() const {
+    return keep_tokens(config_.n_keep, n_ctx_seq_);
+}
+
+size_t LlamaAdapter::keep_tokens(int n_keep, size_t window) {
+    // 至少给平移留出半个窗口；默认保留整半个窗口，系统提示与指令通常在开头
+    const size_t half = std::max<size_t>(1, window / 2);
+    if (n_keep < 0) return half;
+    return std::clamp<size_t>(static_cast<size_t>(n_keep), 1, half);
+}
+
+void LlamaAdapter::truncate_prompt(std::vector<llama_token>& tokens, size_t window, size_t n_keep) {
+    if (tokens.size() < window) return;
+    n_keep = std::min(n_keep, window / 2);
+    // 与上下文平移一致：n_keep 之后只留一半，另一半留给生成
+    const size_t n_tail = std::max<size_t>(1, (window - n_keep) / 2);
+    tokens.erase(tokens.begin() + static_cast<std::ptrdiff_t>(n_keep),
+                 tokens.end() - static_cast<std::ptrdiff_t>(n_tail));
+}
+
+std::future<std::string> LlamaAdapter::submit(const std::string& prompt, TokenCallback on_token,
+                                              std::optional<SamplingParams> sampling) {
     if (!is_loaded()) {
         throw std::runtime_error("Model not loaded");
     }
 
-    // Check if context is empty (first call)
-    bool is_first = llama_memory_seq_pos_max(llama_get_memory(ctx_.get()), 0) == -1;
-
-    auto tokens = tokenize(prompt, is_first);
-    if (tokens.empty()) {
+    // 每次调用都是完整 prompt；与 slot 中已缓存的前缀（通常是系统提示）由推理线程复用
+    auto request = std::make_unique<Request>();
+    request->tokens = tokenize(prompt, true);
+    if (request->tokens.empty()) {
         throw std::runtime_error("Tokenization failed");
     }
+    if (request->tokens.size() >= n_ctx_seq_) {
+        if (!config_.context_shift) {
+            throw std::runtime_error("Prompt exceeds context window (" + std::to_string(request->tokens.size()) +
+                                     " >= " + std::to_string(n_ctx_seq_) + " tokens)");
+        }
+        const size_t original = request->tokens.size();
+        truncate_prompt(request->tokens, n_ctx_seq_, keep_tokens());
+        std::cerr << "[WARNING] Prompt of " << original << " tokens exceeds the context window of " << n_ctx_seq_
+                  << "; dropped " << original - request->tokens.size() << " tokens after the first "
+                  << keep_tokens() << std::endl;
+    }
+    request->on_token = std::move(on_token);
+    request->sampling = sampling.value_or(default_sampling());
+    auto future = request->promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(request));
+    }
+    cv_.notify_one();
+    return future;
+}
+
+std::string LlamaAdapter::generate(const std::string& prompt) {
+    return generate(prompt, nullptr);
+}
+
+std::string LlamaAdapter::generate(const std::string& prompt, const TokenCallback& on_token) {
+    return submit(prompt, on_token).get();
+}
+
+std::string LlamaAdapter::generate(const std::string& prompt, const TokenCallback& on_token, const SamplingParams& sampling) {
+    return submit(prompt, on_token, sampling).get();
+}
+
+bool LlamaAdapter::has_free_slot() const {
+    return std::any_of(slots_.begin(), slots_.end(), [](const Slot& s) { return !s.request; });
+}
+
+bool LlamaAdapter::has_active_slot() const {
+    return std::any_of(slots_.begin(), slots_.end(), [](const Slot& s) { return s.request != nullptr; });
+}
+
+void LlamaAdapter::run() {
+    // 预留 n_batch 个位置；每个 token 只属于一个序列
+    const int32_t capacity = std::max<int32_t>(1, static_cast<int32_t>(llama_n_batch(ctx_.get())));
+    llama_batch batch = llama_batch_init(capacity, 0, 1);
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_ || has_active_slot() || !queue_.empty(); });
+            if (stop_) break;
+            // 新请求在 token 边界加入正在进行的批次
+            while (!queue_.empty() && has_free_slot()) {
+                auto request = std::move(queue_.front());
+                queue_.pop_front();
+                assign(std::move(request));
+            }
+        }
+        step(batch, capacity);
+    }
+
+    llama_batch_free(batch);
+    auto stopped = std::make_exception_ptr(std::runtime_error("LlamaAdapter stopped"));
+    for (auto& slot : slots_) {
+        if (slot.request) fail(slot, stopped);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& request : queue_) request->promise.set_exception(stopped);
+    queue_.clear();
+}
 
-    // Prepare batch
-    llama_batch batch = llama_batch_get_one(tokens.data(), static_cast<int32_t>(tokens.size()));
+size_t LlamaAdapter::sequence_window(uint32_t n_ctx, int n_parallel) {
+    return std::max<size_t>(2, n_ctx / static_cast<uint32_t>(std::max(1, n_parallel)));
+}
+
+int LlamaAdapter::choose_slot(const std::vector<const std::vector<llama_token>*>& caches, const std::vector<llama_token>& prompt) {
+    int best = -1;
+    size_t best_prefix = 0;
+    for (size_t i = 0; i < caches.size(); ++i) {
+        if (!caches[i]) continue;
+        const size_t prefix = reusable_prefix(*caches[i], prompt);
+        if (best < 0 || prefix > best_prefix) {
+            best = static_cast<int>(i);
+            best_prefix = prefix;
+        }
+    }
+    return best;
+}
+
+void LlamaAdapter::assign(std::unique_ptr<Request> request) {
+    // 前缀匹配最长的空闲 slot，可复用其 KV 缓存（run 只在有空闲 slot 时调用）
+    std::vector<const std::vector<llama_token>*> caches;
+    for (const auto& slot : slots_) caches.push_back(slot.request ? nullptr : &slot.cached);
+    Slot* best = &slots_[choose_slot(caches, request->tokens)];
+    size_t best_prefix = reusable_prefix(best->cached, request->tokens);
+
+    // 参数相同就复用采样链（finish 时已 reset，固定种子时结果可复现）
+    if (!(best->sampling == request->sampling)) {
+        llama_sampler* sampler = make_sampler(request->sampling);
+        if (!sampler) {
+            // 语法错误：不占用 slot，也不动其缓存
+            request->promise.set_exception(std::make_exception_ptr(std::runtime_error("Invalid grammar")));
+            return;
+        }
+        best->sampler.reset(sampler);
+        best->sampling = request->sampling;
+    }
+
+    // 从第一个不同的 token 起截断缓存，只预填充后缀
+    llama_memory_t memory = llama_get_memory(ctx_.get());
+    if (!llama_memory_seq_rm(memory, best->seq_id, static_cast<llama_pos>(best_prefix), -1)) {
+        // 部分模型（如循环结构）不支持部分删除，只能清空整个序列
+        llama_memory_seq_rm(memory, best->seq_id, -1, -1);
+        best_prefix = 0;
+    }
+    best->cached.resize(best_prefix);
+    last_reused_tokens_ = best_prefix;
+
+    best->pending.assign(request->tokens.begin() + best_prefix, request->tokens.end());
+    best->pending_pos = 0;
+    best->prefilling = true;
+    best->n_generated = 0;
+    best->response.clear();
+    best->request = std::move(request);
+}
+
+void LlamaAdapter::step(llama_batch& batch, int32_t capacity) {
+    // 解码中的 slot 每轮一个 token（推测解码时再加草稿），先放入；剩余容量按顺序分给预填充
+    batch.n_tokens = 0;
+    auto add = [&](Slot& slot, int32_t count) {
+        for (int32_t i = 0; i < count; ++i) {
+            const int32_t n = batch.n_tokens++;
+            batch.token[n] = slot.pending[slot.pending_pos];
+            batch.pos[n] = static_cast<llama_pos>(slot.cached.size());
+            batch.n_seq_id[n] = 1;
+            batch.seq_id[n][0] = slot.seq_id;
+            batch.logits[n] = false;
+            slot.cached.push_back(slot.pending[slot.pending_pos++]);
+        }
+        if (slot.pending_pos == slot.pending.size()) {
+            batch.logits[batch.n_tokens - 1] = true; // 只有 prompt 的最后一个 token 需要 logits
+            slot.logits_index = batch.n_tokens - 1;
+        }
+    };
+    int32_t decoding = 0;
+    for (auto& slot : slots_) {
+        slot.logits_index = -1;
+        if (slot.request && !slot.prefilling) ++decoding;
+    }
+    for (auto& slot : slots_) {
+        if (!slot.request || slot.prefilling || batch.n_tokens >= capacity) continue;
+        --decoding;
+        // 窗口已满：平移后继续；无法平移则按长度上限结束
+        if (slot.cached.size() >= n_ctx_seq_ && !shift_context(slot)) {
+            finish(slot);
+            continue;
+        }
+        if (draft_ctx_) {
+            // 草稿不超出窗口、剩余生成长度和本轮容量（给后面的解码 slot 各留一个位置）
+            const auto remaining = static_cast<size_t>(std::max(0, slot.request->sampling.n_predict - slot.n_generated - 1));
+            const size_t spare = static_cast<size_t>(std::max(0, capacity - batch.n_tokens - 1 - decoding));
+            draft_for(slot, std::min({static_cast<size_t>(config_.n_draft), n_ctx_seq_ - slot.cached.size() - 1,
+                                      remaining, spare}));
+        }
+        add(slot, 1);
+        // 草稿 token 紧随其后，每个位置都要 logits 用于验证
+        for (llama_token token : slot.draft) {
+            const int32_t n = batch.n_tokens++;
+            batch.token[n] = token;
+            batch.pos[n] = static_cast<llama_pos>(slot.cached.size());
+            batch.n_seq_id[n] = 1;
+            batch.seq_id[n][0] = slot.seq_id;
+            batch.logits[n] = true;
+            slot.cached.push_back(token);
+        }
+    }
+    for (auto& slot : slots_) {
+        if (!slot.request || !slot.prefilling || batch.n_tokens >= capacity) continue;
+        const auto remaining = static_cast<int32_t>(slot.pending.size() - slot.pending_pos);
+        add(slot, std::min(remaining, capacity - batch.n_tokens));
+    }
+    if (batch.n_tokens == 0) return;
 
-    // Decode prompt
     if (llama_decode(ctx_.get(), batch)) {
-        throw std::runtime_error("Prompt evaluation failed");
+        // 批次整体失败（通常是 KV 缓存已满）：丢弃这些序列的缓存，预填充中的请求报错，解码中的返回已有输出
+        llama_memory_t memory = llama_get_memory(ctx_.get());
+        for (auto& slot : slots_) {
+            if (!slot.request) continue;
+            llama_memory_seq_rm(memory, slot.seq_id, -1, -1);
+            slot.cached.clear();
+            slot.draft.clear();
+            if (slot.prefilling) {
+                fail(slot, std::make_exception_ptr(std::runtime_error("Prompt evaluation failed")));
+            } else {
+                finish(slot);
+            }
+        }
+        return;
     }
 
-    std::string response;
-    for (int i = 0; i < config_.n_predict; ++i) {
-        llama_token new_token = llama_sampler_sample(sampler_.get(), ctx_.get(), -1);
+    llama_memory_t memory = llama_get_memory(ctx_.get());
+    for (auto& slot : slots_) {
+        if (!slot.request || slot.logits_index < 0) continue;
+        slot.prefilling = false;
 
-        if (llama_vocab_is_eog(llama_model_get_vocab(model_.get()), new_token)) {
-            break;
+        if (slot.n_generated >= slot.request->sampling.n_predict) {
+            finish(slot);
+            continue;
         }
 
-        std::string piece = detokenize(new_token);
-        response += piece;
+        // 依次在每个位置用主模型的采样链采样：与草稿一致则接受并继续，否则该采样结果即为本轮最后一个 token。
+        // 输出的每个 token 都来自主模型在正确前缀下的采样，与不推测时同分布
+        llama_token new_token = 0;
+        std::vector<llama_token> sampled;
+        bool active = true;
+        for (size_t i = 0;; ++i) {
+            new_token = llama_sampler_sample(slot.sampler.get(), ctx_.get(), slot.logits_index + static_cast<int32_t>(i));
+            if (!accept_token(slot, new_token)) {
+                active = false;
+                break;
+            }
+            sampled.push_back(new_token);
+            if (i == slot.draft.size() || new_token != slot.draft[i]) break;
+        }
+
+        if (!slot.draft.empty()) {
+            // 丢弃未被接受的草稿在 KV 中的位置；草稿模型的 KV 在下一次 draft_for 时按公共前缀同步
+            const DraftVerdict verdict = verify_draft(slot.cached.size(), slot.draft, sampled);
+            drafted_tokens_ += slot.draft.size();
+            accepted_tokens_ += verdict.accepted;
+            llama_memory_seq_rm(memory, slot.seq_id, static_cast<llama_pos>(verdict.keep), -1);
+            slot.cached.resize(verdict.keep);
+            slot.draft.clear();
+        }
+        if (!active) continue;
 
         // Prepare next token
-        batch = llama_batch_get_one(&new_token, 1);
-        if (llama_decode(ctx_.get(), batch)) {
-            break;
+        slot.pending.assign(1, new_token);
+        slot.pending_pos = 0;
+    }
+}
+
+LlamaAdapter::DraftVerdict LlamaAdapter::verify_draft(size_t n_cached, const std::vector<llama_token>& draft,
+                                                      const std::vector<llama_token>& sampled) {
+    DraftVerdict verdict;
+    while (verdict.accepted < draft.size() && verdict.accepted < sampled.size() &&
+           sampled[verdict.accepted] == draft[verdict.accepted]) {
+        ++verdict.accepted;
+    }
+    verdict.keep = n_cached - (draft.size() - verdict.accepted);
+    return verdict;
+}
+
+bool LlamaAdapter::accept_token(Slot& slot, llama_token token) {
+    ++slot.n_generated;
+    if (llama_vocab_is_eog(llama_model_get_vocab(model_.get()), token)) {
+        finish(slot);
+        return false;
+    }
+
+    std::string piece = detokenize(token);
+    slot.response += piece;
+
+    bool keep_going = true;
+    if (slot.request->on_token) {
+        try {
+            keep_going = slot.request->on_token(piece);
+        } catch (...) {
+            fail(slot, std::current_exception());
+            return false;
+        }
+    }
+    if (!keep_going || slot.n_generated >= slot.request->sampling.n_predict) {
+        finish(slot);
+        return false;
+    }
+    return true;
+}
+
+void LlamaAdapter::draft_for(Slot& slot, size_t max_tokens) {
+    slot.draft.clear();
+    if (max_tokens == 0) return;
+
+    // 草稿 KV 追上主序列（含待解码的 token）：复用公共前缀，其余按批补齐；只有最后一个 token 需要 logits
+    std::vector<llama_token> target = slot.cached;
+    target.push_back(slot.pending[slot.pending_pos]);
+    llama_memory_t memory = llama_get_memory(draft_ctx_.get());
+    size_t prefix = reusable_prefix(slot.draft_cached, target);
+    if (!llama_memory_seq_rm(memory, slot.seq_id, static_cast<llama_pos>(prefix), -1)) {
+        llama_memory_seq_rm(memory, slot.seq_id, -1, -1);
+        prefix = 0;
+    }
+    slot.draft_cached.resize(prefix);
+
+    const auto capacity = static_cast<size_t>(llama_n_batch(draft_ctx_.get()));
+    auto decode = [&](const llama_token* tokens, size_t count) {
+        draft_batch_.n_tokens = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const int32_t n = draft_batch_.n_tokens++;
+            draft_batch_.token[n] = tokens[i];
+            draft_batch_.pos[n] = static_cast<llama_pos>(slot.draft_cached.size());
+            draft_batch_.n_seq_id[n] = 1;
+            draft_batch_.seq_id[n][0] = slot.seq_id;
+            draft_batch_.logits[n] = (i + 1 == count);
+            slot.draft_cached.push_back(tokens[i]);
+        }
+        if (llama_decode(draft_ctx_.get(), draft_batch_) == 0) return true;
+        llama_memory_seq_rm(memory, slot.seq_id, -1, -1);
+        slot.draft_cached.clear();
+        return false;
+    };
+    for (size_t pos = prefix; pos < target.size(); pos += capacity) {
+        if (!decode(target.data() + pos, std::min(capacity, target.size() - pos))) return;
+    }
+
+    // 最后一个草稿 token 不必解码，下一轮同步时按需补上
+    while (true) {
+        llama_token token = llama_sampler_sample(draft_sampler_.get(), draft_ctx_.get(), draft_batch_.n_tokens - 1);
+        if (llama_vocab_is_eog(llama_model_get_vocab(model_.get()), token)) return;
+        slot.draft.push_back(token);
+        if (slot.draft.size() == max_tokens || !decode(&token, 1)) return;
+    }
+}
+
+bool LlamaAdapter::shift_context(Slot& slot) {
+    llama_memory_t memory = llama_get_memory(ctx_.get());
+    if (!config_.context_shift || !llama_memory_can_shift(memory)) return false;
+
+    const size_t n_keep = keep_tokens();
+    const size_t n_discard = (slot.cached.size() - n_keep) / 2;
+    const auto first = static_cast<llama_pos>(n_keep);
+    const auto last = static_cast<llama_pos>(n_keep + n_discard);
+    if (n_discard == 0 || !llama_memory_seq_rm(memory, slot.seq_id, first, last)) return false;
+    llama_memory_seq_add(memory, slot.seq_id, last, static_cast<llama_pos>(slot.cached.size()),
+                         -static_cast<llama_pos>(n_discard));
+    slot.cached.erase(slot.cached.begin() + first, slot.cached.begin() + last);
+
+    // 草稿序列做同样的平移；做不到就清空，下次起草时重新同步
+    if (draft_ctx_) {
+        llama_memory_t draft_memory = llama_get_memory(draft_ctx_.get());
+        if (slot.draft_cached.size() >= n_keep + n_discard && llama_memory_can_shift(draft_memory) &&
+            llama_memory_seq_rm(draft_memory, slot.seq_id, first, last)) {
+            llama_memory_seq_add(draft_memory, slot.seq_id, last, static_cast<llama_pos>(slot.draft_cached.size()),
+                                 -static_cast<llama_pos>(n_discard));
+            slot.draft_cached.erase(slot.draft_cached.begin() + first, slot.draft_cached.begin() + last);
+        } else {
+            llama_memory_seq_rm(draft_memory, slot.seq_id, -1, -1);
+            slot.draft_cached.clear();
         }
     }
+    return true;
+}
 
+void LlamaAdapter::finish(Slot& slot) {
     // Reset sampler state for next call
-    llama_sampler_reset(sampler_.get());
+    llama_sampler_reset(slot.sampler.get());
+    slot.request->promise.set_value(std::move(slot.response));
+    slot.request.reset();
+    slot.response.clear();
+    slot.pending.clear();
+}
 
-    return response;
+void LlamaAdapter::fail(Slot& slot, std::exception_ptr error) {
+    llama_sampler_reset(slot.sampler.get());
+    slot.request->promise.set_exception(std::move(error));
+    slot.request.reset();
+    slot.response.clear();
+    slot.pending.clear();
 }
 
 bool LlamaAdapter::is_loaded() const {
-    return model_ != nullptr && ctx_ != nullptr && sampler_ != nullptr;
+    return model_ != nullptr && ctx_ != nullptr && !slots_.empty();
 }
 
 } // namespace agenticdsl
@@ -2,8 +2,17 @@
 #define AGENTICDSL_LLM_LLAMA_ADAPTER_H
 
 //#include "common/types.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <string>
+#include <string_view>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <vector>
 #include <llama.h>
 
@@ -11,31 +20,153 @@ namespace agenticdsl {
 
 
 
+// 进程内批处理推理服务：多个请求各占一个序列（slot），共享同一 llama_context；
+// 后台线程每轮把所有活跃请求的预填充与解码 token 拼进一次 llama_decode
 class LlamaAdapter {
 public:
     struct Config {
         std::string model_path;
-        int n_ctx = 2048;
+        int n_ctx = 2048;      // 所有 slot 共享的 KV 容量，按 n_parallel 均分
         int n_threads = 4;
         float temperature = 0.7f;
         float min_p = 0.05f;
         int n_predict = 512;
+        int n_parallel = 1;    // 同时解码的请求数（序列数）；调大时应同比调大 n_ctx，否则每个请求的窗口变小
+        int n_batch = 512;     // 每轮 llama_decode 的 token 上限；长 prompt 按此分块预填充
+        int n_ubatch = 512;    // 一次前向计算的物理批大小（不超过 n_batch）
+        int n_keep = -1;       // 截断与平移时保留的开头 token 数（如系统提示）；-1 = 半个窗口，BOS 总是保留
+        bool context_shift = true; // 序列写满窗口时丢弃较早的一半继续生成；否则直接结束
+        std::string draft_model_path; // 推测解码的草稿模型（与主模型同词表）；空 = 不启用
+        int n_draft = 4;       // 每轮草稿 token 数
     };
 
+    // 单次请求的采样参数；只影响采样链，不重新加载模型或 context
+    struct SamplingParams {
+        float temperature = 0.7f; // <= 0 时贪心解码
+        float top_p = 1.0f;       // 1 = 不截断
+        int top_k = 0;            // 0 = 不限
+        float min_p = 0.05f;
+        int n_predict = 512;
+        uint32_t seed = LLAMA_DEFAULT_SEED; // 固定种子可复现；默认随机
+        std::string grammar;      // GBNF（根规则 root）；非空时只采样语法允许的 token
+
+        bool operator==(const SamplingParams&) const = default;
+    };
+    SamplingParams default_sampling() const; // 由构造时的 Config 得到
+
+    // 模型权重经 ModelRegistry 在进程内共享；每个 adapter 只独占自己的 llama_context
     explicit LlamaAdapter(const Config& config);
     ~LlamaAdapter();
 
+    // 每解码出一段文本回调一次；返回 false 时提前停止生成。
+    // 回调在推理线程上执行，期间会阻塞同批其他请求，应尽快返回
+    using TokenCallback = std::function<bool(std::string_view piece)>;
+
+    // 异步提交；结果（或异常）通过 future 返回
+    std::future<std::string> submit(const std::string& prompt, TokenCallback on_token = nullptr,
+                                    std::optional<SamplingParams> sampling = std::nullopt);
+
     std::string generate(const std::string& prompt);
+    std::string generate(const std::string& prompt, const TokenCallback& on_token);
+    std::string generate(const std::string& prompt, const TokenCallback& on_token, const SamplingParams& sampling);
     bool is_loaded() const;
 
+    // 最近一次分配 slot 时从 KV 缓存复用的 prompt token 数
+    size_t last_reused_tokens() const { return last_reused_tokens_.load(); }
+
+    // 推测解码：草稿模型逐个提出 token，主模型一次 decode 验证；接受率 = accepted / drafted
+    bool speculative() const { return draft_ctx_ != nullptr; }
+    size_t drafted_tokens() const { return drafted_tokens_.load(); }
+    size_t accepted_tokens() const { return accepted_tokens_.load(); }
+
+    // cached 与 prompt 的公共前缀长度；至少留一个 token 重新解码，以便得到最后位置的 logits
+    static size_t reusable_prefix(const std::vector<llama_token>& cached, const std::vector<llama_token>& prompt);
+
+    // 每个序列可用的 KV 窗口（n_ctx 由各 slot 均分）
+    size_t context_window() const { return n_ctx_seq_; }
+    static size_t sequence_window(uint32_t n_ctx, int n_parallel);
+
+    // 空闲 slot（caches 中非空指针）里与 prompt 可复用前缀最长的一个，同长取靠前者；全忙时返回 -1
+    static int choose_slot(const std::vector<const std::vector<llama_token>*>& caches, const std::vector<llama_token>& prompt);
+
+    // prompt 不短于 window 时保留开头 n_keep 个 token 与末尾约半个窗口，丢弃中间部分
+    static void truncate_prompt(std::vector<llama_token>& tokens, size_t window, size_t n_keep);
+    // Config::n_keep 对应的保留数：负数取半个窗口，其余限制在 [1, window / 2]
+    static size_t keep_tokens(int n_keep, size_t window);
+
+    // 推测解码一轮验证后的记账。n_cached 为主序列 KV 长度（末尾是本轮送入的 draft），
+    // sampled 为主模型依次采样并被接受的 token（遇到不一致或生成结束即止）。
+    // accepted 为与草稿一致的前缀长度；主序列 KV 保留 [0, keep)，[keep, 末尾) 由 seq_rm 丢弃
+    struct DraftVerdict {
+        size_t accepted = 0;
+        size_t keep = 0;
+    };
+    static DraftVerdict verify_draft(size_t n_cached, const std::vector<llama_token>& draft,
+                                     const std::vector<llama_token>& sampled);
+
 private:
+    struct Request {
+        std::vector<llama_token> tokens;
+        TokenCallback on_token;
+        SamplingParams sampling;
+        std::promise<std::string> promise;
+    };
+
+    // 一个序列：KV 缓存内容跨请求保留，新请求优先分给前缀最长的空闲 slot
+    struct Slot {
+        llama_seq_id seq_id = 0;
+        std::unique_ptr<llama_sampler, decltype(&llama_sampler_free)> sampler{nullptr, llama_sampler_free};
+        SamplingParams sampling; // sampler 对应的参数；新请求参数不同时才重建
+        std::vector<llama_token> cached;  // 与该序列的 KV 缓存内容一一对应
+        std::unique_ptr<Request> request; // 为空表示空闲
+        std::vector<llama_token> pending; // 待解码：prompt 剩余部分，或上一步采样出的 token
+        size_t pending_pos = 0;
+        bool prefilling = false;
+        int32_t logits_index = -1; // 本轮 batch 中需要采样的位置（有草稿时为第一个，其后依次对应各草稿 token）
+        std::vector<llama_token> draft;        // 本轮待主模型验证的草稿 token
+        std::vector<llama_token> draft_cached; // 与草稿模型中该序列的 KV 缓存一一对应
+        int n_generated = 0;
+        std::string response;
+    };
+
     Config config_;
-    std::unique_ptr<llama_model, decltype(&llama_model_free)> model_;
+    std::shared_ptr<llama_model> model_; // 来自 ModelRegistry，与其他 adapter 共享
     std::unique_ptr<llama_context, decltype(&llama_free)> ctx_;
-    std::unique_ptr<llama_sampler, decltype(&llama_sampler_free)> sampler_;
+    std::vector<Slot> slots_;
+    size_t n_ctx_seq_ = 0;
+
+    // 草稿模型只在推理线程上使用
+    std::shared_ptr<llama_model> draft_model_;
+    std::unique_ptr<llama_context, decltype(&llama_free)> draft_ctx_{nullptr, llama_free};
+    std::unique_ptr<llama_sampler, decltype(&llama_sampler_free)> draft_sampler_{nullptr, llama_sampler_free};
+    llama_batch draft_batch_{};
+    std::atomic<size_t> drafted_tokens_{0};
+    std::atomic<size_t> accepted_tokens_{0};
 
+    std::mutex mutex_; // 保护 queue_ 与 stop_
+    std::condition_variable cv_;
+    std::deque<std::unique_ptr<Request>> queue_;
+    bool stop_ = false;
+    std::thread worker_;
+    std::atomic<size_t> last_reused_tokens_{0};
+
+    // 语法无法解析时返回 nullptr
+    llama_sampler* make_sampler(const SamplingParams& sampling) const;
     std::vector<llama_token> tokenize(const std::string& text, bool add_bos);
     std::string detokenize(llama_token token);
+
+    void run();                        // 推理线程主循环
+    void assign(std::unique_ptr<Request> request); // 把请求放进一个空闲 slot
+    bool has_free_slot() const;
+    bool has_active_slot() const;
+    void step(llama_batch& batch, int32_t capacity); // 组一批、解码一次、为完成预填充的 slot 采样
+    size_t keep_tokens() const;        // 平移与截断时保留的开头 token 数（至少 1，即 BOS）
+    bool shift_context(Slot& slot);    // 丢弃 n_keep 之后较早的一半缓存；不支持平移时返回 false
+    void init_draft();                 // 加载草稿模型；失败时告警并关闭推测解码
+    void draft_for(Slot& slot, size_t max_tokens); // 同步草稿 KV 后贪心生成最多 max_tokens 个草稿
+    bool accept_token(Slot& slot, llama_token token); // 输出一个采样结果；请求结束时返回 false
+    void finish(Slot& slot);
+    void fail(Slot& slot, std::exception_ptr error);
 };
 
 } // namespace agenticdsl
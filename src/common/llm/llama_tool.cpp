@@ -1,4 +1,5 @@
 #include "common/llm/llama_tool.h"
+#include <filesystem>
 #include <stdexcept>
 
 namespace agenticdsl {
@@ -9,48 +10,58 @@ LlamaTool::LlamaTool(const LlamaAdapter::Config& config)
 
 LlamaTool::~LlamaTool() = default;
 
-LlamaAdapter::Config LlamaTool::convert_params(const LLMParams& params) const {
-    LlamaAdapter::Config config = config_;
+LlamaAdapter::SamplingParams LlamaTool::sampling_for(const LLMParams& params,
+                                                    const LlamaAdapter::SamplingParams& defaults) {
+    LlamaAdapter::SamplingParams sampling = defaults;
     
-    if (params.temperature > 0.0f) {
-        config.temperature = params.temperature;
-    }
+    sampling.temperature = params.temperature > 0.0f ? params.temperature : 0.0f; // <= 0 = 贪心
     if (params.max_tokens > 0) {
-        config.n_predict = params.max_tokens;
+        sampling.n_predict = params.max_tokens;
     }
     if (params.top_p > 0.0f && params.top_p < 1.0f) {
-        config.min_p = 1.0f - params.top_p;
+        sampling.top_p = params.top_p;
     }
-    if (params.n_ctx > 0) {
-        config.n_ctx = params.n_ctx;
+    if (params.top_k > 0) {
+        sampling.top_k = params.top_k;
     }
-    if (params.n_threads > 0) {
-        config.n_threads = params.n_threads;
+    if (params.min_p >= 0.0f) {
+        sampling.min_p = params.min_p;
     }
-    if (!params.model.empty()) {
-        config.model_path = params.model;
+    if (params.seed >= 0) {
+        sampling.seed = static_cast<uint32_t>(params.seed);
     }
+    sampling.grammar = params.grammar;
     
-    return config;
+    return sampling;
 }
 
 LLMResult LlamaTool::generate(const std::string& prompt, const LLMParams& params) {
+    return generate_stream(prompt, nullptr, params);
+}
+
+LLMResult LlamaTool::generate_stream(const std::string& prompt, const StreamCallback& on_chunk, const LLMParams& params) {
     LLMResult result;
     
     try {
-        LlamaAdapter::Config run_config = convert_params(params);
-        
         if (!adapter_ || !adapter_->is_loaded()) {
             result.success = false;
             result.error = "LLM model not loaded";
             return result;
         }
         
-        std::string text = adapter_->generate(prompt);
+        int pieces = 0;
+        std::string text = adapter_->generate(prompt, [&](std::string_view piece) {
+            ++pieces; // 每个 token 回调一次
+            if (on_chunk && !on_chunk(piece)) {
+                result.stopped = true;
+                return false;
+            }
+            return true;
+        }, sampling_for(params, adapter_->default_sampling()));
         
         result.success = true;
-        result.text = text;
-        result.tokens_generated = static_cast<int>(text.length() / 4);
+        result.text = std::move(text);
+        result.tokens_generated = pieces;
     } catch (const std::exception& e) {
         result.success = false;
         result.error = e.what();
@@ -67,4 +78,17 @@ std::string LlamaTool::name() const {
     return "llama";
 }
 
+std::string LlamaTool::model_id(const std::string& model_path) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path path = fs::weakly_canonical(fs::absolute(model_path, ec), ec);
+    if (ec) path = model_path;
+    std::string id = path.generic_string();
+    const auto size = fs::file_size(path, ec);
+    if (ec) return id;
+    const auto mtime = fs::last_write_time(path, ec);
+    if (ec) return id;
+    return id + "|" + std::to_string(size) + "|" + std::to_string(mtime.time_since_epoch().count());
+}
+
 } // namespace agenticdsl
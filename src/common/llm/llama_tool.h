@@ -15,14 +15,23 @@ public:
     ~LlamaTool() override;
     
     LLMResult generate(const std::string& prompt, const LLMParams& params = {}) override;
+    // 逐 token 回调（在 LlamaAdapter 的推理线程上执行）
+    LLMResult generate_stream(const std::string& prompt, const StreamCallback& on_chunk, const LLMParams& params = {}) override;
     bool is_available() const override;
     std::string name() const override;
+
+    // 模型文件的标识（规范路径 + 大小 + 修改时间），供 CachingLLMTool 区分不同模型；文件不存在时只含路径
+    std::string model_id() const { return model_id(config_.model_path); }
+    static std::string model_id(const std::string& model_path);
+
+    // 把单次调用的 LLMParams 叠加到 adapter 默认采样参数上；未设置的字段沿用 defaults。
+    // 采样相关参数逐次生效；n_ctx / n_threads / model 属于 context，只在构造时使用
+    static LlamaAdapter::SamplingParams sampling_for(const LLMParams& params,
+                                                     const LlamaAdapter::SamplingParams& defaults);
     
 private:
     LlamaAdapter::Config config_;
     std::unique_ptr<LlamaAdapter> adapter_;
-    
-    LlamaAdapter::Config convert_params(const LLMParams& params) const;
 };
 
 } // namespace agenticdsl
@@ -1,7 +1,10 @@
 #ifndef AGENTICDSL_LLM_LLM_TOOL_H
 #define AGENTICDSL_LLM_LLM_TOOL_H
 
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <nlohmann/json.hpp>
 
 namespace agenticdsl {
@@ -9,10 +12,14 @@ namespace agenticdsl {
 struct LLMParams {
     float temperature = 0.7f;
     int max_tokens = 512;
-    float top_p = 0.95f;
+    float top_p = 1.0f; // 1 = 不截断
+    int top_k = 0;      // 0 = 不限
+    float min_p = -1.0f; // < 0 = 沿用后端默认值（LlamaAdapter::Config::min_p）
+    int64_t seed = -1;  // >= 0 时固定采样种子，结果可复现
     int n_ctx = 2048;
     int n_threads = 4;
     std::string model;
+    std::string grammar; // GBNF 约束输出格式；空 = 不约束
 };
 
 struct LLMResult {
@@ -20,13 +27,25 @@ struct LLMResult {
     std::string text;
     std::string error;
     int tokens_generated = 0;
+    bool stopped = false; // 流式回调要求提前停止
 };
 
 class ILLMTool {
 public:
+    // 每解码出一段文本回调一次；返回 false 时提前停止生成
+    using StreamCallback = std::function<bool(std::string_view chunk)>;
+
     virtual ~ILLMTool() = default;
     
     virtual LLMResult generate(const std::string& prompt, const LLMParams& params = {}) = 0;
+    // 流式生成。默认实现在生成结束后把全文作为一个块回调；能增量解码的工具应覆盖
+    virtual LLMResult generate_stream(const std::string& prompt, const StreamCallback& on_chunk, const LLMParams& params = {}) {
+        LLMResult result = generate(prompt, params);
+        if (result.success && on_chunk && !result.text.empty()) {
+            result.stopped = !on_chunk(result.text);
+        }
+        return result;
+    }
     virtual bool is_available() const = 0;
     virtual std::string name() const = 0;
 };
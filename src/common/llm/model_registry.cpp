@@ -0,0 +1,47 @@
+#include "model_registry.h"
+#include <filesystem>
+
+namespace agenticdsl {
+
+ModelRegistry& ModelRegistry::instance() {
+    static ModelRegistry registry;
+    return registry;
+}
+
+std::shared_ptr<llama_model> ModelRegistry::acquire(const std::string& model_path, int n_gpu_layers) {
+    std::error_code ec;
+    auto canonical = std::filesystem::weakly_canonical(std::filesystem::absolute(model_path), ec);
+    const std::string key = (ec ? model_path : canonical.string()) + "#" + std::to_string(n_gpu_layers);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto model = models_[key].lock()) {
+        return model;
+    }
+
+    llama_model_params model_params = llama_model_default_params();
+    model_params.n_gpu_layers = n_gpu_layers;
+    llama_model* raw_model = llama_model_load_from_file(model_path.c_str(), model_params);
+    if (!raw_model) {
+        models_.erase(key);
+        return nullptr;
+    }
+    std::shared_ptr<llama_model> model(raw_model, llama_model_free);
+    models_[key] = model;
+    return model;
+}
+
+size_t ModelRegistry::loaded_count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (auto it = models_.begin(); it != models_.end();) {
+        if (it->second.expired()) {
+            it = models_.erase(it);
+        } else {
+            ++count;
+            ++it;
+        }
+    }
+    return count;
+}
+
+} // namespace agenticdsl
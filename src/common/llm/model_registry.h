@@ -0,0 +1,33 @@
+#ifndef AGENTICDSL_LLM_MODEL_REGISTRY_H
+#define AGENTICDSL_LLM_MODEL_REGISTRY_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <llama.h>
+
+namespace agenticdsl {
+
+// 进程内共享的模型权重：同一 GGUF 文件只加载一次，各 LlamaAdapter 只创建自己的 llama_context。
+// 最后一个持有者释放后模型随之卸载
+class ModelRegistry {
+public:
+    static ModelRegistry& instance();
+
+    // 加载失败返回 nullptr
+    std::shared_ptr<llama_model> acquire(const std::string& model_path, int n_gpu_layers = 99);
+
+    // 当前仍被持有的模型数
+    size_t loaded_count();
+
+private:
+    ModelRegistry() = default;
+
+    std::mutex mutex_; // 加载期间持有，避免并发加载同一模型
+    std::unordered_map<std::string, std::weak_ptr<llama_model>> models_; // 规范化路径 + GPU 层数 -> 模型
+};
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_LLM_MODEL_REGISTRY_H
@@ -103,7 +103,8 @@ const LLMParams& ToolRegistry::get_llm_params(const std::string& name) const {
     return it->second.default_params;
 }
 
-nlohmann::json ToolRegistry::call_llm_tool(const std::string& name, const std::string& prompt, const LLMParams& params) {
+nlohmann::json ToolRegistry::call_llm_tool(const std::string& name, const std::string& prompt, const LLMParams& params,
+                                           const ILLMTool::StreamCallback& on_chunk) {
     auto it = llm_tools_.find(name);
     if (it == llm_tools_.end()) {
         return nlohmann::json{{"error", "LLM tool not found: " + name}};
@@ -114,18 +115,24 @@ nlohmann::json ToolRegistry::call_llm_tool(const std::string& name, const std::s
         LLMParams merged_params = it->second.default_params;
         if (params.temperature != 0.7f) merged_params.temperature = params.temperature;
         if (params.max_tokens != 512) merged_params.max_tokens = params.max_tokens;
-        if (params.top_p != 0.95f) merged_params.top_p = params.top_p;
+        if (params.top_p != 1.0f) merged_params.top_p = params.top_p;
+        if (params.top_k != 0) merged_params.top_k = params.top_k;
+        if (params.min_p >= 0.0f) merged_params.min_p = params.min_p;
+        if (params.seed >= 0) merged_params.seed = params.seed;
         if (params.n_ctx != 2048) merged_params.n_ctx = params.n_ctx;
         if (params.n_threads != 4) merged_params.n_threads = params.n_threads;
         if (!params.model.empty()) merged_params.model = params.model;
+        if (!params.grammar.empty()) merged_params.grammar = params.grammar;
 
-        auto result = it->second.tool->generate(prompt, merged_params);
+        auto result = on_chunk ? it->second.tool->generate_stream(prompt, on_chunk, merged_params)
+                               : it->second.tool->generate(prompt, merged_params);
 
         nlohmann::json json_result;
         json_result["success"] = result.success;
         if (result.success) {
             json_result["text"] = result.text;
             json_result["tokens_generated"] = result.tokens_generated;
+            if (result.stopped) json_result["stopped"] = true;
         } else {
             json_result["error"] = result.error;
         }
@@ -30,7 +30,9 @@ public:
     void register_llm_tool(std::string name, std::unique_ptr<ILLMTool> tool, const LLMParams& default_params = {});
     bool is_llm_tool(const std::string& name) const;
     const LLMParams& get_llm_params(const std::string& name) const;
-    nlohmann::json call_llm_tool(const std::string& name, const std::string& prompt, const LLMParams& params = {});
+    // on_chunk 非空时流式调用，边生成边回调；返回 false 提前停止（结果中 stopped 为 true）
+    nlohmann::json call_llm_tool(const std::string& name, const std::string& prompt, const LLMParams& params = {},
+                                 const ILLMTool::StreamCallback& on_chunk = nullptr);
 
 private:
     void register_default_tools();
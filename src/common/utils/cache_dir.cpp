@@ -0,0 +1,47 @@
+// common/utils/cache_dir.cpp
+#include "cache_dir.h"
+#include <cerrno>
+#include <cstdlib>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace agenticdsl {
+
+std::filesystem::path user_cache_directory(const std::string& name) {
+    std::filesystem::path base;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg == '/') {
+        base = xdg; // XDG 规范：相对路径无效，忽略
+    } else if (const char* home = std::getenv("HOME"); home && *home) {
+        base = std::filesystem::path(home) / ".cache";
+    } else {
+#if defined(_WIN32)
+        if (const char* local = std::getenv("LOCALAPPDATA"); local && *local) return std::filesystem::path(local) / name;
+#endif
+        return {};
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(base, ec);
+    const auto dir = base / name;
+#if !defined(_WIN32)
+    if (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) return {};
+
+    struct stat st {};
+    if (::lstat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != ::geteuid()) {
+        return {};
+    }
+    // 自己的目录但权限过宽（如旧版本创建的）：收紧后继续使用
+    if ((st.st_mode & 077) != 0 && ::chmod(dir.c_str(), 0700) != 0) {
+        return {};
+    }
+#else
+    std::filesystem::create_directories(dir, ec);
+    if (ec) return {};
+#endif
+    return dir;
+}
+
+} // namespace agenticdsl
@@ -0,0 +1,16 @@
+#ifndef AGENTICDSL_COMMON_UTILS_CACHE_DIR_H
+#define AGENTICDSL_COMMON_UTILS_CACHE_DIR_H
+
+#include <filesystem>
+#include <string>
+
+namespace agenticdsl {
+
+// 当前用户的缓存目录 <$XDG_CACHE_HOME 或 ~/.cache>/<name>，不存在时以 0700 创建。
+// 缓存条目会被直接信任并执行，因此目录必须只有当前用户可写：
+// 目录不属于当前用户、是符号链接或无法确定主目录时返回空路径，调用方应停用缓存
+std::filesystem::path user_cache_directory(const std::string& name);
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_COMMON_UTILS_CACHE_DIR_H
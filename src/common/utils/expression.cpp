@@ -0,0 +1,358 @@
+// common/utils/expression.cpp
+#include "expression.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace agenticdsl {
+
+namespace {
+
+// 表达式超出支持子集（或有语法错误）时抛出，由 compile 转为 std::nullopt
+struct Unsupported {};
+
+bool is_ident_start(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool is_ident_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+const char* op_symbol(int op_index) {
+    static const char* symbols[] = {"", "", "not", "-", "+", "-", "*", "/", "%", "^",
+                                    "==", "!=", "<", "<=", ">", ">=", "and", "or"};
+    return symbols[op_index];
+}
+
+} // namespace
+
+// 递归下降解析，优先级与 Inja 的运算符表一致，从低到高：
+// and / or（同级，左结合）< 比较 < + - < * / %、not、一元负号 < ^（右结合）
+// 因此 a or b and c 即 (a or b) and c，not a == b 即 (not a) == b
+class ExpressionParser {
+public:
+    ExpressionParser(std::string_view src, Expression& out) : src_(src), out_(out) {}
+
+    int parse() {
+        int root = parse_logical();
+        skip_ws();
+        if (pos_ != src_.size()) throw Unsupported{}; // 过滤器、函数调用等剩余内容
+        return root;
+    }
+
+private:
+    using Op = Expression::Op;
+
+    int add_node(Expression::Node node) {
+        out_.nodes_.push_back(std::move(node));
+        return static_cast<int>(out_.nodes_.size() - 1);
+    }
+
+    int binary(Op op, int lhs, int rhs) {
+        Expression::Node node;
+        node.op = op;
+        node.lhs = lhs;
+        node.rhs = rhs;
+        return add_node(std::move(node));
+    }
+
+    void skip_ws() {
+        while (pos_ < src_.size() && std::isspace(static_cast<unsigned char>(src_[pos_]))) ++pos_;
+    }
+
+    bool match(std::string_view token) {
+        skip_ws();
+        if (src_.substr(pos_, token.size()) != token) return false;
+        pos_ += token.size();
+        return true;
+    }
+
+    bool match_keyword(std::string_view word) {
+        skip_ws();
+        if (src_.substr(pos_, word.size()) != word) return false;
+        size_t end = pos_ + word.size();
+        if (end < src_.size() && is_ident_char(src_[end])) return false;
+        pos_ = end;
+        return true;
+    }
+
+    int parse_logical() {
+        int lhs = parse_comparison();
+        while (true) {
+            if (match_keyword("and")) lhs = binary(Op::And, lhs, parse_comparison());
+            else if (match_keyword("or")) lhs = binary(Op::Or, lhs, parse_comparison());
+            else return lhs;
+        }
+    }
+
+    int parse_comparison() {
+        int lhs = parse_additive();
+        while (true) {
+            // 先匹配双字符运算符
+            if (match("==")) lhs = binary(Op::Eq, lhs, parse_additive());
+            else if (match("!=")) lhs = binary(Op::Ne, lhs, parse_additive());
+            else if (match("<=")) lhs = binary(Op::Le, lhs, parse_additive());
+            else if (match(">=")) lhs = binary(Op::Ge, lhs, parse_additive());
+            else if (match("<")) lhs = binary(Op::Lt, lhs, parse_additive());
+            else if (match(">")) lhs = binary(Op::Gt, lhs, parse_additive());
+            else return lhs;
+        }
+    }
+
+    int parse_additive() {
+        int lhs = parse_multiplicative();
+        while (true) {
+            if (match("+")) lhs = binary(Op::Add, lhs, parse_multiplicative());
+            else if (match("-")) lhs = binary(Op::Sub, lhs, parse_multiplicative());
+            else return lhs;
+        }
+    }
+
+    int parse_multiplicative() {
+        int lhs = parse_unary();
+        while (true) {
+            if (match("*")) lhs = binary(Op::Mul, lhs, parse_unary());
+            else if (match("/")) lhs = binary(Op::Div, lhs, parse_unary());
+            else if (match("%")) lhs = binary(Op::Mod, lhs, parse_unary());
+            else return lhs;
+        }
+    }
+
+    // not 与 * / % 同级：只作用于紧随的操作数（含 ^），不吞掉后面的比较
+    int parse_unary() {
+        if (match_keyword("not")) return binary(Op::Not, parse_unary(), -1);
+        if (match("-")) return binary(Op::Neg, parse_unary(), -1);
+        return parse_power();
+    }
+
+    int parse_power() {
+        int base = parse_primary();
+        if (match("^")) return binary(Op::Pow, base, parse_unary()); // 右结合
+        return base;
+    }
+
+    int parse_primary() {
+        skip_ws();
+        if (pos_ >= src_.size()) throw Unsupported{};
+        char c = src_[pos_];
+
+        if (c == '(') {
+            ++pos_;
+            int inner = parse_logical();
+            if (!match(")")) throw Unsupported{};
+            return inner;
+        }
+        if (std::isdigit(static_cast<unsigned char>(c))) return parse_number();
+        if (c == '"') return parse_string();
+
+        if (match_keyword("true")) return literal(true);
+        if (match_keyword("false")) return literal(false);
+        if (match_keyword("null")) return literal(nullptr);
+        if (is_ident_start(c)) return parse_path();
+
+        throw Unsupported{}; // 单引号字符串、数组/对象字面量等
+    }
+
+    int literal(Value value) {
+        Expression::Node node;
+        node.op = Op::Literal;
+        node.literal = std::move(value);
+        return add_node(std::move(node));
+    }
+
+    int parse_number() {
+        size_t start = pos_;
+        bool is_float = false;
+        while (pos_ < src_.size()) {
+            char c = src_[pos_];
+            if (std::isdigit(static_cast<unsigned char>(c))) {
+                ++pos_;
+            } else if (c == '.' || c == 'e' || c == 'E') {
+                is_float = true;
+                ++pos_;
+                if (c != '.' && pos_ < src_.size() && (src_[pos_] == '+' || src_[pos_] == '-')) ++pos_;
+            } else {
+                break;
+            }
+        }
+        const char* first = src_.data() + start;
+        const char* last = src_.data() + pos_;
+        if (is_float) {
+            double value = 0.0;
+            auto [ptr, ec] = std::from_chars(first, last, value);
+            if (ec != std::errc{} || ptr != last) throw Unsupported{};
+            return literal(value);
+        }
+        std::int64_t value = 0;
+        auto [ptr, ec] = std::from_chars(first, last, value);
+        if (ec != std::errc{} || ptr != last) throw Unsupported{};
+        return literal(value);
+    }
+
+    int parse_string() {
+        size_t start = pos_++;
+        while (pos_ < src_.size() && src_[pos_] != '"') {
+            pos_ += (src_[pos_] == '\\') ? 2 : 1;
+        }
+        if (pos_ >= src_.size()) throw Unsupported{};
+        ++pos_;
+        try {
+            return literal(nlohmann::json::parse(src_.substr(start, pos_ - start)));
+        } catch (const nlohmann::json::exception&) {
+            throw Unsupported{};
+        }
+    }
+
+    int parse_path() {
+        std::string pointer;
+        size_t start = pos_;
+        while (true) {
+            size_t seg_start = pos_;
+            while (pos_ < src_.size() && is_ident_char(src_[pos_])) ++pos_;
+            if (pos_ == seg_start) throw Unsupported{};
+            pointer += '/';
+            pointer.append(src_.substr(seg_start, pos_ - seg_start));
+            if (pos_ < src_.size() && src_[pos_] == '.') {
+                ++pos_;
+                continue;
+            }
+            break;
+        }
+        std::string_view name = src_.substr(start, pos_ - start);
+        if (name == "and" || name == "or" || name == "not" || name == "in") throw Unsupported{};
+
+        skip_ws();
+        if (pos_ < src_.size() && src_[pos_] == '(') throw Unsupported{}; // 函数调用交给 Inja
+
+        Expression::Node node;
+        node.op = Op::Path;
+        node.path = nlohmann::json::json_pointer(pointer);
+        node.name = std::string(name);
+        return add_node(std::move(node));
+    }
+
+    std::string_view src_;
+    size_t pos_ = 0;
+    Expression& out_;
+};
+
+std::optional<Expression> Expression::compile(std::string_view source) {
+    Expression expr;
+    expr.source_ = std::string(source);
+    try {
+        expr.root_ = ExpressionParser(expr.source_, expr).parse();
+    } catch (const Unsupported&) {
+        return std::nullopt;
+    }
+    return expr;
+}
+
+bool Expression::is_constant() const {
+    return std::none_of(nodes_.begin(), nodes_.end(), [](const Node& node) { return node.op == Op::Path; });
+}
+
+bool Expression::truthy(const Value& value) {
+    if (value.is_boolean()) return value.get<bool>();
+    if (value.is_number()) return value != 0;
+    if (value.is_null()) return false;
+    return !value.empty();
+}
+
+Value Expression::evaluate(const Context& context) const {
+    return eval(root_, context);
+}
+
+Value Expression::eval(int index, const Context& context) const {
+    const Node& node = nodes_[index];
+    switch (node.op) {
+        case Op::Literal:
+            return node.literal;
+        case Op::Path:
+            if (!context.contains(node.path)) {
+                throw std::runtime_error("variable '" + node.name + "' not found");
+            }
+            return context.at(node.path);
+        case Op::Not:
+            return !truthy(eval(node.lhs, context));
+        case Op::And:
+            return truthy(eval(node.lhs, context)) && truthy(eval(node.rhs, context));
+        case Op::Or:
+            return truthy(eval(node.lhs, context)) || truthy(eval(node.rhs, context));
+        default:
+            break;
+    }
+
+    const char* symbol = op_symbol(static_cast<int>(node.op));
+    if (node.op == Op::Neg) {
+        Value operand = eval(node.lhs, context);
+        if (operand.is_number_integer() && operand.get<std::int64_t>() != std::numeric_limits<std::int64_t>::min()) {
+            return -operand.get<std::int64_t>();
+        }
+        if (operand.is_number()) return -operand.get<double>();
+        throw std::runtime_error(std::string("invalid operand for unary '") + symbol + "'");
+    }
+
+    Value lhs = eval(node.lhs, context);
+    Value rhs = eval(node.rhs, context);
+    switch (node.op) {
+        case Op::Eq: return lhs == rhs;
+        case Op::Ne: return lhs != rhs;
+        case Op::Lt: return lhs < rhs;
+        case Op::Le: return lhs <= rhs;
+        case Op::Gt: return lhs > rhs;
+        case Op::Ge: return lhs >= rhs;
+        default: break;
+    }
+
+    if (node.op == Op::Add && lhs.is_string() && rhs.is_string()) {
+        return lhs.get<std::string>() + rhs.get<std::string>();
+    }
+    if (!lhs.is_number() || !rhs.is_number()) {
+        throw std::runtime_error(std::string("invalid operands for '") + symbol + "'");
+    }
+
+    // 整数运算溢出时改用浮点结果，而不是产生未定义行为
+    const bool both_int = lhs.is_number_integer() && rhs.is_number_integer();
+    std::int64_t int_result = 0;
+    switch (node.op) {
+        case Op::Add:
+            if (both_int && !__builtin_add_overflow(lhs.get<std::int64_t>(), rhs.get<std::int64_t>(), &int_result)) {
+                return int_result;
+            }
+            return lhs.get<double>() + rhs.get<double>();
+        case Op::Sub:
+            if (both_int && !__builtin_sub_overflow(lhs.get<std::int64_t>(), rhs.get<std::int64_t>(), &int_result)) {
+                return int_result;
+            }
+            return lhs.get<double>() - rhs.get<double>();
+        case Op::Mul:
+            if (both_int && !__builtin_mul_overflow(lhs.get<std::int64_t>(), rhs.get<std::int64_t>(), &int_result)) {
+                return int_result;
+            }
+            return lhs.get<double>() * rhs.get<double>();
+        case Op::Div:
+            if (rhs.get<double>() == 0.0) throw std::runtime_error("division by zero");
+            return lhs.get<double>() / rhs.get<double>();
+        case Op::Mod:
+            if (!both_int) throw std::runtime_error("invalid operands for '%'");
+            if (rhs.get<std::int64_t>() == 0) throw std::runtime_error("division by zero");
+            if (rhs.get<std::int64_t>() == -1) return std::int64_t{0}; // INT64_MIN % -1 会溢出
+            return lhs.get<std::int64_t>() % rhs.get<std::int64_t>();
+        case Op::Pow: {
+            const double result = std::pow(lhs.get<double>(), rhs.get<double>());
+            // 2^63 本身已超出 int64 范围
+            if (both_int && rhs.get<std::int64_t>() >= 0 && std::abs(result) < 9223372036854775808.0) {
+                return static_cast<std::int64_t>(result);
+            }
+            return result;
+        }
+        default:
+            throw std::runtime_error("unknown expression operator");
+    }
+}
+
+} // namespace agenticdsl
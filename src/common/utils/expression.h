@@ -0,0 +1,63 @@
+#ifndef AGENTICDSL_COMMON_UTILS_EXPRESSION_H
+#define AGENTICDSL_COMMON_UTILS_EXPRESSION_H
+
+#include "core/types/context.h" // 引入 Context / Value (nlohmann::json)
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace agenticdsl {
+
+// 编译后的类型化表达式（Inja 表达式语法的子集），直接对上下文求值并返回 JSON
+//
+// 支持：数字 / 字符串 / true / false / null 字面量，路径（a.b.0），
+//       + - * / % ^，== != < <= > >=，and / or / not，括号
+// 语义与 Inja 对齐：/ 总是返回浮点，两个字符串相加为拼接，and / or / not 按真值判断；
+// 运算符优先级同 Inja（and 与 or 同级左结合，not 比比较运算结合得更紧）；整数溢出时结果转为浮点
+// 不支持：函数调用、过滤器、in、数组/对象字面量 —— 此时 compile 返回 std::nullopt，由调用方回退到 Inja
+class Expression {
+public:
+    static std::optional<Expression> compile(std::string_view source);
+
+    // 求值；变量缺失、类型不匹配或除零时抛出 std::runtime_error
+    Value evaluate(const Context& context) const;
+
+    bool is_path() const { return nodes_[root_].op == Op::Path; } // 单纯的变量引用
+    bool is_constant() const; // 不引用任何变量，可在编译期求值
+    const std::string& source() const { return source_; }
+
+    // Inja 的真值规则：bool 取值，数字非零，null 为假，字符串/数组/对象非空
+    static bool truthy(const Value& value);
+
+private:
+    friend class ExpressionParser;
+
+    enum class Op : std::uint8_t {
+        Literal, Path,
+        Not, Neg,
+        Add, Sub, Mul, Div, Mod, Pow,
+        Eq, Ne, Lt, Le, Gt, Ge,
+        And, Or
+    };
+
+    struct Node {
+        Op op = Op::Literal;
+        int lhs = -1;
+        int rhs = -1;
+        Value literal;                      // Literal
+        nlohmann::json::json_pointer path;  // Path
+        std::string name;                   // Path 的原始写法，用于报错
+    };
+
+    Value eval(int index, const Context& context) const;
+
+    std::string source_;
+    std::vector<Node> nodes_; // 扁平存储，子节点以下标引用
+    int root_ = -1;
+};
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_COMMON_UTILS_EXPRESSION_H
@@ -0,0 +1,177 @@
+// common/utils/lz_codec.cpp
+#include "lz_codec.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace agenticdsl {
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kLastLiterals = 5;   // LZ4: 最后 5 字节必须为字面量
+constexpr size_t kMatchSafeZone = 12; // LZ4: 匹配不能从最后 12 字节内开始
+constexpr size_t kMaxOffset = 65535;
+constexpr int kHashBits = 14;
+
+inline std::uint32_t read_u32(const std::uint8_t* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint32_t hash4(std::uint32_t v) {
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+inline void write_length(std::vector<std::uint8_t>& out, size_t len) {
+    while (len >= 255) {
+        out.push_back(255);
+        len -= 255;
+    }
+    out.push_back(static_cast<std::uint8_t>(len));
+}
+
+void emit_sequence(std::vector<std::uint8_t>& out,
+                   const std::uint8_t* literals, size_t literal_len,
+                   size_t offset, size_t match_len) {
+    std::uint8_t token = 0;
+    token |= static_cast<std::uint8_t>((literal_len >= 15 ? 15 : literal_len) << 4);
+    if (match_len > 0) {
+        size_t ml = match_len - kMinMatch;
+        token |= static_cast<std::uint8_t>(ml >= 15 ? 15 : ml);
+    }
+    out.push_back(token);
+    if (literal_len >= 15) write_length(out, literal_len - 15);
+    out.insert(out.end(), literals, literals + literal_len);
+
+    if (match_len > 0) {
+        out.push_back(static_cast<std::uint8_t>(offset & 0xFF));
+        out.push_back(static_cast<std::uint8_t>((offset >> 8) & 0xFF));
+        size_t ml = match_len - kMinMatch;
+        if (ml >= 15) write_length(out, ml - 15);
+    }
+}
+
+} // namespace
+
+std::vector<std::uint8_t> lz_compress(std::span<const std::uint8_t> input) {
+    std::vector<std::uint8_t> out;
+    const size_t n = input.size();
+    out.reserve(n / 2 + 16);
+    const std::uint8_t* src = input.data();
+
+    if (n < kMatchSafeZone + 1) {
+        emit_sequence(out, src, n, 0, 0);
+        return out;
+    }
+
+    std::array<std::uint32_t, 1u << kHashBits> table{}; // 保存 position + 1，0 表示空
+    const size_t match_limit = n - kMatchSafeZone;
+    const size_t copy_limit = n - kLastLiterals;
+    size_t anchor = 0;
+    size_t pos = 0;
+
+    while (pos < match_limit) {
+        std::uint32_t seq = read_u32(src + pos);
+        std::uint32_t h = hash4(seq);
+        size_t candidate = table[h];
+        table[h] = static_cast<std::uint32_t>(pos + 1);
+
+        if (candidate == 0) { ++pos; continue; }
+        candidate -= 1;
+        if (pos - candidate > kMaxOffset || read_u32(src + candidate) != seq) {
+            ++pos;
+            continue;
+        }
+
+        // 向前扩展匹配（不越过 anchor）
+        while (pos > anchor && candidate > 0 && src[pos - 1] == src[candidate - 1]) {
+            --pos;
+            --candidate;
+        }
+
+        size_t match_len = kMinMatch;
+        while (pos + match_len < copy_limit && src[pos + match_len] == src[candidate + match_len]) {
+            ++match_len;
+        }
+
+        emit_sequence(out, src + anchor, pos - anchor, pos - candidate, match_len);
+        pos += match_len;
+        anchor = pos;
+
+        if (pos >= 2 && pos - 2 < match_limit) {
+            table[hash4(read_u32(src + pos - 2))] = static_cast<std::uint32_t>(pos - 2 + 1);
+        }
+    }
+
+    emit_sequence(out, src + anchor, n - anchor, 0, 0);
+    return out;
+}
+
+size_t lz_max_decompressed_size(size_t input_size) {
+    constexpr size_t kMaxRatio = 255;
+    constexpr size_t kSlack = 64; // 最短序列的 token/offset 开销
+    if (input_size > (SIZE_MAX - kSlack) / kMaxRatio) return SIZE_MAX;
+    return input_size * kMaxRatio + kSlack;
+}
+
+std::vector<std::uint8_t> lz_decompress(std::span<const std::uint8_t> input, size_t original_size) {
+    // original_size 来自外部数据时不可信：先按压缩比上限拒绝，再预留内存
+    if (original_size > lz_max_decompressed_size(input.size())) {
+        throw std::runtime_error("LZ decompress: declared size exceeds maximum compression ratio");
+    }
+    std::vector<std::uint8_t> out;
+    out.reserve(original_size);
+    const std::uint8_t* ip = input.data();
+    const std::uint8_t* const iend = ip + input.size();
+
+    auto read_length = [&](size_t base) {
+        size_t len = base;
+        if (base == 15) {
+            std::uint8_t b;
+            do {
+                if (ip >= iend) throw std::runtime_error("LZ decompress: truncated length");
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        return len;
+    };
+
+    while (ip < iend) {
+        std::uint8_t token = *ip++;
+        size_t literal_len = read_length(token >> 4);
+        if (static_cast<size_t>(iend - ip) < literal_len || out.size() + literal_len > original_size) {
+            throw std::runtime_error("LZ decompress: literal run out of bounds");
+        }
+        out.insert(out.end(), ip, ip + literal_len);
+        ip += literal_len;
+
+        if (ip >= iend) break; // 最后一个序列只有字面量
+
+        if (iend - ip < 2) throw std::runtime_error("LZ decompress: truncated offset");
+        size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > out.size()) {
+            throw std::runtime_error("LZ decompress: invalid match offset");
+        }
+        size_t match_len = read_length(token & 0x0F) + kMinMatch;
+        if (out.size() + match_len > original_size) {
+            throw std::runtime_error("LZ decompress: match exceeds declared size");
+        }
+        // 匹配可能与输出重叠，逐字节复制
+        size_t from = out.size() - offset;
+        for (size_t i = 0; i < match_len; ++i) {
+            out.push_back(out[from + i]);
+        }
+    }
+
+    if (out.size() != original_size) {
+        throw std::runtime_error("LZ decompress: size mismatch");
+    }
+    return out;
+}
+
+} // namespace agenticdsl
@@ -0,0 +1,23 @@
+#ifndef AGENTICDSL_COMMON_UTILS_LZ_CODEC_H
+#define AGENTICDSL_COMMON_UTILS_LZ_CODEC_H
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace agenticdsl {
+
+// 轻量 LZ77 压缩（LZ4 block 格式兼容），用于冷快照和持久化状态
+// 输出不包含原始长度，解压时需由调用方提供
+std::vector<std::uint8_t> lz_compress(std::span<const std::uint8_t> input);
+
+// input_size 字节的压缩数据最多能展开的长度（每个扩展长度字节至多表示 255 字节）
+size_t lz_max_decompressed_size(size_t input_size);
+
+// 解压 lz_compress 的输出；数据损坏、长度不符或 original_size 超过上限时抛出 std::runtime_error
+std::vector<std::uint8_t> lz_decompress(std::span<const std::uint8_t> input, size_t original_size);
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_COMMON_UTILS_LZ_CODEC_H
@@ -1,58 +1,165 @@
 // common/utils/parser_utils.cpp
 #include "parser_utils.h"
-#include <regex>
+#include <algorithm>
+#include <cctype>
+#include <optional>
 #include <string>
 #include <vector>
 #include <utility> // for std::pair
 
 namespace agenticdsl {
 
-std::vector<std::pair<NodePath, std::string>> extract_pathed_blocks(const std::string& markdown_content) {
-    std::vector<std::pair<NodePath, std::string>> blocks;
+namespace {
+
+// 块格式：
+//   ### AgenticDSL `/path`
+//   ```yaml
+//   # --- BEGIN AgenticDSL ---
+//   ...
+//   # --- END AgenticDSL ---
+//   ```
+constexpr std::string_view kKeyword = "AgenticDSL";
+constexpr std::string_view kFence = "```";
+constexpr std::string_view kBeginMarker = "# --- BEGIN AgenticDSL ---";
+constexpr std::string_view kEndMarker = "# --- END AgenticDSL ---";
+
+// [begin, end) 为行内容（不含 '\n'），next 为下一行起点
+struct Line {
+    size_t begin;
+    size_t end;
+    size_t next;
+    bool terminated; // 是否以 '\n' 结尾
+};
+
+Line line_at(std::string_view s, size_t pos) {
+    size_t nl = s.find('\n', pos);
+    if (nl == std::string_view::npos) return {pos, s.size(), s.size(), false};
+    return {pos, nl, nl + 1, true};
+}
+
+bool is_space(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+bool is_blank(std::string_view v) {
+    return std::all_of(v.begin(), v.end(), is_space);
+}
+
+std::string_view text_of(std::string_view s, const Line& line) {
+    return s.substr(line.begin, line.end - line.begin);
+}
+
+// 行以 marker 开头且其余部分只有空白
+bool is_marker_line(std::string_view line, std::string_view marker) {
+    return line.substr(0, marker.size()) == marker && is_blank(line.substr(std::min(marker.size(), line.size())));
+}
+
+// 从 pos 开始跳过空白行，返回第一条非空白行；到达末尾返回 std::nullopt
+std::optional<Line> next_content_line(std::string_view s, size_t pos) {
+    while (pos < s.size()) {
+        Line line = line_at(s, pos);
+        if (!is_blank(text_of(s, line))) return line;
+        pos = line.next;
+    }
+    return std::nullopt;
+}
+
+// 解析标题行 "#... AgenticDSL `/path`"，返回路径
+std::optional<std::string_view> parse_header(std::string_view line) {
+    size_t idx = line.find(kKeyword);
+    while (idx != std::string_view::npos) {
+        // 关键字前：至少一个空白，再往前是 '#'
+        size_t j = idx;
+        while (j > 0 && is_space(line[j - 1])) --j;
+        bool has_hash = (j < idx && j > 0 && line[j - 1] == '#');
+
+        // 关键字后：至少一个空白，再是 `path`，行尾只允许空白
+        size_t k = idx + kKeyword.size();
+        size_t after_ws = k;
+        while (after_ws < line.size() && is_space(line[after_ws])) ++after_ws;
+        if (has_hash && after_ws > k && after_ws < line.size() && line[after_ws] == '`') {
+            size_t close = line.find('`', after_ws + 1);
+            if (close != std::string_view::npos && close > after_ws + 1 && is_blank(line.substr(close + 1))) {
+                return line.substr(after_ws + 1, close - after_ws - 1);
+            }
+        }
+        idx = line.find(kKeyword, idx + 1);
+    }
+    return std::nullopt;
+}
+
+} // namespace
+
+std::vector<PathedBlockView> scan_pathed_blocks(std::string_view s) {
+    std::vector<PathedBlockView> blocks;
+    size_t pos = 0;
+
+    while (pos < s.size()) {
+        Line header = line_at(s, pos);
+        pos = header.next;
+        if (!header.terminated) break;
+
+        std::string_view header_text = text_of(s, header);
+        if (header_text.find(kKeyword) == std::string_view::npos) continue;
+        auto path = parse_header(header_text);
+        if (!path) continue;
+
+        // ``` 或 ```yaml
+        auto fence = next_content_line(s, header.next);
+        if (!fence || !fence->terminated) continue;
+        std::string_view fence_text = text_of(s, *fence);
+        if (!is_marker_line(fence_text, kFence) && !is_marker_line(fence_text, "```yaml")) continue;
+
+        auto begin = next_content_line(s, fence->next);
+        if (!begin || !begin->terminated || !is_marker_line(text_of(s, *begin), kBeginMarker)) continue;
 
-    // 正则表达式：匹配 AgenticDSL 块
-    // 捕获组 1: 路径 (path)
-    // 捕获组 2: 完整的 YAML 内容（包含 BEGIN/END 标记）
-    std::regex block_pattern(
-        R"(#\s+AgenticDSL\s+`([^`]+)`\s*\n)"          // 捕获组 1: 路径
-        R"(```(?:yaml)?\s*\n)"                        // ``` 或 ```yaml
-        R"(# --- BEGIN AgenticDSL ---\s*\n)"          // BEGIN 标记
-        R"([\s\S]*?)"                                 // 捕获内容 (非贪婪)
-        R"(\n# --- END AgenticDSL ---\s*\n)"          // END 标记
-        R"(```)",                                     // closing ```
-        std::regex::ECMAScript
-    );
-
-    std::sregex_iterator begin(markdown_content.begin(), markdown_content.end(), block_pattern);
-    std::sregex_iterator end;
-
-    for (std::sregex_iterator it = begin; it != end; ++it) {
-        std::string path = (*it)[1].str();        // 提取路径
-        std::string full_content = (*it)[0].str(); // 提取整个匹配块
-
-        // 从 full_content 中提取 BEGIN 和 END 之间的 YAML 内容
-        size_t begin_pos = full_content.find("# --- BEGIN AgenticDSL ---");
-        size_t end_pos = full_content.find("# --- END AgenticDSL ---");
-        if (begin_pos != std::string::npos && end_pos != std::string::npos) {
-            size_t start = full_content.find('\n', begin_pos);
-            if (start != std::string::npos) {
-                start++; // 跳过换行
-                std::string yaml_content = full_content.substr(start, end_pos - start);
-                // 去除末尾可能的换行
-                if (!yaml_content.empty() && yaml_content.back() == '\n') {
-                    yaml_content.pop_back();
-                }
-                blocks.emplace_back(std::move(path), std::move(yaml_content));
+        // 查找 END 标记（其后必须紧跟 closing ```）
+        size_t content_begin = begin->next;
+        std::optional<PathedBlockView> found;
+        size_t scan = content_begin;
+        while (scan < s.size()) {
+            Line line = line_at(s, scan);
+            scan = line.next;
+            if (line.begin <= content_begin || !line.terminated ||
+                !is_marker_line(text_of(s, line), kEndMarker)) {
+                continue;
             }
+            auto closing = next_content_line(s, line.next);
+            if (!closing || s.substr(closing->begin, kFence.size()) != kFence) continue;
+
+            // 内容截止到块内第一个 END 标记，并去掉其前面的换行
+            size_t content_end = s.find(kEndMarker, content_begin);
+            std::string_view content = s.substr(content_begin, content_end - content_begin);
+            if (!content.empty() && content.back() == '\n') content.remove_suffix(1);
+
+            PathedBlockView block;
+            block.path = *path;
+            block.content = content;
+            block.end_offset = closing->begin + kFence.size();
+            found = block;
+            break;
         }
+        if (!found) break; // 之后不可能再有完整的块
+
+        blocks.push_back(*found);
+        pos = found->end_offset;
+    }
+    return blocks;
+}
+
+std::vector<std::pair<NodePath, std::string>> extract_pathed_blocks(const std::string& markdown_content) {
+    std::vector<std::pair<NodePath, std::string>> blocks;
+    for (const auto& block : scan_pathed_blocks(markdown_content)) {
+        blocks.emplace_back(NodePath(block.path), std::string(block.content));
     }
     return blocks;
 }
 
-bool is_valid_node_path(const std::string& path) {
-    if (path.empty() || path[0] != '/') return false;
-    std::regex valid(R"(^/[\w/\-]+$)");
-    return std::regex_match(path, valid);
+bool is_valid_node_path(std::string_view path) {
+    if (path.size() < 2 || path[0] != '/') return false;
+    return std::all_of(path.begin() + 1, path.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '/' || c == '-';
+    });
 }
 
 } // namespace agenticdsl
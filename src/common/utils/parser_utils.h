@@ -3,16 +3,27 @@
 
 #include "core/types/node.h" // 引入 NodePath
 #include <string>
+#include <string_view>
 #include <vector>
 #include <utility> // for std::pair
 
 namespace agenticdsl {
 
-// 从 Markdown 内容中提取带有路径的 DSL 块
+// 扫描得到的 DSL 块；视图指向输入文本，调用方需保证输入在使用期间有效
+struct PathedBlockView {
+    std::string_view path;
+    std::string_view content; // BEGIN / END 标记之间的 YAML
+    size_t end_offset = 0;    // 块结束位置（closing ``` 之后）在输入中的偏移
+};
+
+// 单遍扫描 Markdown，按出现顺序返回所有 AgenticDSL 块（不做任何拷贝）
+std::vector<PathedBlockView> scan_pathed_blocks(std::string_view markdown_content);
+
+// 从 Markdown 内容中提取带有路径的 DSL 块（拷贝版本）
 std::vector<std::pair<NodePath, std::string>> extract_pathed_blocks(const std::string& markdown_content);
 
-// 验证节点路径格式是否有效
-bool is_valid_node_path(const std::string& path);
+// 验证节点路径格式是否有效：/ 开头，仅含字母、数字、_、-、/
+bool is_valid_node_path(std::string_view path);
 
 } // namespace agenticdsl
 
@@ -0,0 +1,218 @@
+// common/utils/signature.cpp
+#include "signature.h"
+#include <cctype>
+#include <stdexcept>
+
+namespace agenticdsl {
+
+namespace {
+
+bool is_name_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+std::optional<Signature::Kind> kind_from_name(std::string_view name) {
+    using Kind = Signature::Kind;
+    if (name == "string" || name == "str") return Kind::String;
+    if (name == "number" || name == "float") return Kind::Number;
+    if (name == "integer" || name == "int") return Kind::Integer;
+    if (name == "boolean" || name == "bool") return Kind::Boolean;
+    if (name == "object" || name == "dict") return Kind::Object;
+    if (name == "array" || name == "list") return Kind::Array;
+    if (name == "null") return Kind::Null;
+    if (name == "any") return Kind::Any;
+    return std::nullopt;
+}
+
+bool matches_kind(Signature::Kind kind, const Value& value) {
+    using Kind = Signature::Kind;
+    switch (kind) {
+        case Kind::Any: return true;
+        case Kind::String: return value.is_string();
+        case Kind::Number: return value.is_number();
+        case Kind::Integer: return value.is_number_integer();
+        case Kind::Boolean: return value.is_boolean();
+        case Kind::Object: return value.is_object();
+        case Kind::Array: return value.is_array();
+        case Kind::Null: return value.is_null();
+    }
+    return false;
+}
+
+class SignatureParser {
+public:
+    explicit SignatureParser(std::string_view src) : src_(src) {}
+
+    void parse(std::vector<Signature::Field>& inputs, std::vector<Signature::Field>& outputs) {
+        expect('(');
+        if (!try_consume(')')) {
+            parse_fields(inputs);
+            expect(')');
+        }
+        skip_ws();
+        if (pos_ < src_.size()) {
+            if (src_.substr(pos_, 2) != "->") fail("expected '->'");
+            pos_ += 2;
+            if (try_consume('{')) {
+                if (!try_consume('}')) {
+                    parse_fields(outputs);
+                    expect('}');
+                }
+            } else {
+                parse_fields(outputs);
+            }
+        }
+        skip_ws();
+        if (pos_ != src_.size()) fail("unexpected trailing input");
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::runtime_error("Invalid signature '" + std::string(src_) + "' at " + std::to_string(pos_) + ": " + message);
+    }
+
+    void skip_ws() {
+        while (pos_ < src_.size() && std::isspace(static_cast<unsigned char>(src_[pos_]))) ++pos_;
+    }
+
+    bool try_consume(char c) {
+        skip_ws();
+        if (pos_ < src_.size() && src_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!try_consume(c)) fail(std::string("expected '") + c + "'");
+    }
+
+    std::string_view name() {
+        skip_ws();
+        size_t start = pos_;
+        while (pos_ < src_.size() && is_name_char(src_[pos_])) ++pos_;
+        if (pos_ == start) fail("expected a name");
+        return src_.substr(start, pos_ - start);
+    }
+
+    void parse_fields(std::vector<Signature::Field>& fields) {
+        do {
+            Signature::Field field;
+            field.name = std::string(name());
+            if (try_consume('?')) field.required = false;
+            if (try_consume(':')) parse_type(field);
+            for (const auto& existing : fields) {
+                if (existing.name == field.name) fail("duplicate field '" + field.name + "'");
+            }
+            fields.push_back(std::move(field));
+        } while (try_consume(','));
+    }
+
+    void parse_type(Signature::Field& field) {
+        std::string_view type_name = name();
+        auto kind = kind_from_name(type_name);
+        if (!kind) fail("unknown type '" + std::string(type_name) + "'");
+        field.kind = *kind;
+        if (try_consume('[')) {
+            expect(']');
+            field.item_kind = field.kind;
+            field.kind = Signature::Kind::Array;
+        }
+    }
+
+    std::string_view src_;
+    size_t pos_ = 0;
+};
+
+} // namespace
+
+Signature Signature::parse(std::string_view text) {
+    Signature sig;
+    sig.source_ = std::string(text);
+    SignatureParser(sig.source_).parse(sig.inputs_, sig.outputs_);
+    return sig;
+}
+
+const char* Signature::kind_name(Kind kind) {
+    switch (kind) {
+        case Kind::Any: return "any";
+        case Kind::String: return "string";
+        case Kind::Number: return "number";
+        case Kind::Integer: return "integer";
+        case Kind::Boolean: return "boolean";
+        case Kind::Object: return "object";
+        case Kind::Array: return "array";
+        case Kind::Null: return "null";
+    }
+    return "any";
+}
+
+bool Signature::matches(const Field& field, const Value& value) {
+    if (!matches_kind(field.kind, value)) return false;
+    if (field.kind == Kind::Array && field.item_kind != Kind::Any) {
+        for (const auto& item : value) {
+            if (!matches_kind(field.item_kind, item)) return false;
+        }
+    }
+    return true;
+}
+
+std::optional<std::string> Signature::check_fields(const std::vector<Field>& fields, const Value& object, const char* what) {
+    if (fields.empty()) return std::nullopt;
+    if (!object.is_object()) return std::string(what) + " must be an object";
+    for (const auto& field : fields) {
+        auto it = object.find(field.name);
+        if (it == object.end()) {
+            if (field.required) return std::string("missing ") + what + " '" + field.name + "'";
+            continue;
+        }
+        if (!matches(field, *it)) {
+            std::string expected = kind_name(field.kind);
+            if (field.kind == Kind::Array && field.item_kind != Kind::Any) {
+                expected = std::string(kind_name(field.item_kind)) + "[]";
+            }
+            return std::string(what) + " '" + field.name + "' expected " + expected + ", got " + it->type_name();
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Signature::check_inputs(const Value& args) const {
+    return check_fields(inputs_, args, "input");
+}
+
+std::optional<std::string> Signature::check_outputs(const Value& context) const {
+    return check_fields(outputs_, context, "output");
+}
+
+std::optional<std::string> Signature::check_declared_outputs(const std::unordered_set<std::string>& written_keys) const {
+    for (const auto& field : outputs_) {
+        if (field.required && written_keys.count(field.name) == 0) {
+            return "no node writes output '" + field.name + "'";
+        }
+    }
+    return std::nullopt;
+}
+
+nlohmann::json Signature::fields_json(const std::vector<Field>& fields) {
+    nlohmann::json out = nlohmann::json::array();
+    for (const auto& field : fields) {
+        nlohmann::json entry = {{"name", field.name}, {"type", kind_name(field.kind)}, {"required", field.required}};
+        if (field.kind == Kind::Array && field.item_kind != Kind::Any) {
+            entry["items"] = kind_name(field.item_kind);
+        }
+        out.push_back(std::move(entry));
+    }
+    return out;
+}
+
+nlohmann::json Signature::inputs_json() const {
+    return fields_json(inputs_);
+}
+
+nlohmann::json Signature::outputs_json() const {
+    return fields_json(outputs_);
+}
+
+} // namespace agenticdsl
@@ -0,0 +1,64 @@
+#ifndef AGENTICDSL_COMMON_UTILS_SIGNATURE_H
+#define AGENTICDSL_COMMON_UTILS_SIGNATURE_H
+
+#include "core/types/context.h" // 引入 Context / Value (nlohmann::json)
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace agenticdsl {
+
+// 编译后的子图/节点签名，解析一次后可重复用于校验（不可变，可跨线程共享）
+//
+// 语法：
+//   signature := '(' [field {',' field}] ')' ['->' outputs]
+//   outputs   := '{' [field {',' field}] '}' | field {',' field}
+//   field     := name ['?'] [':' type]          -- '?' 表示可选；省略类型即 any
+//   type      := string | number | integer | boolean | object | array | null | any，可加 '[]' 表示数组
+// 例如 "(a: number, b: number) -> {sum: number}"、"(a: number) -> sum: number"、"(query: string) -> results"
+class Signature {
+public:
+    enum class Kind : std::uint8_t { Any, String, Number, Integer, Boolean, Object, Array, Null };
+
+    struct Field {
+        std::string name;
+        Kind kind = Kind::Any;
+        Kind item_kind = Kind::Any; // kind == Array 时的元素类型
+        bool required = true;
+    };
+
+    // 语法错误抛出 std::runtime_error（含出错位置）
+    static Signature parse(std::string_view text);
+
+    const std::vector<Field>& inputs() const { return inputs_; }
+    const std::vector<Field>& outputs() const { return outputs_; }
+    const std::string& source() const { return source_; }
+
+    // 校验对象中的字段；返回第一处违例的描述，全部通过返回 std::nullopt（不抛异常）
+    std::optional<std::string> check_inputs(const Value& args) const;
+    std::optional<std::string> check_outputs(const Value& context) const;
+    // 静态校验：必填输出是否都有节点写入（用于刚生成、尚未执行的子图）
+    std::optional<std::string> check_declared_outputs(const std::unordered_set<std::string>& written_keys) const;
+
+    // [{name, type, required}]，供 available_subgraphs / 库清单展示
+    nlohmann::json inputs_json() const;
+    nlohmann::json outputs_json() const;
+
+    static const char* kind_name(Kind kind);
+    static bool matches(const Field& field, const Value& value);
+
+private:
+    static std::optional<std::string> check_fields(const std::vector<Field>& fields, const Value& object, const char* what);
+    static nlohmann::json fields_json(const std::vector<Field>& fields);
+
+    std::string source_;
+    std::vector<Field> inputs_;
+    std::vector<Field> outputs_;
+};
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_COMMON_UTILS_SIGNATURE_H
@@ -0,0 +1,130 @@
+// common/utils/snapshot_codec.cpp
+#include "snapshot_codec.h"
+#include "lz_codec.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace agenticdsl {
+
+namespace {
+
+constexpr std::uint8_t kMagic[4] = {'A', 'D', 'S', 'S'};
+constexpr std::uint8_t kVersion = 1;
+constexpr size_t kHeaderSize = 4 + 1 + 1 + 1 + 8; // magic, version, format, flags, raw_size
+
+std::vector<std::uint8_t> encode_raw(const Context& ctx, SnapshotFormat format) {
+    switch (format) {
+        case SnapshotFormat::CBOR:
+            return nlohmann::json::to_cbor(ctx);
+        case SnapshotFormat::MSGPACK:
+            return nlohmann::json::to_msgpack(ctx);
+        case SnapshotFormat::JSON: {
+            std::string text = ctx.dump();
+            return std::vector<std::uint8_t>(text.begin(), text.end());
+        }
+    }
+    throw std::runtime_error("Unknown snapshot format");
+}
+
+Context decode_raw(std::span<const std::uint8_t> raw, SnapshotFormat format) {
+    switch (format) {
+        case SnapshotFormat::CBOR:
+            return nlohmann::json::from_cbor(raw.begin(), raw.end());
+        case SnapshotFormat::MSGPACK:
+            return nlohmann::json::from_msgpack(raw.begin(), raw.end());
+        case SnapshotFormat::JSON:
+            return nlohmann::json::parse(raw.begin(), raw.end());
+    }
+    throw std::runtime_error("Unknown snapshot format");
+}
+
+} // namespace
+
+EncodedSnapshot encode_snapshot(const Context& ctx, SnapshotFormat format, bool compress) {
+    EncodedSnapshot snapshot;
+    snapshot.format = format;
+    snapshot.bytes = encode_raw(ctx, format);
+    snapshot.raw_size = snapshot.bytes.size();
+    if (compress) {
+        return compress_snapshot(std::move(snapshot));
+    }
+    return snapshot;
+}
+
+EncodedSnapshot compress_snapshot(EncodedSnapshot snapshot) {
+    if (snapshot.compressed) return snapshot;
+    auto packed = lz_compress(snapshot.bytes);
+    // 不可压缩的数据保持原样，避免解压开销
+    if (packed.size() < snapshot.bytes.size()) {
+        snapshot.bytes = std::move(packed);
+        snapshot.compressed = true;
+    }
+    return snapshot;
+}
+
+Context decode_snapshot(const EncodedSnapshot& snapshot) {
+    try {
+        if (snapshot.compressed) {
+            auto raw = lz_decompress(snapshot.bytes, snapshot.raw_size);
+            return decode_raw(raw, snapshot.format);
+        }
+        return decode_raw(snapshot.bytes, snapshot.format);
+    } catch (const nlohmann::json::exception& e) {
+        throw std::runtime_error(std::string("Snapshot decode error: ") + e.what());
+    }
+}
+
+std::vector<std::uint8_t> serialize_snapshot(const EncodedSnapshot& snapshot) {
+    std::vector<std::uint8_t> out;
+    out.reserve(kHeaderSize + snapshot.bytes.size());
+    out.insert(out.end(), std::begin(kMagic), std::end(kMagic));
+    out.push_back(kVersion);
+    out.push_back(static_cast<std::uint8_t>(snapshot.format));
+    out.push_back(snapshot.compressed ? 1 : 0);
+    std::uint64_t raw_size = snapshot.raw_size;
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<std::uint8_t>((raw_size >> (8 * i)) & 0xFF));
+    }
+    out.insert(out.end(), snapshot.bytes.begin(), snapshot.bytes.end());
+    return out;
+}
+
+EncodedSnapshot deserialize_snapshot(std::span<const std::uint8_t> data) {
+    if (data.size() < kHeaderSize || !std::equal(std::begin(kMagic), std::end(kMagic), data.begin())) {
+        throw std::runtime_error("Invalid snapshot blob: bad header");
+    }
+    if (data[4] != kVersion) {
+        throw std::runtime_error("Unsupported snapshot blob version: " + std::to_string(data[4]));
+    }
+    if (data[5] > static_cast<std::uint8_t>(SnapshotFormat::MSGPACK)) {
+        throw std::runtime_error("Invalid snapshot blob: unknown format");
+    }
+
+    EncodedSnapshot snapshot;
+    snapshot.format = static_cast<SnapshotFormat>(data[5]);
+    snapshot.compressed = (data[6] & 1) != 0;
+    std::uint64_t raw_size = 0;
+    for (int i = 0; i < 8; ++i) {
+        raw_size |= static_cast<std::uint64_t>(data[7 + i]) << (8 * i);
+    }
+    const size_t payload_size = data.size() - kHeaderSize;
+    // raw_size 来自导入的数据：未压缩时必须等于负载长度，压缩时不得超过压缩比上限
+    const std::uint64_t max_raw = snapshot.compressed ? lz_max_decompressed_size(payload_size) : payload_size;
+    if (raw_size > max_raw || (!snapshot.compressed && raw_size != payload_size)) {
+        throw std::runtime_error("Invalid snapshot blob: raw size " + std::to_string(raw_size) +
+                                 " does not match payload of " + std::to_string(payload_size) + " bytes");
+    }
+    snapshot.raw_size = static_cast<size_t>(raw_size);
+    snapshot.bytes.assign(data.begin() + kHeaderSize, data.end());
+    return snapshot;
+}
+
+std::optional<SnapshotFormat> parse_snapshot_format(std::string_view name) {
+    if (name == "cbor") return SnapshotFormat::CBOR;
+    if (name == "msgpack") return SnapshotFormat::MSGPACK;
+    if (name == "json") return SnapshotFormat::JSON;
+    return std::nullopt;
+}
+
+} // namespace agenticdsl
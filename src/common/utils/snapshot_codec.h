@@ -0,0 +1,45 @@
+#ifndef AGENTICDSL_COMMON_UTILS_SNAPSHOT_CODEC_H
+#define AGENTICDSL_COMMON_UTILS_SNAPSHOT_CODEC_H
+
+#include "core/types/context.h" // 引入 Context (nlohmann::json)
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace agenticdsl {
+
+// 快照 / 持久化状态的编码格式
+enum class SnapshotFormat : uint8_t {
+    JSON,    // 文本（调试用）
+    CBOR,    // RFC 8949，默认
+    MSGPACK
+};
+
+// 编码后的上下文（可选 LZ 压缩）
+struct EncodedSnapshot {
+    SnapshotFormat format = SnapshotFormat::CBOR;
+    bool compressed = false;
+    size_t raw_size = 0;             // 压缩前的编码长度
+    std::vector<std::uint8_t> bytes; // 实际存储的数据
+
+    size_t size_bytes() const { return bytes.size(); }
+};
+
+EncodedSnapshot encode_snapshot(const Context& ctx, SnapshotFormat format = SnapshotFormat::CBOR, bool compress = false);
+Context decode_snapshot(const EncodedSnapshot& snapshot);
+
+// 对已编码的快照做 LZ 压缩（冷化）；已压缩则原样返回
+EncodedSnapshot compress_snapshot(EncodedSnapshot snapshot);
+
+// 自描述二进制封装（magic + 版本 + 格式 + 原始长度），用于写盘或跨进程传递
+std::vector<std::uint8_t> serialize_snapshot(const EncodedSnapshot& snapshot);
+EncodedSnapshot deserialize_snapshot(std::span<const std::uint8_t> data);
+
+// "json" / "cbor" / "msgpack"
+std::optional<SnapshotFormat> parse_snapshot_format(std::string_view name);
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_COMMON_UTILS_SNAPSHOT_CODEC_H
@@ -25,16 +25,123 @@ void InjaTemplateRenderer::configure_security() {
     });
 }
 
+InjaTemplateRenderer& InjaTemplateRenderer::default_renderer() {
+    // inja::Environment 不是线程安全的：每个线程持有独立的环境，无需全局锁。
+    // CompiledTemplate 在渲染时只读，可以在线程之间共享。
+    thread_local InjaTemplateRenderer renderer;
+    return renderer;
+}
+
+// 不含表达式/语句/注释/行语句标记的模板渲染结果就是原文
+static bool has_template_syntax(std::string_view s) {
+    if (s.find("{{") != std::string_view::npos ||
+        s.find("{%") != std::string_view::npos ||
+        s.find("{#") != std::string_view::npos) {
+        return true;
+    }
+    size_t pos = 0;
+    while (pos < s.size()) {
+        size_t first = s.find_first_not_of(" \t", pos);
+        if (first != std::string_view::npos && s.compare(first, 2, "##") == 0) {
+            return true;
+        }
+        size_t nl = s.find('\n', pos);
+        if (nl == std::string_view::npos) break;
+        pos = nl + 1;
+    }
+    return false;
+}
+
+// 整段为 "{{ expr }}" 的模板（外侧空白属于输出，不允许）尝试编译为原生表达式；
+// 超出表达式子集（函数、过滤器等）时返回 std::nullopt，交给 inja
+static std::optional<Expression> compile_whole_expression(std::string_view s) {
+    if (s.size() < 5 || s.substr(0, 2) != "{{" || s.substr(s.size() - 2) != "}}") {
+        return std::nullopt;
+    }
+    std::string_view inner = s.substr(2, s.size() - 4);
+    if (inner.find("{{") != std::string_view::npos || inner.find("}}") != std::string_view::npos) {
+        return std::nullopt; // 多个表达式
+    }
+    return Expression::compile(inner);
+}
+
+static Value evaluate_expression(const Expression& expr, const Context& context) {
+    try {
+        return expr.evaluate(context);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error("Template render error: " + std::string(e.what()));
+    }
+}
+
+// 与 inja 的输出规则一致：字符串原样、null 为空，其余（含浮点，如 1.0）按 JSON 序列化
+static std::string stringify(const Value& value) {
+    if (value.is_string()) return value.get<std::string>();
+    if (value.is_null()) return "";
+    return value.dump();
+}
+
 std::string InjaTemplateRenderer::render(std::string_view template_str, const Context& context) {
-    // Use a static instance for simple, stateless rendering
-    static InjaTemplateRenderer renderer;
     try {
-        return renderer.env_.render(template_str, context);
+        return default_renderer().env_.render(template_str, context);
     } catch (const inja::InjaError& e) {
         throw std::runtime_error("Template render error: " + std::string(e.message));
     }
 }
 
+std::shared_ptr<const CompiledTemplate> InjaTemplateRenderer::compile(std::string_view template_str) {
+    auto compiled = std::make_shared<CompiledTemplate>();
+    compiled->source_ = std::string(template_str);
+    compiled->constant_ = !has_template_syntax(template_str);
+    if (compiled->constant_) {
+        compiled->text_ = compiled->source_;
+        return compiled;
+    }
+    compiled->expression_ = compile_whole_expression(template_str);
+    if (compiled->expression_ && compiled->expression_->is_constant()) {
+        // 常量折叠：不引用变量的表达式编译期求值一次；求值出错（如除零）则保留到运行期报错
+        try {
+            compiled->folded_ = compiled->expression_->evaluate(Context::object());
+            compiled->text_ = stringify(*compiled->folded_);
+            compiled->constant_ = true;
+            compiled->expression_.reset();
+            return compiled;
+        } catch (const std::runtime_error&) {
+        }
+    }
+    if (!compiled->expression_) {
+        try {
+            compiled->tmpl_ = default_renderer().env_.parse(template_str);
+        } catch (const inja::InjaError& e) {
+            throw std::runtime_error("Template parse error: " + std::string(e.message));
+        }
+    }
+    return compiled;
+}
+
+std::string InjaTemplateRenderer::render(const CompiledTemplate& tmpl, const Context& context) {
+    if (tmpl.constant_) {
+        return tmpl.text_;
+    }
+    if (tmpl.expression_) {
+        return stringify(evaluate_expression(*tmpl.expression_, context));
+    }
+    try {
+        return default_renderer().env_.render(tmpl.tmpl_, context);
+    } catch (const inja::InjaError& e) {
+        throw std::runtime_error("Template render error: " + std::string(e.message));
+    }
+}
+
+Value InjaTemplateRenderer::evaluate(const CompiledTemplate& tmpl, const Context& context) {
+    if (tmpl.folded_) {
+        return *tmpl.folded_;
+    }
+    if (tmpl.expression_) {
+        return evaluate_expression(*tmpl.expression_, context);
+    }
+    return render(tmpl, context);
+}
+
 std::string InjaTemplateRenderer::render_with_env(std::string_view template_str, const Context& context) {
     // Use the instance's environment for rendering
     try {
@@ -2,26 +2,59 @@
 #define AGENTICDSL_COMMON_UTILS_TEMPLATE_RENDERER_H
 
 #include "core/types/context.h" // 引入 Context (nlohmann::json)
+#include "expression.h"
 #include <inja/inja.hpp>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <filesystem> // Required by Inja for set_include_callback
 
 namespace agenticdsl {
 
+// 预编译模板：解析期编译一次，执行期直接渲染 AST
+// 不可变，clone 的节点及多个工作线程可共享同一实例
+class CompiledTemplate {
+public:
+    const std::string& source() const { return source_; }
+    bool is_constant() const { return constant_; } // 不含模板语法，或不引用变量的表达式已在编译期折叠
+    bool is_expression() const { return expression_.has_value(); } // 整段为 {{ expr }} 且可原生求值
+    bool is_variable() const { return expression_ && expression_->is_path(); } // 形如 {{ a.b.c }} 的纯变量引用
+    const std::optional<Value>& folded_value() const { return folded_; } // 折叠后的类型化结果
+
+private:
+    friend class InjaTemplateRenderer;
+    std::string source_;
+    bool constant_ = false;
+    std::string text_;             // constant_ 时的渲染结果
+    std::optional<Value> folded_;  // 常量折叠的表达式结果（如 {{ 60 * 60 }}）
+    std::optional<Expression> expression_; // 可原生求值时不经过 inja
+    inja::Template tmpl_;
+};
+
 class InjaTemplateRenderer {
 public:
     InjaTemplateRenderer();
 
-    // 静态方法：使用默认环境渲染模板
+    // 静态方法：使用默认环境渲染模板（每线程一个环境，可并发调用）
     static std::string render(std::string_view template_str, const Context& context);
 
+    // 编译模板；语法错误抛出 std::runtime_error
+    static std::shared_ptr<const CompiledTemplate> compile(std::string_view template_str);
+
+    // 渲染预编译模板（跳过词法/语法分析）
+    static std::string render(const CompiledTemplate& tmpl, const Context& context);
+
+    // 求值：整段表达式返回类型化的 JSON，其余模板返回渲染后的字符串
+    static Value evaluate(const CompiledTemplate& tmpl, const Context& context);
+
     // 实例方法：使用当前实例的环境渲染模板
     std::string render_with_env(std::string_view template_str, const Context& context);
 
 private:
     inja::Environment env_;
     void configure_security(); // 配置 Inja 环境以禁用不安全操作
+    static InjaTemplateRenderer& default_renderer();
 };
 
 } // namespace agenticdsl
@@ -1,83 +1,160 @@
 // common/utils/yaml_json.cpp
 #include "common/utils/yaml_json.h"
 #include <yaml-cpp/yaml.h>
+#include <yaml-cpp/eventhandler.h>
+#include <charconv>
+#include <cstdint>
+#include <istream>
 #include <stdexcept>
+#include <streambuf>
 #include <string>
-#include <iostream>
-#include <sstream> // For std::stringstream
-#include <cctype>  // For std::isdigit, std::isspace
+#include <unordered_map>
+#include <vector>
+#include <cctype>  // For std::isdigit
 
 namespace agenticdsl {
 
-// Helper: check if string is a valid integer
-inline bool is_integer(const std::string& s) {
-    if (s.empty()) return false;
-    size_t start = (s[0] == '-' || s[0] == '+') ? 1 : 0;
-    if (start >= s.size()) return false;
-    for (size_t i = start; i < s.size(); ++i) {
-        if (!std::isdigit(s[i])) return false;
+namespace {
+
+// 标量分类：true / false、~ / 空串为 null、整数（超出 int64 保留为字符串）、浮点，其余为字符串
+// 使用 std::from_chars，不为每个标量构造 istringstream
+nlohmann::json classify_scalar(const std::string& s) {
+    if (s == "true")  return true;
+    if (s == "false") return false;
+    if (s == "~" || s.empty()) return nullptr;
+
+    // from_chars 不接受前导 '+'，手动跳过；符号之后必须是数字或小数点（排除 +-1、inf、nan 等）
+    const char* first = s.data();
+    const char* last = s.data() + s.size();
+    const char* digits = first;
+    if (*first == '+') {
+        first = digits = first + 1;
+    } else if (*first == '-') {
+        digits = first + 1;
+    }
+    if (digits == last || !(std::isdigit(static_cast<unsigned char>(*digits)) || *digits == '.')) {
+        return s;
+    }
+
+    std::int64_t int_val = 0;
+    auto [int_end, int_ec] = std::from_chars(first, last, int_val);
+    if (int_end == last) {
+        if (int_ec == std::errc{}) return int_val;
+        return s; // 超出范围的整数保留为字符串
     }
-    return true;
-}
 
-// Helper: check if string is a valid float or integer (including scientific notation)
-inline bool is_numeric(const std::string& s) {
-    if (s.empty()) return false;
-
-    std::istringstream iss(s);
-    double d;
-    // Attempt to parse the string as a double
-    // This handles integers, floats, and scientific notation
-    iss >> d;
-
-    // Check if the entire string was consumed and represents a valid number
-    // iss.eof() checks if we reached the end of the string
-    // iss.fail() checks if the parsing failed
-    // iss.tellg() can also be used to check the position after parsing
-    return !iss.fail() && iss.eof();
+    double d_val = 0.0;
+    auto [dbl_end, dbl_ec] = std::from_chars(first, last, d_val);
+    if (dbl_ec == std::errc{} && dbl_end == last) return d_val;
+    return s;
 }
 
+// 在 string_view 上直接读取，避免复制块内容
+class ViewStreamBuf : public std::streambuf {
+public:
+    explicit ViewStreamBuf(std::string_view text) {
+        char* begin = const_cast<char*>(text.data());
+        setg(begin, begin, begin + text.size());
+    }
+};
+
+// YAML 事件 -> JSON：用容器栈增量构建，锚点按 id 记录已完成的值供别名复制
+class JsonEventBuilder : public YAML::EventHandler {
+public:
+    nlohmann::json take_root() { return std::move(root_); }
+
+    void OnDocumentStart(const YAML::Mark&) override {}
+    void OnDocumentEnd() override {}
+
+    void OnNull(const YAML::Mark&, YAML::anchor_t anchor) override {
+        if (expecting_key()) throw std::runtime_error("Unsupported null YAML map key");
+        complete(nullptr, anchor);
+    }
+
+    void OnAlias(const YAML::Mark&, YAML::anchor_t anchor) override {
+        auto it = anchors_.find(anchor);
+        if (it == anchors_.end()) throw std::runtime_error("Unknown YAML alias");
+        if (expecting_key()) {
+            stack_.back().key = it->second.is_string() ? it->second.get<std::string>() : it->second.dump();
+            stack_.back().has_key = true;
+            return;
+        }
+        complete(it->second, YAML::NullAnchor);
+    }
+
+    void OnScalar(const YAML::Mark&, const std::string&, YAML::anchor_t anchor, const std::string& value) override {
+        if (expecting_key()) {
+            // 键保持原始文本，不做类型分类
+            stack_.back().key = value;
+            stack_.back().has_key = true;
+            if (anchor != YAML::NullAnchor) anchors_[anchor] = value;
+            return;
+        }
+        complete(classify_scalar(value), anchor);
+    }
+
+    void OnSequenceStart(const YAML::Mark&, const std::string&, YAML::anchor_t anchor, YAML::EmitterStyle::value) override {
+        if (expecting_key()) throw std::runtime_error("Unsupported non-scalar YAML map key");
+        stack_.emplace_back(nlohmann::json::array(), anchor);
+    }
+
+    void OnSequenceEnd() override { close_container(); }
+
+    void OnMapStart(const YAML::Mark&, const std::string&, YAML::anchor_t anchor, YAML::EmitterStyle::value) override {
+        if (expecting_key()) throw std::runtime_error("Unsupported non-scalar YAML map key");
+        stack_.emplace_back(nlohmann::json::object(), anchor);
+    }
+
+    void OnMapEnd() override { close_container(); }
+
+private:
+    struct Frame {
+        Frame(nlohmann::json v, YAML::anchor_t a) : value(std::move(v)), anchor(a) {}
+
+        nlohmann::json value;
+        YAML::anchor_t anchor = YAML::NullAnchor;
+        std::string key;
+        bool has_key = false;
+    };
+
+    bool expecting_key() const {
+        return !stack_.empty() && stack_.back().value.is_object() && !stack_.back().has_key;
+    }
+
+    void close_container() {
+        Frame frame = std::move(stack_.back());
+        stack_.pop_back();
+        complete(std::move(frame.value), frame.anchor);
+    }
+
+    void complete(nlohmann::json value, YAML::anchor_t anchor) {
+        if (anchor != YAML::NullAnchor) anchors_[anchor] = value;
+        if (stack_.empty()) {
+            root_ = std::move(value);
+            return;
+        }
+        Frame& parent = stack_.back();
+        if (parent.value.is_array()) {
+            parent.value.push_back(std::move(value));
+        } else {
+            parent.value[parent.key] = std::move(value); // 重复键：后者覆盖，与 yaml_to_json 一致
+            parent.has_key = false;
+        }
+    }
+
+    std::vector<Frame> stack_;
+    std::unordered_map<YAML::anchor_t, nlohmann::json> anchors_;
+    nlohmann::json root_;
+};
+
+} // namespace
+
 nlohmann::json yaml_to_json(const YAML::Node& node) {
     switch (node.Type()) {
         case YAML::NodeType::Null:
             return nullptr;
-        case YAML::NodeType::Scalar: {
-            const std::string& s = node.Scalar();
-            // std::cerr << "[YAML Scalar] raw='" << s << "'" << std::endl; // Debug
-
-            // Check for boolean literals
-            if (s == "true")  return true;
-            if (s == "false") return false;
-
-            // Check for null literals
-            if (s == "~" || s.empty()) return nullptr;
-
-            // Attempt numeric conversion
-            if (is_numeric(s)) {
-                try {
-                    // First, try parsing as long long to handle integers
-                    if (is_integer(s)) {
-                         // Check for potential overflow before parsing as long long
-                         // This is a basic check; more robust overflow handling might be needed
-                         // For now, rely on stoll's exception on overflow
-                         long long ll_val = std::stoll(s);
-                         return ll_val;
-                    } else {
-                         // If not a simple integer string, parse as double
-                         double d_val = std::stod(s);
-                         return d_val;
-                    }
-                } catch (const std::out_of_range& e) {
-                    // If stoll/stod fails due to range, treat as string
-                    // std::cerr << "[DEBUG] Numeric parsing failed due to range: " << s << std::endl;
-                } catch (const std::invalid_argument& e) {
-                    // This shouldn't happen if is_numeric returned true, but just in case
-                    // std::cerr << "[DEBUG] Numeric parsing failed due to invalid argument: " << s << std::endl;
-                }
-            }
-            // Fallback to string
-            return s;
-        }
+        case YAML::NodeType::Scalar:
+            return classify_scalar(node.Scalar());
         case YAML::NodeType::Sequence: {
             nlohmann::json arr = nlohmann::json::array();
             for (const auto& item : node) {
@@ -98,4 +175,13 @@ nlohmann::json yaml_to_json(const YAML::Node& node) {
     }
 }
 
+nlohmann::json parse_yaml_to_json(std::string_view yaml_text) {
+    ViewStreamBuf buf(yaml_text);
+    std::istream in(&buf);
+    YAML::Parser parser(in);
+    JsonEventBuilder builder;
+    parser.HandleNextDocument(builder);
+    return builder.take_root();
+}
+
 } // namespace agenticdsl
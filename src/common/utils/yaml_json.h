@@ -3,12 +3,17 @@
 
 #include <nlohmann/json.hpp>
 #include <yaml-cpp/yaml.h>
+#include <string_view>
 
 namespace agenticdsl {
 
 // 将 YAML::Node 转换为 nlohmann::json
 nlohmann::json yaml_to_json(const YAML::Node& node);
 
+// 直接由 YAML 事件流构建 nlohmann::json，不经过中间的 YAML::Node 树（只读取第一个文档）
+// 标量分类规则与 yaml_to_json 一致；语法错误抛出 YAML::ParserException
+nlohmann::json parse_yaml_to_json(std::string_view yaml_text);
+
 } // namespace agenticdsl
 
 #endif // AGENTICDSL_COMMON_UTILS_YAML_JSON_H
@@ -3,15 +3,34 @@
 #include "common/llm/llama_adapter.h"
 #include "modules/scheduler/topo_scheduler.h"
 #include "modules/system/system_nodes.h"
+#include "modules/parser/graph_cache.h"
+#include "modules/optimizer/graph_optimizer.h"
+#include "modules/library/library_loader.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <thread>
 #include <stdexcept>
 #include <filesystem>
+#include <unordered_set>
 
 namespace agenticdsl {
 
+static ParsedGraph clone_graph(const ParsedGraph& source) {
+    ParsedGraph graph;
+    graph.path = source.path;
+    graph.metadata = source.metadata;
+    graph.signature = source.signature;
+    graph.compiled_signature = source.compiled_signature;
+    graph.permissions = source.permissions;
+    graph.is_standard_library = source.is_standard_library;
+    graph.output_schema = source.output_schema;
+    for (const auto& node : source.nodes) {
+        if (node) graph.nodes.push_back(node->clone());
+    }
+    return graph;
+}
+
 static LlamaAdapter::Config load_llm_config(const std::string& config_path = "llm_config.json") {
     namespace fs = std::filesystem;
 
@@ -33,12 +52,11 @@ static LlamaAdapter::Config load_llm_config(const std::string& config_path = "ll
         nlohmann::json j;
         file >> j;
 
+        // 模型路径相对配置文件所在目录解析
+        const fs::path config_dir = fs::weakly_canonical(fs::absolute(config_path)).parent_path();
+
         if (j.contains("model_path") && j["model_path"].is_string()) {
-            std::string model_rel = j["model_path"].get<std::string>();
-            // Resolve relative to config file's directory (or current dir)
-            fs::path config_dir = fs::weakly_canonical(fs::absolute(config_path)).parent_path();
-fs::path abs_model_path = fs::absolute(config_dir / model_rel);
-            config.model_path = abs_model_path.string();
+            config.model_path = fs::absolute(config_dir / j["model_path"].get<std::string>()).string();
         }
 
         if (j.contains("n_ctx") && j["n_ctx"].is_number_integer()) {
@@ -57,6 +75,27 @@ fs::path abs_model_path = fs::absolute(config_dir / model_rel);
         if (j.contains("n_predict") && j["n_predict"].is_number_integer()) {
             config.n_predict = j["n_predict"].get<int>();
         }
+        if (j.contains("n_parallel") && j["n_parallel"].is_number_integer()) {
+            config.n_parallel = j["n_parallel"].get<int>();
+        }
+        if (j.contains("n_batch") && j["n_batch"].is_number_integer()) {
+            config.n_batch = j["n_batch"].get<int>();
+        }
+        if (j.contains("n_ubatch") && j["n_ubatch"].is_number_integer()) {
+            config.n_ubatch = j["n_ubatch"].get<int>();
+        }
+        if (j.contains("n_keep") && j["n_keep"].is_number_integer()) {
+            config.n_keep = j["n_keep"].get<int>();
+        }
+        if (j.contains("context_shift") && j["context_shift"].is_boolean()) {
+            config.context_shift = j["context_shift"].get<bool>();
+        }
+        if (j.contains("draft_model_path") && j["draft_model_path"].is_string()) {
+            config.draft_model_path = fs::absolute(config_dir / j["draft_model_path"].get<std::string>()).string();
+        }
+        if (j.contains("n_draft") && j["n_draft"].is_number_integer()) {
+            config.n_draft = j["n_draft"].get<int>();
+        }
     } catch (const std::exception& e) {
         // Log or ignore; use defaults
     }
@@ -65,9 +104,11 @@ fs::path abs_model_path = fs::absolute(config_dir / model_rel);
 }
 
 std::unique_ptr<DSLEngine> DSLEngine::from_markdown(const std::string& markdown_content) {
-    MarkdownParser parser;
-    auto graphs = parser.parse_from_string(markdown_content);
+    MarkdownParser parser(0); // 块数足够多时按核数并行解析
+    return from_graphs(parser.parse_from_string(markdown_content));
+}
 
+std::unique_ptr<DSLEngine> DSLEngine::from_graphs(std::vector<ParsedGraph> graphs) {
     // Ensure /main exists
     bool has_main = false;
     for (const auto& g : graphs) {
@@ -97,7 +138,11 @@ std::unique_ptr<DSLEngine> DSLEngine::from_file(const std::string& file_path) {
 
     std::stringstream buffer;
     buffer << file.rdbuf();
-    return from_markdown(buffer.str());
+
+    // 文件来源的图经由编译缓存加载，源文本未变化时跳过 Markdown/YAML 解析
+    MarkdownParser parser(0);
+    GraphCache cache;
+    return from_graphs(cache.load(buffer.str(), parser));
 }
 
 DSLEngine::DSLEngine(std::vector<ParsedGraph> initial_graphs)
@@ -106,7 +151,38 @@ DSLEngine::DSLEngine(std::vector<ParsedGraph> initial_graphs)
     std::cout << "Graphs loaded: " << full_graphs_.size() << std::endl;
 }
 
+void DSLEngine::load_referenced_libraries(const LibrarySnapshot& library) {
+    std::unordered_set<NodePath> known;
+    for (const auto& graph : full_graphs_) {
+        known.insert(graph.path);
+        for (const auto& node : graph.nodes) {
+            if (node) known.insert(node->path);
+        }
+    }
+
+    // 按下标遍历：新加入的库子图也会被扫描，处理库之间的引用
+    for (size_t i = 0; i < full_graphs_.size(); ++i) {
+        std::vector<NodePath> refs;
+        for (const auto& node : full_graphs_[i].nodes) {
+            if (node) refs.insert(refs.end(), node->next.begin(), node->next.end());
+        }
+        for (const auto& ref : refs) {
+            if (ref.rfind("/lib/", 0) != 0 || known.count(ref) > 0) continue;
+            const ParsedGraph* lib = library.find_graph(ref);
+            if (!lib || !known.insert(lib->path).second) continue; // 未找到时由 build_dag 报告缺失的节点
+            for (const auto& node : lib->nodes) {
+                if (node) known.insert(node->path);
+            }
+            full_graphs_.push_back(clone_graph(*lib));
+        }
+    }
+}
+
 ExecutionResult DSLEngine::run(const Context& context) {
+    // 整个运行（引用解析与会话内的 available_subgraphs）使用同一快照，热更新不会让一次运行混用两个版本的库
+    auto library = StandardLibraryLoader::instance().snapshot();
+    load_referenced_libraries(*library);
+
     // 提取预算（从 /__meta__）
     std::optional<ExecutionBudget> budget;
     for (auto& g : full_graphs_) {
@@ -119,20 +195,23 @@ ExecutionResult DSLEngine::run(const Context& context) {
     // 创建调度器
     TopoScheduler::Config config;
     config.initial_budget = std::move(budget);
+    config.llm_stream = llm_stream_callback_;
+    config.library = std::move(library);
     TopoScheduler scheduler(std::move(config), tool_registry_, llama_adapter_.get(), &full_graphs_);
 
-    // 注册所有节点（包括系统节点）
-    auto sys_nodes = create_system_nodes();
-    for (auto& node : sys_nodes) {
-        scheduler.register_node(std::move(node));
-    }
+    // 收集所有节点（包括系统节点），优化后再注册
+    auto nodes = create_system_nodes();
     for (const auto& graph : full_graphs_) {
         for (const auto& node : graph.nodes) {
             if (node) {
-                scheduler.register_node(node->clone());
+                nodes.push_back(node->clone());
             }
         }
     }
+    GraphOptimizer().optimize(nodes, GraphOptimizer::find_entry_point(full_graphs_));
+    for (auto& node : nodes) {
+        scheduler.register_node(std::move(node));
+    }
     scheduler.build_dag();
 
     auto result = scheduler.execute(context);
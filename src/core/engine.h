@@ -33,13 +33,21 @@ public:
 
     LlamaAdapter* get_llm_adapter() { return llama_adapter_.get(); }
 
+    // LLM 节点生成时逐段回调（可能在推理线程上调用）；返回 false 提前停止该节点
+    void set_llm_stream_callback(LLMStreamCallback cb) { llm_stream_callback_ = std::move(cb); }
+
     DSLEngine(std::vector<ParsedGraph> initial_graphs);
 private:
+    // 校验 /main 存在并创建引擎
+    static std::unique_ptr<DSLEngine> from_graphs(std::vector<ParsedGraph> graphs);
+    // 把 next 引用到、但尚未加载的 /lib/ 子图从给定的标准库快照按需加入 full_graphs_
+    void load_referenced_libraries(const LibrarySnapshot& library);
 
     std::vector<ParsedGraph> full_graphs_;
     ToolRegistry tool_registry_;          // ← 成员变量（非单例）
     std::unique_ptr<LlamaAdapter> llama_adapter_;
     std::vector<TraceRecord> last_traces_; // ← 存储 Trace
+    LLMStreamCallback llm_stream_callback_;
 };
 
 } // namespace agenticdsl
@@ -4,6 +4,7 @@
 #include "context.h" // 引入 Context/Value
 #include <chrono>
 #include <optional>
+#include <string>
 #include <atomic> // For atomic budget counters (v3.1 requirement)
 
 namespace agenticdsl {
@@ -18,8 +19,8 @@ struct ExecutionBudget {
     int max_subgraph_depth = -1;
     int max_snapshots = -1;           // -1 表示无限制
     size_t snapshot_max_size_kb = 512;
-
-
+    std::string snapshot_format = "cbor";  // 快照编码: cbor / msgpack / json
+    bool snapshot_compression = true;      // 冷快照是否 LZ 压缩
 
     // Use atomic integers for thread-safe budget updates
     mutable std::atomic<int> nodes_used{0};
@@ -38,6 +39,8 @@ struct ExecutionBudget {
           max_subgraph_depth(other.max_subgraph_depth),
           max_snapshots(other.max_snapshots),
           snapshot_max_size_kb(other.snapshot_max_size_kb),
+          snapshot_format(std::move(other.snapshot_format)),
+          snapshot_compression(other.snapshot_compression),
           nodes_used(0), // 重置计数器！
           llm_calls_used(0),
           subgraph_depth_used(0),
@@ -53,6 +56,8 @@ struct ExecutionBudget {
             max_subgraph_depth = other.max_subgraph_depth;
             max_snapshots = other.max_snapshots;
             snapshot_max_size_kb = other.snapshot_max_size_kb;
+            snapshot_format = std::move(other.snapshot_format);
+            snapshot_compression = other.snapshot_compression;
             // 重置原子计数器（不移动 other 的值）
             nodes_used = 0;
             llm_calls_used = 0;
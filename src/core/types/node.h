@@ -32,6 +32,10 @@ enum class NodeType : uint8_t {
 
 // Forward declarations for Node structure
 class InjaTemplateRenderer; // Declared here, defined elsewhere
+class CompiledTemplate;     // 解析期预编译的模板（common/utils/template_renderer.h）
+using CompiledTemplatePtr = std::shared_ptr<const CompiledTemplate>;
+class Signature;            // 解析期编译的签名校验器（common/utils/signature.h）
+using SignaturePtr = std::shared_ptr<const Signature>;
 
 // Base Node
 struct Node {
@@ -41,6 +45,7 @@ struct Node {
     nlohmann::json metadata;
 
     std::optional<std::string> signature;     // e.g., "(input: string) -> {result: number}"
+    SignaturePtr compiled_signature;          // 可选，由 parser 填充
     std::vector<std::string> permissions;     // e.g., ["network", "file:read"]
 
     Node(NodePath path,
@@ -67,9 +72,10 @@ struct ParsedGraph {
     nlohmann::json metadata; // graph-level metadata
     std::optional<ExecutionBudget> budget; // 从 /__meta__ 解析
     std::optional<std::string> signature; // 子图签名
+    SignaturePtr compiled_signature; // 签名可解析时由 parser 填充
     std::vector<std::string> permissions; // 子图权限
     bool is_standard_library = false; // 路径以 /lib/ 开头
-    std::optional<nlohmann::json> output_schema; // v3.1: 解析 signature.outputs 为 JSON Schema
+    std::optional<nlohmann::json> output_schema; // v3.1: signature.outputs，形如 [{name, type, required}]
     
     ParsedGraph() = default;
     ParsedGraph(ParsedGraph&&) = default;                // 允许移动
@@ -96,6 +102,7 @@ struct EndNode : public Node {
 // Assign Node (v1.1: renamed from Set)
 struct AssignNode : public Node {
     std::unordered_map<std::string, std::string> assign;
+    std::unordered_map<std::string, CompiledTemplatePtr> compiled_assign; // 可选，由 parser 填充
 
     AssignNode(NodePath path,
                std::unordered_map<std::string, std::string> assigns,
@@ -107,6 +114,7 @@ struct AssignNode : public Node {
 // DSL Node (for LLM-generated DSL, v3.10 - replaces LLMCallNode)
 struct DSLNode : public Node {
     std::string prompt_template;
+    CompiledTemplatePtr compiled_prompt; // 可选，由 parser 填充
     std::string llm_tool_name;  // e.g., "llama-7b", "gpt-4"
     LLMParams llm_params;       // Generation parameters
     std::vector<std::string> output_keys;
@@ -139,6 +147,7 @@ struct LLMCallNode : public Node {
 struct ToolCallNode : public Node {
     std::string tool_name;
     std::unordered_map<std::string, std::string> arguments;
+    std::unordered_map<std::string, CompiledTemplatePtr> compiled_arguments; // 可选，由 parser 填充
     std::vector<std::string> output_keys;
 
     ToolCallNode(NodePath path,
@@ -190,6 +199,9 @@ struct GenerateSubgraphNode : public Node {
     std::vector<std::string> output_keys; // e.g., ["generated_graph_path"]
     std::string signature_validation = "strict"; // v3.1: strict, warn, ignore
     std::optional<NodePath> on_signature_violation; // v3.1
+    size_t max_subgraphs = 0; // 只注入与提示最相关的前 k 个 available_subgraphs；0 = 全部
+    bool constrain_output = true; // 用块格式语法约束解码，输出只含 AgenticDSL 块
+    std::string llm_tool_name;    // 经 ToolRegistry 调用的 LLM 工具；空 = 引擎的 LlamaAdapter
 
     GenerateSubgraphNode(NodePath path, std::string prompt, std::vector<std::string> output_keys, std::vector<NodePath> next_paths = {});
     [[nodiscard]] Context execute(Context& context) override; // Implementation in executor
@@ -198,6 +210,7 @@ struct GenerateSubgraphNode : public Node {
 
 struct AssertNode : public Node {
     std::string condition; // Inja boolean expression
+    CompiledTemplatePtr compiled_condition; // 可选，由 parser 填充
     std::optional<NodePath> on_failure; // Jump path on failure
 
     AssertNode(NodePath path, std::string condition, std::optional<NodePath> on_fail, std::vector<NodePath> next_paths = {});
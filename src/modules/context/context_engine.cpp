@@ -8,13 +8,6 @@ namespace agenticdsl {
 
 // --- Helper functions ---
 
-// Calculate approximate size of a JSON object in KB
-inline size_t estimate_json_size_kb(const nlohmann::json& j) {
-    std::ostringstream oss;
-    oss << j; // This is a very rough estimation
-    return (oss.str().size() + 1023) / 1024; // Round up to KB
-}
-
 // Get merge strategy for a specific path based on policies
 inline MergeStrategy get_merge_strategy_for_path(const std::string& path, const ContextMergePolicy& policy) {
     // Check for exact match first
@@ -138,48 +131,61 @@ void ContextEngine::merge_scalar(Context& target_val, const Context& source_val,
 
 
 void ContextEngine::save_snapshot(const NodePath& key, const Context& ctx) {
-    // Calculate size before adding
-    size_t new_snapshot_size_kb = estimate_json_size_kb(ctx);
-
-    // Check if adding this snapshot would exceed limits
-    if (snapshots_.size() >= max_snapshots_ || (current_total_size_kb_ + new_snapshot_size_kb) > max_snapshot_size_kb_) {
-        // Enforce budget before adding
-        enforce_snapshot_budget();
-        // Re-check after enforcement
-        if (snapshots_.size() >= max_snapshots_ || (current_total_size_kb_ + new_snapshot_size_kb) > max_snapshot_size_kb_) {
-            // Still over budget, cannot add. Log or ignore.
-            std::cerr << "[WARNING] Cannot save snapshot, budget exceeded after enforcement. Key: " << key << std::endl;
-            return;
-        }
+    if (max_snapshots_ == 0) {
+        std::cerr << "[WARNING] Cannot save snapshot, snapshots disabled by budget. Key: " << key << std::endl;
+        return;
     }
 
-    // Add snapshot
-    snapshots_[key] = ctx; // Deep copy
-    snapshot_order_.push_back(key);
-    current_total_size_kb_ += new_snapshot_size_kb;
+    // 快照以二进制形式保存，大小按编码字节数计
+    EncodedSnapshot snapshot = encode_snapshot(ctx, snapshot_format_);
+    const size_t max_bytes = max_snapshot_size_kb_ * 1024;
+    if (snapshot.size_bytes() > max_bytes && compress_cold_snapshots_) {
+        snapshot = compress_snapshot(std::move(snapshot));
+    }
+    if (snapshot.size_bytes() > max_bytes) {
+        // 单个快照就超过预算，无论如何都放不下
+        std::cerr << "[WARNING] Cannot save snapshot, budget exceeded after enforcement. Key: " << key << std::endl;
+        return;
+    }
+
+    erase_snapshot(key); // 同一键覆盖旧快照
+    add_snapshot(key, std::move(snapshot));
+    compress_cold_snapshots();
+    enforce_snapshot_budget(); // FIFO 淘汰最旧的快照，新快照已保证可容纳
 }
 
-const Context* ContextEngine::get_snapshot(const NodePath& key) const {
+std::optional<Context> ContextEngine::get_snapshot(const NodePath& key) const {
     auto it = snapshots_.find(key);
     if (it != snapshots_.end()) {
-        return &(it->second);
+        return decode_snapshot(it->second);
+    }
+    return std::nullopt; // Not found
+}
+
+std::optional<std::vector<std::uint8_t>> ContextEngine::export_snapshot(const NodePath& key) const {
+    auto it = snapshots_.find(key);
+    if (it == snapshots_.end()) {
+        return std::nullopt;
     }
-    return nullptr; // Not found
+    return serialize_snapshot(it->second);
+}
+
+void ContextEngine::import_snapshot(const NodePath& key, const std::vector<std::uint8_t>& blob) {
+    EncodedSnapshot snapshot = deserialize_snapshot(blob);
+    erase_snapshot(key);
+    add_snapshot(key, std::move(snapshot));
+    compress_cold_snapshots();
+    enforce_snapshot_budget();
 }
 
 void ContextEngine::enforce_snapshot_budget() {
+    const size_t max_bytes = max_snapshot_size_kb_ * 1024;
     while (!snapshot_order_.empty() && (
                snapshots_.size() > max_snapshots_ ||
-               current_total_size_kb_ > max_snapshot_size_kb_
+               current_total_size_bytes_ > max_bytes
            )) {
         NodePath oldest_key = snapshot_order_.front();
-        snapshot_order_.erase(snapshot_order_.begin());
-
-        auto it = snapshots_.find(oldest_key);
-        if (it != snapshots_.end()) {
-            current_total_size_kb_ -= estimate_json_size_kb(it->second);
-            snapshots_.erase(it);
-        }
+        erase_snapshot(oldest_key);
     }
 }
 
@@ -189,4 +195,45 @@ void ContextEngine::set_snapshot_limits(size_t max_count, size_t max_size_kb) {
     enforce_snapshot_budget(); // Apply new limits immediately
 }
 
+void ContextEngine::set_snapshot_encoding(SnapshotFormat format, bool compress_cold, size_t hot_count) {
+    snapshot_format_ = format;
+    compress_cold_snapshots_ = compress_cold;
+    hot_snapshot_count_ = hot_count;
+    // 已有快照保持原编码（EncodedSnapshot 自带格式），只对冷快照补做压缩
+    compress_cold_snapshots();
+    enforce_snapshot_budget();
+}
+
+void ContextEngine::add_snapshot(const NodePath& key, EncodedSnapshot snapshot) {
+    current_total_size_bytes_ += snapshot.size_bytes();
+    snapshots_[key] = std::move(snapshot);
+    snapshot_order_.push_back(key);
+}
+
+void ContextEngine::erase_snapshot(const NodePath& key) {
+    auto it = snapshots_.find(key);
+    if (it == snapshots_.end()) {
+        return;
+    }
+    current_total_size_bytes_ -= it->second.size_bytes();
+    snapshots_.erase(it);
+    snapshot_order_.erase(std::remove(snapshot_order_.begin(), snapshot_order_.end(), key), snapshot_order_.end());
+}
+
+void ContextEngine::compress_cold_snapshots() {
+    if (!compress_cold_snapshots_ || snapshot_order_.size() <= hot_snapshot_count_) {
+        return;
+    }
+    // snapshot_order_ 从旧到新，最后 hot_snapshot_count_ 个保持热（未压缩）
+    size_t cold_count = snapshot_order_.size() - hot_snapshot_count_;
+    for (size_t i = 0; i < cold_count; ++i) {
+        EncodedSnapshot& snapshot = snapshots_.at(snapshot_order_[i]);
+        if (snapshot.compressed) continue;
+        size_t before = snapshot.size_bytes();
+        snapshot = compress_snapshot(std::move(snapshot));
+        current_total_size_bytes_ -= before;
+        current_total_size_bytes_ += snapshot.size_bytes();
+    }
+}
+
 } // namespace agenticdsl
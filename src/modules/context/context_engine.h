@@ -4,9 +4,11 @@
 
 #include "core/types/context.h" // 引入 Context, Value
 #include "core/types/node.h"    // 引入 NodePath
+#include "common/utils/snapshot_codec.h" // 引入 EncodedSnapshot
 #include <nlohmann/json.hpp>
 #include <unordered_map>
 #include <functional>
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <vector>
@@ -44,8 +46,12 @@ public:
     // 保存快照
     void save_snapshot(const NodePath& key, const Context& ctx);
 
-    // 获取快照（只读）
-    const Context* get_snapshot(const NodePath& key) const;
+    // 获取快照（解码后的副本）
+    std::optional<Context> get_snapshot(const NodePath& key) const;
+
+    // 导出 / 导入单个快照的自描述二进制形式（用于持久化执行状态）
+    std::optional<std::vector<std::uint8_t>> export_snapshot(const NodePath& key) const;
+    void import_snapshot(const NodePath& key, const std::vector<std::uint8_t>& blob);
 
     // 清理快照（FIFO，根据 max_count 和 max_size）
     void enforce_snapshot_budget();
@@ -53,12 +59,25 @@ public:
     // 设置快照预算限制
     void set_snapshot_limits(size_t max_count, size_t max_size_kb);
 
+    // 设置快照编码：最近 hot_count 个快照不压缩，更早的（冷）快照按需 LZ 压缩
+    void set_snapshot_encoding(SnapshotFormat format, bool compress_cold, size_t hot_count = 1);
+
+    // 当前快照占用的编码字节数
+    size_t snapshot_bytes() const { return current_total_size_bytes_; }
+
 private:
-    std::unordered_map<NodePath, Context> snapshots_;
+    std::unordered_map<NodePath, EncodedSnapshot> snapshots_;
     std::vector<NodePath> snapshot_order_; // 用于 FIFO
     size_t max_snapshots_ = 10; // 可配置，默认 dev=10, prod=0
     size_t max_snapshot_size_kb_ = 512; // 可配置
-    size_t current_total_size_kb_ = 0; // 估算的总大小
+    size_t current_total_size_bytes_ = 0; // 编码后的总大小
+    SnapshotFormat snapshot_format_ = SnapshotFormat::CBOR;
+    bool compress_cold_snapshots_ = true;
+    size_t hot_snapshot_count_ = 1;
+
+    void add_snapshot(const NodePath& key, EncodedSnapshot snapshot);
+    void erase_snapshot(const NodePath& key);
+    void compress_cold_snapshots();
 
     // Helper for merging
     static void merge_recursive(Context& target, const Context& source, const std::string& path_prefix, const ContextMergePolicy& policy);
@@ -20,6 +20,7 @@ std::unique_ptr<Node> StartNode::clone() const {
     auto node = std::make_unique<StartNode>(path, next);
     node->metadata = metadata;
     node->signature = signature;
+    node->compiled_signature = compiled_signature;
     node->permissions = permissions;
     return node;
 }
@@ -40,6 +41,7 @@ std::unique_ptr<Node> EndNode::clone() const {
     node->next = next;
     node->metadata = metadata;
     node->signature = signature;
+    node->compiled_signature = compiled_signature;
     node->permissions = permissions;
     return node;
 }
@@ -60,8 +62,10 @@ Context AssignNode::execute(Context& context) {
 
 std::unique_ptr<Node> AssignNode::clone() const {
     auto node = std::make_unique<AssignNode>(path, assign, next);
+    node->compiled_assign = compiled_assign;
     node->metadata = metadata;
     node->signature = signature;
+    node->compiled_signature = compiled_signature;
     node->permissions = permissions;
     return node;
 }
@@ -86,6 +90,7 @@ std::unique_ptr<Node> LLMCallNode::clone() const {
     auto node = std::make_unique<LLMCallNode>(path, prompt_template, output_keys, next);
     node->metadata = metadata;
     node->signature = signature;
+    node->compiled_signature = compiled_signature;
     node->permissions = permissions;
     return node;
 }
@@ -112,8 +117,10 @@ Context DSLNode::execute(Context& context) {
 
 std::unique_ptr<Node> DSLNode::clone() const {
     auto node = std::make_unique<DSLNode>(path, prompt_template, llm_tool_name, llm_params, output_keys, next);
+    node->compiled_prompt = compiled_prompt;
     node->metadata = metadata;
     node->signature = signature;
+    node->compiled_signature = compiled_signature;
     node->permissions = permissions;
     return node;
 }
@@ -137,8 +144,10 @@ Context ToolCallNode::execute(Context& context) {
 
 std::unique_ptr<Node> ToolCallNode::clone() const {
     auto node = std::make_unique<ToolCallNode>(path, tool_name, arguments, output_keys, next);
+    node->compiled_arguments = compiled_arguments;
     node->metadata = metadata;
     node->signature = signature;
+    node->compiled_signature = compiled_signature;
     node->permissions = permissions;
     return node;
 }
@@ -182,6 +191,7 @@ std::unique_ptr<Node> ForkNode::clone() const {
     auto node = std::make_unique<ForkNode>(path, branches, next);
     node->metadata = metadata;
     node->signature = signature;
+    node->compiled_signature = compiled_signature;
     node->permissions = permissions;
     return node;
 }
@@ -203,6 +213,7 @@ std::unique_ptr<Node> JoinNode::clone() const {
     auto node = std::make_unique<JoinNode>(path, wait_for, merge_strategy, next);
     node->metadata = metadata;
     node->signature = signature;
+    node->compiled_signature = compiled_signature;
     node->permissions = permissions;
     return node;
 }
@@ -224,9 +235,13 @@ std::unique_ptr<Node> GenerateSubgraphNode::clone() const {
     auto node = std::make_unique<GenerateSubgraphNode>(path, prompt_template, output_keys, next);
     node->metadata = metadata;
     node->signature = signature;
+    node->compiled_signature = compiled_signature;
     node->permissions = permissions;
     node->signature_validation = signature_validation;
     node->on_signature_violation = on_signature_violation;
+    node->max_subgraphs = max_subgraphs;
+    node->constrain_output = constrain_output;
+    node->llm_tool_name = llm_tool_name;
     return node;
 }
 
@@ -245,8 +260,10 @@ Context AssertNode::execute(Context& context) {
 
 std::unique_ptr<Node> AssertNode::clone() const {
     auto node = std::make_unique<AssertNode>(path, condition, on_failure, next);
+    node->compiled_condition = compiled_condition;
     node->metadata = metadata;
     node->signature = signature;
+    node->compiled_signature = compiled_signature;
     node->permissions = permissions;
     return node;
 }
@@ -2,14 +2,74 @@
 #include "executor/node_executor.h"
 #include "common/utils/template_renderer.h" // 引入 InjaTemplateRenderer (for rendering)
 #include "modules/parser/markdown_parser.h" // ← 新增：包含 MarkdownParser
+#include "modules/parser/streaming_parser.h"
+#include "modules/parser/dsl_grammar.h"
+#include "common/utils/signature.h"
 #include <stdexcept>
+#include <exception>
 #include <inja/inja.hpp> // For RenderError
 #include <algorithm> // For std::find
+#include <iostream>
+#include <unordered_set>
 #include <thread> // For std::this_thread::sleep_for (if needed for mock)
 #include <chrono> // For std::chrono_literals
 
 namespace agenticdsl {
 
+namespace {
+
+// 优先使用 parser 预编译的模板；动态构造的节点没有预编译结果时回退到按源码渲染
+std::string render_template(const CompiledTemplatePtr& compiled, const std::string& source, const Context& ctx) {
+    if (compiled) {
+        return InjaTemplateRenderer::render(*compiled, ctx);
+    }
+    return InjaTemplateRenderer::render(source, ctx);
+}
+
+template <typename Map>
+CompiledTemplatePtr find_compiled(const Map& compiled, const std::string& key) {
+    auto it = compiled.find(key);
+    return it != compiled.end() ? it->second : nullptr;
+}
+
+// 生成子图中各节点会写入的顶层上下文键（assign 的 a.b 记为 a）
+std::unordered_set<std::string> written_keys(const ParsedGraph& graph) {
+    std::unordered_set<std::string> keys;
+    auto add = [&keys](const std::string& key) { keys.insert(key.substr(0, key.find('.'))); };
+    auto add_all = [&add](const std::vector<std::string>& output_keys) {
+        for (const auto& key : output_keys) add(key);
+    };
+    for (const auto& node : graph.nodes) {
+        switch (node->type) {
+            case NodeType::ASSIGN:
+                for (const auto& [key, _] : static_cast<const AssignNode*>(node.get())->assign) add(key);
+                break;
+            case NodeType::DSL_CALL:
+                add_all(static_cast<const DSLNode*>(node.get())->output_keys);
+                break;
+            case NodeType::TOOL_CALL:
+                add_all(static_cast<const ToolCallNode*>(node.get())->output_keys);
+                break;
+            case NodeType::GENERATE_SUBGRAPH:
+                add_all(static_cast<const GenerateSubgraphNode*>(node.get())->output_keys);
+                break;
+            default:
+                break;
+        }
+    }
+    return keys;
+}
+
+// 生成子图的签名校验：签名须可解析，且必填输出都有节点写入
+std::optional<std::string> check_generated_signature(const ParsedGraph& graph) {
+    if (!graph.compiled_signature) {
+        return "invalid signature '" + graph.signature.value_or("") + "'";
+    }
+    return graph.compiled_signature->check_declared_outputs(written_keys(graph));
+}
+
+} // namespace
+
 NodeExecutor::NodeExecutor(ToolRegistry& tool_registry, LlamaAdapter* llm_adapter)
     : tool_registry_(tool_registry), llm_adapter_(llm_adapter), markdown_parser_() {
     // llm_adapter_ 可能为 nullptr，NodeExecutor 需要处理这种情况
@@ -26,6 +86,43 @@ Context NodeExecutor::execute_node(Node* node, const Context& ctx) {
     // 检查权限
     check_permissions(node->permissions, node->path);
 
+    Context result = dispatch_node(node, context_with_resources);
+    if (node->compiled_signature && !node->compiled_signature->outputs().empty()) {
+        check_signature_outputs(node, result);
+    }
+    return result;
+}
+
+void NodeExecutor::check_signature_outputs(const Node* node, const Context& result) {
+    std::string policy = "warn";
+    if (node->metadata.is_object()) {
+        policy = node->metadata.value("signature_validation", policy);
+    }
+    if (policy == "ignore") return;
+
+    auto violation = node->compiled_signature->check_outputs(result);
+    if (!violation) return;
+    if (policy == "strict") {
+        throw std::runtime_error("Signature validation failed (strict mode) for node " + node->path + ": " + *violation);
+    }
+    std::cerr << "[WARNING] Signature validation failed (warn mode) for node " << node->path << ": " << *violation << std::endl;
+}
+
+void NodeExecutor::check_generated_graph(const GenerateSubgraphNode* node, const ParsedGraph& graph) {
+    if (!graph.signature.has_value() || node->signature_validation == "ignore") return;
+
+    auto violation = check_generated_signature(graph);
+    if (!violation) return;
+    if (node->signature_validation == "strict") {
+        // TODO: 有 on_signature_violation 时应由调度器跳转，目前与无跳转路径一样直接失败
+        throw std::runtime_error("Signature validation failed (strict mode) for generated graph: " + graph.path + ": " + *violation);
+    }
+    if (node->signature_validation == "warn") {
+        std::cerr << "[WARNING] Signature validation failed (warn mode) for generated graph: " << graph.path << ": " << *violation << std::endl;
+    }
+}
+
+Context NodeExecutor::dispatch_node(Node* node, const Context& context_with_resources) {
     // 根据节点类型分发执行
     switch (node->type) {
         case NodeType::START:
@@ -84,8 +181,13 @@ Context NodeExecutor::execute_assign(const AssignNode* node, const Context& ctx)
     Context new_context = ctx;
     for (const auto& [key, template_str] : node->assign) {
         try {
-            std::string rendered_value = InjaTemplateRenderer::render(template_str, ctx);
-            new_context[key] = rendered_value; // 赋值到新的上下文
+            auto compiled = find_compiled(node->compiled_assign, key);
+            if (compiled) {
+                // 纯变量引用保留原始 JSON 类型
+                new_context[key] = InjaTemplateRenderer::evaluate(*compiled, ctx);
+            } else {
+                new_context[key] = InjaTemplateRenderer::render(template_str, ctx); // 赋值到新的上下文
+            }
         } catch (const inja::RenderError& e) {
             throw std::runtime_error("Template rendering failed for key '" + key + "': " + std::string(e.what()));
         }
@@ -103,7 +205,9 @@ Context NodeExecutor::execute_llm_call(const LLMCallNode* node, const Context& c
         // 使用 PromptBuilder 注入库信息
         std::string rendered_prompt = InjaTemplateRenderer::render(node->prompt_template, ctx);
 
-        std::string llm_response = llm_adapter_->generate(rendered_prompt);
+        std::string llm_response = llm_stream_callback_
+            ? llm_adapter_->generate(rendered_prompt, [&](std::string_view piece) { return llm_stream_callback_(node->path, piece); })
+            : llm_adapter_->generate(rendered_prompt);
 
         // 将 LLM 响应赋值到上下文
         if (!node->output_keys.empty()) {
@@ -123,10 +227,14 @@ Context NodeExecutor::execute_dsl_node(const DSLNode* node, const Context& ctx)
     
     try {
         // Render prompt template
-        std::string rendered_prompt = InjaTemplateRenderer::render(node->prompt_template, ctx);
+        std::string rendered_prompt = render_template(node->compiled_prompt, node->prompt_template, ctx);
         
         // Call LLM via ToolRegistry
-        nlohmann::json result = tool_registry_.call_llm_tool(node->llm_tool_name, rendered_prompt, node->llm_params);
+        ILLMTool::StreamCallback on_chunk;
+        if (llm_stream_callback_) {
+            on_chunk = [&](std::string_view chunk) { return llm_stream_callback_(node->path, chunk); };
+        }
+        nlohmann::json result = tool_registry_.call_llm_tool(node->llm_tool_name, rendered_prompt, node->llm_params, on_chunk);
         
         // Check result
         if (!result.value("success", false)) {
@@ -153,7 +261,7 @@ Context NodeExecutor::execute_tool_call(const ToolCallNode* node, const Context&
     // 渲染参数
     std::unordered_map<std::string, std::string> rendered_args;
     for (const auto& [key, tmpl] : node->arguments) {
-        rendered_args[key] = InjaTemplateRenderer::render(tmpl, ctx);
+        rendered_args[key] = render_template(find_compiled(node->compiled_arguments, key), tmpl, ctx);
     }
 
     // 调用工具
@@ -200,32 +308,43 @@ Context NodeExecutor::execute_resource(const ResourceNode* node, const Context&
 }
 
 Context NodeExecutor::execute_assert(const AssertNode* node, const Context& ctx) {
-    // Render the condition expression using the current context
-    std::string rendered_condition_str;
+    // Evaluate the condition against the current context.
+    // Precompiled expressions yield a typed value; other templates render to a string.
+    Value condition_value;
     try {
-        rendered_condition_str = InjaTemplateRenderer::render(node->condition, ctx);
-    } catch (const inja::InjaError& e) {
-        throw std::runtime_error("Assert condition template rendering failed for node '" + node->path + "': " + std::string(e.message));
+        if (node->compiled_condition) {
+            condition_value = InjaTemplateRenderer::evaluate(*node->compiled_condition, ctx);
+        } else {
+            condition_value = InjaTemplateRenderer::render(node->condition, ctx);
+        }
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Assert condition template rendering failed for node '" + node->path + "': " + std::string(e.what()));
     }
 
-    // Convert rendered result to boolean
-    // Inja renders to string, so we check string value
     bool condition_result = false;
-    if (rendered_condition_str == "true") {
-        condition_result = true;
-    } else if (rendered_condition_str == "false") {
-        condition_result = false;
-    } else {
-        // If the rendered result is not explicitly "true" or "false",
-        // try to interpret it as a number (0 is false, non-zero is true)
-        try {
-            double num_val = std::stod(rendered_condition_str);
-            condition_result = (num_val != 0.0);
-    } catch (...) {
-            // If it's not a number either, treat as false or throw error
-            // Let's throw an error for non-boolean results
-            throw std::runtime_error("Assert condition did not evaluate to a boolean value ('true'/'false' or number): " + rendered_condition_str);
+    if (condition_value.is_boolean()) {
+        condition_result = condition_value.get<bool>();
+    } else if (condition_value.is_number()) {
+        condition_result = (condition_value != 0);
+    } else if (condition_value.is_string()) {
+        // Rendered templates: check for "true"/"false",
+        // then try to interpret it as a number (0 is false, non-zero is true)
+        const std::string& rendered_condition_str = condition_value.get_ref<const std::string&>();
+        if (rendered_condition_str == "true") {
+            condition_result = true;
+        } else if (rendered_condition_str == "false") {
+            condition_result = false;
+        } else {
+            try {
+                double num_val = std::stod(rendered_condition_str);
+                condition_result = (num_val != 0.0);
+            } catch (...) {
+                // Let's throw an error for non-boolean results
+                throw std::runtime_error("Assert condition did not evaluate to a boolean value ('true'/'false' or number): " + rendered_condition_str);
+            }
         }
+    } else {
+        throw std::runtime_error("Assert condition did not evaluate to a boolean value ('true'/'false' or number): " + condition_value.dump());
     }
 
     if (!condition_result) {
@@ -284,48 +403,63 @@ Context NodeExecutor::execute_generate_subgraph(const GenerateSubgraphNode* node
          // For now, assume budget info is added by the calling context or PromptBuilder
          // prompt_ctx["budget"] = ...; // Access budget from ExecutionSession
 
-        // 2. Call LLM
-        std::string generated_dsl;
-        if (llm_adapter_) {
-            generated_dsl = llm_adapter_->generate(rendered_prompt);
-        } else {
+        // 2. Call LLM, streaming its output into an incremental parser.
+        // 3. Each `### AgenticDSL '/dynamic/...'` block is parsed, validated and handed to the
+        //    scheduler as soon as its closing fence is decoded. The scheduler adds it to the DAG right
+        //    away and may run its nodes while later blocks are still generating; if this node fails
+        //    (a bad block, a strict signature violation, a generation error) the run fails.
+        if (node->llm_tool_name.empty() && !llm_adapter_) {
             throw std::runtime_error("LLM adapter not available for generate_subgraph");
         }
 
-        // 3. Parse LLM output for `### AgenticDSL '/dynamic/...'` blocks
-        // This requires access to the main engine's parser and graph storage mechanism.
-        // A reference or callback to the engine might be needed here, or the parsing result is returned.
-        // For this executor, assume a global or injected mechanism or return the result for the scheduler to handle.
-        // Let's assume the scheduler calls a parser and handles the dynamic graph registration.
-        // Here, we just parse and return the generated paths in the context.
-        auto new_graphs = markdown_parser_.parse_from_string(generated_dsl); // ← 通过实例调用
         std::vector<std::string> dynamic_paths; // Collect paths of generated graphs
-        for (auto& graph : new_graphs) {
-            if (graph.path.rfind("/dynamic/", 0) == 0) { // Ensure it's dynamic
-                // 4. Validate signature if present (v3.1)
-                if (graph.signature.has_value()) {
-                    // Perform validation based on signature_validation policy
-                    bool is_valid = true; // Placeholder for actual validation logic
-                    if (!is_valid && node->signature_validation == "strict") {
-                         if (node->on_signature_violation.has_value()) {
-                             // Trigger jump to on_signature_violation path
-                             // This requires scheduler logic to handle jumps
-                             // For now, throw error
-                             throw std::runtime_error("Signature validation failed (strict mode) for generated graph: " + graph.path);
-                         } else {
-                             // Default behavior for strict violation without jump path
-                             throw std::runtime_error("Signature validation failed (strict mode) for generated graph: " + graph.path);
-                         }
-                    } else if (!is_valid && node->signature_validation == "warn") {
-                        // Log warning but continue
-                        std::cerr << "[WARNING] Signature validation failed (warn mode) for generated graph: " << graph.path << std::endl;
-                    } // ignore: do nothing
+        auto on_graphs = [&](std::vector<ParsedGraph> new_graphs) {
+            std::vector<ParsedGraph> accepted;
+            for (auto& graph : new_graphs) {
+                if (graph.path.rfind("/dynamic/", 0) != 0) { // Ensure it's dynamic
+                    continue;
                 }
+                // 4. Validate signature if present (v3.1)
+                check_generated_graph(node, graph);
                 dynamic_paths.push_back(graph.path);
-                // 5. Register new graph (This logic belongs in the scheduler/engine)
-                // g_current_engine->append_graphs({std::move(graph)}); // Placeholder - requires access to engine/scheduler
+                accepted.push_back(std::move(graph));
             }
+            // 5. Hand new graphs to the scheduler right away
+            if (!accepted.empty() && append_graphs_callback_) {
+                append_graphs_callback_(std::move(accepted));
+            }
+        };
+
+        StreamingDSLParser stream(markdown_parser_, on_graphs);
+        std::exception_ptr stream_error;
+        auto on_piece = [&](std::string_view piece) {
+            try {
+                stream.feed(piece);
+                return !llm_stream_callback_ || llm_stream_callback_(node->path, piece);
+            } catch (...) {
+                stream_error = std::current_exception(); // 停止解码，生成结束后再抛出
+                return false;
+            }
+        };
+
+        // 语法约束下模型只能输出合法的块，省去前后说明文字与格式错误后的重试
+        static const std::string grammar = dsl_block_grammar();
+        if (!node->llm_tool_name.empty()) {
+            LLMParams params;
+            if (node->constrain_output) params.grammar = grammar;
+            nlohmann::json result = tool_registry_.call_llm_tool(node->llm_tool_name, rendered_prompt, params, on_piece);
+            if (!stream_error && !result.value("success", false)) {
+                throw std::runtime_error("LLM generation failed: " + result.value("error", "Unknown error"));
+            }
+        } else {
+            LlamaAdapter::SamplingParams sampling = llm_adapter_->default_sampling();
+            if (node->constrain_output) sampling.grammar = grammar;
+            llm_adapter_->generate(rendered_prompt, on_piece, sampling);
+        }
+        if (stream_error) {
+            std::rethrow_exception(stream_error);
         }
+        stream.finish();
 
         // 6. Store generated graph path(s) in context
         if (!node->output_keys.empty()) {
@@ -10,7 +10,9 @@
 #include "common/llm/llama_adapter.h" // 引入 LlamaAdapter
 #include "modules/parser/markdown_parser.h" // 引入 ResourceManager
 #include <nlohmann/json.hpp>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <memory>
@@ -18,6 +20,8 @@
 namespace agenticdsl {
 
 using AppendGraphsCallback = std::function<void(std::vector<ParsedGraph>)>;
+// LLM 节点每生成一段文本回调一次（供前端显示进度）；返回 false 时提前停止该节点的生成
+using LLMStreamCallback = std::function<bool(const NodePath& node, std::string_view chunk)>;
 
 class NodeExecutor {
 public:
@@ -28,15 +32,26 @@ public:
     void set_append_graphs_callback(AppendGraphsCallback cb) {
         append_graphs_callback_ = std::move(cb);
     }
+    void set_llm_stream_callback(LLMStreamCallback cb) {
+        llm_stream_callback_ = std::move(cb);
+    }
+
+    // 按 generate_subgraph 节点的 signature_validation 校验一个生成的子图：
+    // 签名须可解析、必填输出须有节点写入；strict 违规时抛出，warn 只告警，ignore 不检查
+    static void check_generated_graph(const GenerateSubgraphNode* node, const ParsedGraph& graph);
 
 private:
     ToolRegistry& tool_registry_;
     LlamaAdapter* llm_adapter_; // 可为 nullptr
     AppendGraphsCallback append_graphs_callback_;
+    LLMStreamCallback llm_stream_callback_;
     MarkdownParser markdown_parser_; // ← 新增成员
 
     // 权限检查
     void check_permissions(const std::vector<std::string>& perms, const NodePath& node_path);
+    // 按节点签名校验输出（策略取自 metadata.signature_validation，默认 warn）
+    void check_signature_outputs(const Node* node, const Context& result);
+    Context dispatch_node(Node* node, const Context& ctx);
 
     // 内部执行方法，根据节点类型分发
     Context execute_start(const StartNode* node, const Context& ctx);
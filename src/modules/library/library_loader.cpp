@@ -1,24 +1,149 @@
 // modules/library/src/library_loader.cpp
 #include "library_loader.h"
 //#include "core/types/system_nodes.h" // For create_system_nodes if needed, or define built-ins differently
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <iostream>
+#include <set>
 #include <sstream>
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 namespace agenticdsl {
 
-StandardLibraryLoader& StandardLibraryLoader::instance() {
-    static StandardLibraryLoader loader;
-    static bool initialized = false;
-    if (!initialized) {
-        loader.load_builtin_libraries();
-        // Optional: loader.load_from_directory("./lib");
-        initialized = true;
+namespace {
+
+namespace fs = std::filesystem;
+
+// 条目元数据或清单结构变化时递增，使旧清单失效
+constexpr int kManifestVersion = 1;
+
+std::string read_file(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+nlohmann::json entry_to_json(const LibraryEntry& entry) {
+    nlohmann::json j = {{"path", entry.path}, {"permissions", entry.permissions}};
+    if (entry.signature) j["signature"] = *entry.signature;
+    if (entry.output_schema) j["output_schema"] = *entry.output_schema;
+    return j;
+}
+
+LibraryEntry entry_from_json(const nlohmann::json& j, const std::string& source_file) {
+    LibraryEntry entry;
+    entry.path = j.at("path").get<std::string>();
+    if (j.contains("signature")) entry.signature = j["signature"].get<std::string>();
+    if (j.contains("output_schema")) entry.output_schema = j["output_schema"];
+    entry.permissions = j.at("permissions").get<std::vector<std::string>>();
+    entry.is_subgraph = true;
+    entry.source_file = source_file;
+    return entry;
+}
+
+// 先写临时文件再 rename，与 GraphCache 一致
+void write_json_atomically(const fs::path& target, const nlohmann::json& manifest) {
+    std::error_code ec;
+    fs::create_directories(target.parent_path(), ec);
+    if (ec) return;
+    auto tmp = target;
+    tmp += ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::trunc);
+        if (!f) return;
+        f << manifest.dump();
+        if (!f) {
+            f.close();
+            fs::remove(tmp, ec);
+            return;
+        }
+    }
+    fs::rename(tmp, target, ec);
+    if (ec) fs::remove(tmp, ec);
+}
+
+} // namespace
+
+LibraryFile::LibraryFile(std::string path, std::vector<ParsedGraph> graphs)
+    : path_(std::move(path)), graphs_(std::move(graphs)) {}
+
+LibraryFile::LibraryFile(std::string path, std::int64_t mtime, std::uint64_t size)
+    : path_(std::move(path)), stamp_(std::make_pair(mtime, size)) {}
+
+const std::vector<ParsedGraph>& LibraryFile::graphs() const {
+    std::call_once(once_, [this] {
+        if (!stamp_) return;
+        std::error_code ec;
+        const auto mtime = static_cast<std::int64_t>(fs::last_write_time(path_, ec).time_since_epoch().count());
+        const auto size = static_cast<std::uint64_t>(fs::file_size(path_, ec));
+        if (ec || std::make_pair(mtime, size) != *stamp_) {
+            // 索引之后被修改或删除：清单中的条目已不可信，不拿新内容冒充旧快照
+            std::cerr << "[WARNING] Library file changed since indexing, skipped: " << path_ << std::endl;
+            return;
+        }
+        try {
+            MarkdownParser parser(0);
+            GraphCache cache;
+            graphs_ = cache.load(read_file(path_), parser);
+        } catch (const std::exception& e) {
+            std::cerr << "[WARNING] Failed to load library from " << path_ << ": " << e.what() << std::endl;
+        }
+    });
+    return graphs_;
+}
+
+const ParsedGraph* LibrarySnapshot::find_graph(const NodePath& path) const {
+    // 最长前缀匹配：/lib/a/b/step 属于子图 /lib/a/b
+    const LibraryEntry* best = nullptr;
+    for (const auto& entry : entries) {
+        bool contains = path == entry.path || path.rfind(entry.path + "/", 0) == 0;
+        if (contains && !entry.source_file.empty() && (!best || entry.path.size() > best->path.size())) {
+            best = &entry;
+        }
+    }
+    if (!best) return nullptr;
+
+    auto file = files.find(best->source_file);
+    if (file == files.end()) return nullptr;
+    for (const auto& graph : file->second->graphs()) {
+        if (graph.path == best->path) return &graph;
     }
+    return nullptr;
+}
+
+StandardLibraryLoader::StandardLibraryLoader() : current_(std::make_shared<const LibrarySnapshot>()) {}
+
+StandardLibraryLoader::~StandardLibraryLoader() {
+    stop_watching();
+}
+
+StandardLibraryLoader& StandardLibraryLoader::instance() {
+    static StandardLibraryLoader& loader = []() -> StandardLibraryLoader& {
+        static StandardLibraryLoader instance;
+        instance.load_builtin_libraries();
+        if (const char* dir = std::getenv("AGENTICDSL_LIB_DIR"); dir && *dir) {
+            instance.load_from_directory(dir);
+            if (const char* watch = std::getenv("AGENTICDSL_LIB_WATCH"); watch && std::string(watch) == "1") {
+                instance.start_watching();
+            }
+        }
+        return instance;
+    }();
     return loader;
 }
 
 void StandardLibraryLoader::load_builtin_libraries() {
+    std::vector<LibraryEntry> builtins;
     // Register /lib/utils/noop (defined as system node, but conceptually a library)
     // libraries_.push_back({
     //      "/lib/utils/noop",
@@ -31,61 +156,295 @@ void StandardLibraryLoader::load_builtin_libraries() {
     // This is just a declaration, actual execution requires the full graph.
     // The graph for /lib/math/add would be loaded separately or defined in a .md file.
     // For v3.1, we can define a signature.
-    libraries_.push_back({
+    builtins.push_back({
          "/lib/math/add",
          "(a: number, b: number) -> {sum: number}",
          // Parsed schema would be calculated by the parser/loader when the actual graph is loaded
          // For built-ins, we might hardcode the schema or parse the signature string here.
          nlohmann::json::parse(R"({"type": "object", "properties": {"sum": {"type": "number"}}})"), // Example schema
          {},
-         true // is subgraph
+         true, // is subgraph
+         {}    // 内置条目没有源文件
     });
 
     // Add other built-in library entries as needed per v3.1 spec
-    libraries_.push_back({
+    builtins.push_back({
          "/lib/reasoning/with_rollback",
          "(try_path: string, fallback_path: string) -> {success: boolean}",
          nlohmann::json::parse(R"({"type": "object", "properties": {"success": {"type": "boolean"}}})"), // Example schema
          {},
-         true // is subgraph
+         true, // is subgraph
+         {}    // 内置条目没有源文件
     });
 
     // ... add more ...
+
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    publish([&](LibrarySnapshot& snap) {
+        snap.entries.insert(snap.entries.end(), builtins.begin(), builtins.end());
+    });
+}
+
+
+void StandardLibraryLoader::publish(const std::function<void(LibrarySnapshot&)>& edit) {
+    auto next = std::make_shared<LibrarySnapshot>(*current_.load());
+    edit(*next);
+    ++next->version;
+    current_.store(std::move(next));
+}
+
+fs::path StandardLibraryLoader::manifest_path(const fs::path& lib_dir) const {
+    if (!graph_cache_.enabled()) return {}; // 无安全的缓存目录：不读写清单，每次启动重新索引
+    char name[48];
+    std::snprintf(name, sizeof(name), "lib-manifest-%016llx.json",
+                  static_cast<unsigned long long>(GraphCache::source_hash(lib_dir.generic_string())));
+    return graph_cache_.directory() / name;
 }
 
-const std::vector<LibraryEntry>& StandardLibraryLoader::get_available_libraries() const {
-    return libraries_;
+void StandardLibraryLoader::write_manifest(const std::string& root) {
+    if (!graph_cache_.enabled()) return;
+    write_json_atomically(manifest_path(root), {{"version", kManifestVersion}, {"files", manifests_[root]}});
+}
+
+std::optional<nlohmann::json> StandardLibraryLoader::index_file(const fs::path& path, std::vector<LibraryEntry>& out,
+                                                                std::vector<ParsedGraph>& graphs) {
+    std::error_code ec;
+    const std::string file = path.string();
+    const auto mtime = static_cast<std::int64_t>(fs::last_write_time(path, ec).time_since_epoch().count());
+    const auto size = static_cast<std::uint64_t>(fs::file_size(path, ec));
+    try {
+        nlohmann::json record = {{"mtime", mtime}, {"size", size}, {"entries", nlohmann::json::array()}};
+        graphs = graph_cache_.load(read_file(file), parser_);
+        for (const auto& g : graphs) {
+            if (!g.is_standard_library) continue;
+            LibraryEntry entry;
+            entry.path = g.path;
+            entry.signature = g.signature;
+            entry.output_schema = g.output_schema; // From parser (v3.1)
+            entry.permissions = g.permissions;
+            entry.is_subgraph = true;
+            entry.source_file = file;
+            record["entries"].push_back(entry_to_json(entry));
+            out.push_back(std::move(entry));
+        }
+        return record;
+    } catch (const std::exception& e) {
+        // 不中断加载；未记入清单，下次重试
+        std::cerr << "[WARNING] Failed to load library from " << file << ": " << e.what() << std::endl;
+        return std::nullopt;
+    }
 }
 
 void StandardLibraryLoader::load_from_directory(const std::string& lib_dir) {
-    namespace fs = std::filesystem;
-    if (!fs::exists(lib_dir) || !fs::is_directory(lib_dir)) return;
-
-    for (const auto& entry : fs::recursive_directory_iterator(lib_dir)) {
-        if (entry.is_regular_file() && entry.path().extension() == ".md") {
-            std::ifstream file(entry.path());
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            try {
-                auto graphs = parser_.parse_from_string(buffer.str());
-                for (const auto& g : graphs) {
-                    if (g.is_standard_library) {
-                        LibraryEntry entry;
-                        entry.path = g.path;
-                        entry.signature = g.signature;
-                        entry.output_schema = g.output_schema; // From parser (v3.1)
-                        entry.permissions = g.permissions;
-                        entry.is_subgraph = true;
-                        libraries_.push_back(std::move(entry));
+    std::error_code ec;
+    if (!fs::exists(lib_dir, ec) || !fs::is_directory(lib_dir, ec)) return;
+    const fs::path root = fs::weakly_canonical(fs::absolute(lib_dir), ec);
+
+    std::vector<fs::path> paths;
+    for (const auto& entry : fs::recursive_directory_iterator(root, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".md") paths.push_back(entry.path());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    nlohmann::json old_files = nlohmann::json::object();
+    if (std::ifstream in(manifest_path(root)); in) {
+        try {
+            auto manifest = nlohmann::json::parse(in);
+            if (manifest.value("version", 0) == kManifestVersion && manifest.contains("files")) {
+                old_files = std::move(manifest["files"]);
+            }
+        } catch (const nlohmann::json::exception&) {
+            // 清单损坏：视为空，稍后整体重写
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    std::vector<LibraryEntry> entries;
+    std::unordered_map<std::string, std::shared_ptr<const LibraryFile>> files;
+    nlohmann::json new_files = nlohmann::json::object();
+    bool dirty = false;
+    const auto current = current_.load();
+    for (const auto& path : paths) {
+        const std::string file = path.string();
+        const std::string rel = fs::relative(path, root, ec).generic_string();
+        const auto mtime = static_cast<std::int64_t>(fs::last_write_time(path, ec).time_since_epoch().count());
+        const auto size = static_cast<std::uint64_t>(fs::file_size(path, ec));
+
+        auto cached = old_files.find(rel);
+        if (cached != old_files.end() && cached->value("mtime", std::int64_t{0}) == mtime &&
+            cached->value("size", std::uint64_t{0}) == size) {
+            for (const auto& e : (*cached)["entries"]) entries.push_back(entry_from_json(e, file));
+            new_files[rel] = std::move(*cached);
+            // 未变化的文件沿用已加载的实例；否则推迟到被引用时再读入并解析
+            auto loaded = current->files.find(file);
+            files[file] = loaded != current->files.end() ? loaded->second
+                                                         : std::make_shared<const LibraryFile>(file, mtime, size);
+            continue;
+        }
+
+        // 新增或修改过的文件：解析一次，元数据写入清单，图随快照保存
+        dirty = true;
+        std::vector<ParsedGraph> graphs;
+        if (auto record = index_file(path, entries, graphs)) {
+            new_files[rel] = std::move(*record);
+            files[file] = std::make_shared<const LibraryFile>(file, std::move(graphs));
+        }
+    }
+
+    dirty = dirty || new_files.size() != old_files.size();
+    manifests_[root.string()] = std::move(new_files);
+    if (dirty) write_manifest(root.string());
+
+    // 重新索引同一目录时替换其旧条目
+    const std::string prefix = root.string() + "/";
+    publish([&](LibrarySnapshot& snap) {
+        auto from_root = [&prefix](const std::string& file) { return file.rfind(prefix, 0) == 0; };
+        snap.entries.erase(std::remove_if(snap.entries.begin(), snap.entries.end(),
+                                          [&](const LibraryEntry& e) { return from_root(e.source_file); }),
+                           snap.entries.end());
+        for (auto it = snap.files.begin(); it != snap.files.end();) {
+            it = from_root(it->first) ? snap.files.erase(it) : std::next(it);
+        }
+        snap.entries.insert(snap.entries.end(), std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+        snap.files.insert(files.begin(), files.end());
+    });
+}
+
+void StandardLibraryLoader::reload_file(const std::string& file) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    std::string root;
+    for (const auto& [dir, _] : manifests_) {
+        if (file.rfind(dir + "/", 0) == 0 && dir.size() > root.size()) root = dir;
+    }
+    if (root.empty()) return; // 不属于任何已索引的目录
+
+    std::error_code ec;
+    const fs::path path(file);
+    const std::string rel = fs::relative(path, root, ec).generic_string();
+    std::vector<LibraryEntry> entries;
+    std::vector<ParsedGraph> graphs;
+    std::optional<nlohmann::json> record;
+    if (fs::is_regular_file(path, ec)) {
+        record = index_file(path, entries, graphs);
+        if (!record) return; // 解析失败（如写了一半）：保留旧版本，等下一次变化
+    }
+
+    auto& manifest = manifests_[root];
+    if (record) {
+        manifest[rel] = std::move(*record);
+    } else {
+        manifest.erase(rel);
+    }
+    write_manifest(root);
+
+    publish([&](LibrarySnapshot& snap) {
+        snap.entries.erase(std::remove_if(snap.entries.begin(), snap.entries.end(),
+                                          [&](const LibraryEntry& e) { return e.source_file == file; }),
+                           snap.entries.end());
+        snap.entries.insert(snap.entries.end(), std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+        if (record) {
+            snap.files[file] = std::make_shared<const LibraryFile>(file, std::move(graphs));
+        } else {
+            snap.files.erase(file);
+        }
+    });
+}
+
+#if defined(__linux__)
+
+namespace {
+constexpr std::uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE;
+}
+
+void StandardLibraryLoader::add_watch_recursive(const fs::path& dir) {
+    int wd = inotify_add_watch(inotify_fd_, dir.c_str(), kWatchMask);
+    if (wd >= 0) watch_dirs_[wd] = dir.string();
+    std::error_code ec;
+    for (const auto& entry : fs::recursive_directory_iterator(dir, ec)) {
+        if (!entry.is_directory()) continue;
+        wd = inotify_add_watch(inotify_fd_, entry.path().c_str(), kWatchMask);
+        if (wd >= 0) watch_dirs_[wd] = entry.path().string();
+    }
+}
+
+bool StandardLibraryLoader::start_watching() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (watcher_.joinable()) return true;
+    if (manifests_.empty()) return false;
+
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) return false;
+    if (pipe2(wake_pipe_, O_CLOEXEC) != 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+        return false;
+    }
+    for (const auto& [root, _] : manifests_) add_watch_recursive(root);
+    watcher_ = std::thread([this] { watch_loop(); });
+    return true;
+}
+
+void StandardLibraryLoader::stop_watching() {
+    if (!watcher_.joinable()) return;
+    char byte = 0;
+    (void)!write(wake_pipe_[1], &byte, 1);
+    watcher_.join();
+    close(inotify_fd_);
+    close(wake_pipe_[0]);
+    close(wake_pipe_[1]);
+    inotify_fd_ = -1;
+    wake_pipe_[0] = wake_pipe_[1] = -1;
+    watch_dirs_.clear();
+}
+
+void StandardLibraryLoader::watch_loop() {
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (true) {
+        pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_pipe_[0], POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents != 0) break;
+
+        // 一批事件里同一文件只重新解析一次（编辑器保存常伴随多个事件）
+        std::set<std::string> changed;
+        ssize_t len;
+        while ((len = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + len;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+                auto dir = watch_dirs_.find(event->wd);
+                if (dir == watch_dirs_.end() || event->len == 0) continue;
+
+                fs::path path = fs::path(dir->second) / event->name;
+                if (event->mask & IN_ISDIR) {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        // 新目录：补上监视，并索引其中已有的文件
+                        add_watch_recursive(path);
+                        std::error_code ec;
+                        for (const auto& entry : fs::recursive_directory_iterator(path, ec)) {
+                            if (entry.is_regular_file() && entry.path().extension() == ".md") changed.insert(entry.path().string());
+                        }
                     }
+                    continue;
+                }
+                if (path.extension() == ".md" && (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE))) {
+                    changed.insert(path.string());
                 }
-            } catch (const std::exception& e) {
-                // Log error, but don't interrupt loading
-                // std::cerr << "[WARNING] Failed to load library from " << entry.path() << ": " << e.what() << std::endl;
-                continue;
             }
         }
+        for (const auto& file : changed) reload_file(file);
     }
 }
 
+#else
+
+void StandardLibraryLoader::add_watch_recursive(const fs::path&) {}
+bool StandardLibraryLoader::start_watching() { return false; }
+void StandardLibraryLoader::stop_watching() {}
+void StandardLibraryLoader::watch_loop() {}
+
+#endif
+
 } // namespace agenticdsl
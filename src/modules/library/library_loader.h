@@ -4,22 +4,98 @@
 
 #include "library/schema.h" // 引入 LibraryEntry
 #include "modules/parser/markdown_parser.h" // 引入 ParsedGraph
+#include "modules/parser/graph_cache.h"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <string>
 
 namespace agenticdsl {
 
+// 一个库源文件中的图；未变化的文件在前后快照之间共享同一实例。
+// 内容在首次访问时固定下来，之后磁盘上的文件再怎么变化也不影响已发布的快照
+class LibraryFile {
+public:
+    // 索引时已解析出的图
+    LibraryFile(std::string path, std::vector<ParsedGraph> graphs);
+    // 清单命中：只记下清单中的 mtime 与大小，首次访问时校验一致才读入并解析。
+    // 文件已被修改则该文件从快照中消失（graphs() 为空），新内容由重新索引发布
+    LibraryFile(std::string path, std::int64_t mtime, std::uint64_t size);
+    const std::vector<ParsedGraph>& graphs() const;
+
+private:
+    std::string path_;
+    std::optional<std::pair<std::int64_t, std::uint64_t>> stamp_; // 待校验的 mtime 与大小；已解析的文件为空
+    mutable std::once_flag once_;
+    mutable std::vector<ParsedGraph> graphs_;
+};
+
+// 某一时刻的标准库内容，发布后不再修改。
+// 一次运行从头到尾持有同一快照，热更新只影响之后开始的运行
+struct LibrarySnapshot {
+    std::uint64_t version = 0;
+    std::vector<LibraryEntry> entries;
+    std::unordered_map<std::string, std::shared_ptr<const LibraryFile>> files; // 源文件 -> 懒加载的图
+
+    // 包含 path（子图路径或其中的节点路径）的库子图；找不到返回 nullptr。指针在快照存活期间有效
+    const ParsedGraph* find_graph(const NodePath& path) const;
+};
+using LibrarySnapshotPtr = std::shared_ptr<const LibrarySnapshot>;
+
 class StandardLibraryLoader {
 public:
+    // 设置了 $AGENTICDSL_LIB_DIR 时首次访问即建立该目录的索引；
+    // 同时设置 $AGENTICDSL_LIB_WATCH=1 则开始监视该目录（长期运行的进程用于热更新）
     static StandardLibraryLoader& instance();
-    const std::vector<LibraryEntry>& get_available_libraries() const;
+    ~StandardLibraryLoader();
+
+    // 当前发布的快照；读取不加锁，写入方以 RCU 方式整体替换
+    LibrarySnapshotPtr snapshot() const { return current_.load(); }
+    std::vector<LibraryEntry> get_available_libraries() const { return snapshot()->entries; }
+
+    // 建立目录索引：mtime 与大小未变的文件直接复用清单中的元数据，只解析新增或修改过的文件
     void load_from_directory(const std::string& lib_dir);
     void load_builtin_libraries(); // 加载内置子图定义（路径、Schema）
 
+    // 用 inotify 监视已索引的目录（含子目录），文件变化时只重新解析该文件并发布新快照。
+    // 非 Linux 平台或没有已索引的目录时返回 false
+    bool start_watching();
+    void stop_watching();
+    // 重新索引单个文件；文件已删除时移除其条目。监视线程调用，也可手动触发
+    void reload_file(const std::string& file);
+
 private:
-    StandardLibraryLoader() = default;
-    std::vector<LibraryEntry> libraries_;
-    MarkdownParser parser_; // 内部使用 parser
+    StandardLibraryLoader();
+
+    std::filesystem::path manifest_path(const std::filesystem::path& lib_dir) const;
+    // 解析文件并返回其清单记录与图；解析失败返回 nullopt
+    std::optional<nlohmann::json> index_file(const std::filesystem::path& path, std::vector<LibraryEntry>& out,
+                                             std::vector<ParsedGraph>& graphs);
+    void write_manifest(const std::string& root);
+    // 复制当前快照、修改、递增版本后发布；调用方持有 write_mutex_
+    void publish(const std::function<void(LibrarySnapshot&)>& edit);
+
+    void add_watch_recursive(const std::filesystem::path& dir);
+    void watch_loop();
+
+    std::atomic<LibrarySnapshotPtr> current_;
+    std::mutex write_mutex_;   // 串行化所有写入（索引、重载、发布）
+    MarkdownParser parser_{0}; // 内部使用 parser；标准库块多，按核数并行解析
+    GraphCache graph_cache_;   // 未变化的库文件直接从编译缓存构建；清单也存放在缓存目录
+    std::unordered_map<std::string, nlohmann::json> manifests_; // 已索引目录 -> 清单中的 files 对象
+
+    std::thread watcher_;
+    int inotify_fd_ = -1;
+    int wake_pipe_[2] = {-1, -1}; // stop_watching 通过它唤醒监视线程
+    std::unordered_map<int, std::string> watch_dirs_; // inotify watch descriptor -> 目录
 };
 
 } // namespace agenticdsl
@@ -15,6 +15,7 @@ struct LibraryEntry {
     std::optional<nlohmann::json> output_schema; // Parsed JSON Schema from signature (v3.1)
     std::vector<std::string> permissions;
     bool is_subgraph = false;
+    std::string source_file; // 定义该条目的 .md 文件；内置条目为空
 };
 
 } // namespace agenticdsl
@@ -0,0 +1,173 @@
+// modules/library/src/subgraph_catalog.cpp
+#include "subgraph_catalog.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <mutex>
+#include <unordered_set>
+
+namespace agenticdsl {
+
+namespace {
+
+// BM25 常用参数
+constexpr double kK1 = 1.2;
+constexpr double kB = 0.75;
+
+// 建索引用的文本：路径、签名（含参数与输出名）、权限
+std::string index_text(const std::string& path,
+                       const std::optional<std::string>& signature,
+                       const std::optional<nlohmann::json>& output_schema,
+                       const std::vector<std::string>& permissions) {
+    std::string text = path;
+    if (signature) {
+        text += ' ';
+        text += *signature;
+    } else if (output_schema && !output_schema->is_null()) {
+        text += ' ';
+        text += output_schema->dump();
+    }
+    for (const auto& perm : permissions) {
+        text += ' ';
+        text += perm;
+    }
+    return text;
+}
+
+nlohmann::json make_item(const std::string& path,
+                         const std::optional<nlohmann::json>& output_schema,
+                         const std::vector<std::string>& permissions,
+                         const char* stability) {
+    nlohmann::json item;
+    item["path"] = path;
+    if (output_schema && !output_schema->is_null()) {
+        item["signature"] = {{"outputs", *output_schema}};
+    }
+    item["permissions"] = permissions;
+    item["stability"] = stability;
+    return item;
+}
+
+SubgraphCatalog::Document make_document(const std::string& text) {
+    SubgraphCatalog::Document doc;
+    for (auto& token : SubgraphCatalog::tokenize(text)) {
+        ++doc.term_freq[std::move(token)];
+        ++doc.length;
+    }
+    return doc;
+}
+
+// 标准库部分只在快照版本变化时重建，所有会话共享
+std::shared_ptr<const SubgraphCatalog::LibraryPart> library_part(const LibrarySnapshot& snapshot) {
+    static std::mutex mutex;
+    static std::shared_ptr<const SubgraphCatalog::LibraryPart> cached;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cached && cached->version == snapshot.version) return cached;
+
+    auto part = std::make_shared<SubgraphCatalog::LibraryPart>();
+    part->version = snapshot.version;
+    for (const auto& entry : snapshot.entries) {
+        if (!entry.is_subgraph) continue;
+        part->items.push_back(make_item(entry.path, entry.output_schema, entry.permissions, "stable"));
+        part->docs.push_back(make_document(index_text(entry.path, entry.signature, entry.output_schema, entry.permissions)));
+    }
+    cached = std::move(part);
+    return cached;
+}
+
+} // namespace
+
+std::vector<std::string> SubgraphCatalog::tokenize(std::string_view text) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < text.size()) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (std::isalnum(c)) {
+            size_t start = i;
+            while (i < text.size() && std::isalnum(static_cast<unsigned char>(text[i]))) ++i;
+            std::string token(text.substr(start, i - start));
+            std::transform(token.begin(), token.end(), token.begin(),
+                           [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+            tokens.push_back(std::move(token));
+        } else if (c >= 0x80) {
+            // 一个 UTF-8 字符：首字节后跟若干 10xxxxxx 续字节
+            size_t start = i++;
+            while (i < text.size() && (static_cast<unsigned char>(text[i]) & 0xC0) == 0x80) ++i;
+            tokens.emplace_back(text.substr(start, i - start));
+        } else {
+            ++i;
+        }
+    }
+    return tokens;
+}
+
+void SubgraphCatalog::refresh(const LibrarySnapshotPtr& library, const std::vector<ParsedGraph>* graphs) {
+    auto part = library ? library_part(*library) : nullptr;
+    size_t graph_count = graphs ? graphs->size() : 0;
+    if (built_ && part == library_part_ && graph_count == graph_count_) return;
+
+    items_ = part ? part->items : nlohmann::json::array();
+    docs_ = part ? part->docs : std::vector<Document>{};
+    if (graphs) {
+        for (const auto& graph : *graphs) {
+            if (graph.path.rfind("/dynamic/", 0) == 0 && graph.output_schema && !graph.output_schema->is_null()) {
+                add_item(make_item(graph.path, graph.output_schema, graph.permissions, "dynamic"),
+                         index_text(graph.path, graph.signature, graph.output_schema, graph.permissions));
+            }
+        }
+    }
+
+    doc_freq_.clear();
+    size_t total_length = 0;
+    for (const auto& doc : docs_) {
+        for (const auto& [term, _] : doc.term_freq) ++doc_freq_[term];
+        total_length += doc.length;
+    }
+    avg_length_ = docs_.empty() ? 0.0 : static_cast<double>(total_length) / docs_.size();
+
+    library_part_ = std::move(part);
+    graph_count_ = graph_count;
+    built_ = true;
+}
+
+void SubgraphCatalog::add_item(nlohmann::json item, const std::string& text) {
+    items_.push_back(std::move(item));
+    docs_.push_back(make_document(text));
+}
+
+nlohmann::json SubgraphCatalog::top_k(std::string_view query, size_t k) const {
+    if (k >= items_.size()) return items_;
+
+    auto tokens = tokenize(query);
+    std::unordered_set<std::string> terms(std::make_move_iterator(tokens.begin()), std::make_move_iterator(tokens.end()));
+    const double n = static_cast<double>(docs_.size());
+
+    std::vector<std::pair<double, size_t>> scored;
+    for (size_t i = 0; i < docs_.size(); ++i) {
+        const auto& doc = docs_[i];
+        double score = 0.0;
+        for (const auto& term : terms) {
+            auto tf = doc.term_freq.find(term);
+            if (tf == doc.term_freq.end()) continue;
+            double df = static_cast<double>(doc_freq_.at(term));
+            double idf = std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+            double norm = kK1 * (1.0 - kB + kB * static_cast<double>(doc.length) / avg_length_);
+            score += idf * tf->second * (kK1 + 1.0) / (tf->second + norm);
+        }
+        if (score > 0.0) scored.emplace_back(score, i);
+    }
+
+    nlohmann::json result = nlohmann::json::array();
+    if (scored.empty()) {
+        for (size_t i = 0; i < k; ++i) result.push_back(items_[i]);
+        return result;
+    }
+    size_t count = std::min(k, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + count, scored.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    for (size_t i = 0; i < count; ++i) result.push_back(items_[scored[i].second]);
+    return result;
+}
+
+} // namespace agenticdsl
@@ -0,0 +1,62 @@
+// modules/library/include/library/subgraph_catalog.h
+#ifndef AGENTICDSL_MODULES_LIBRARY_SUBGRAPH_CATALOG_H
+#define AGENTICDSL_MODULES_LIBRARY_SUBGRAPH_CATALOG_H
+
+#include "library_loader.h" // 引入 LibrarySnapshot
+#include "modules/parser/markdown_parser.h" // 引入 ParsedGraph
+#include <nlohmann/json.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace agenticdsl {
+
+// generate_subgraph 提示词中的 available_subgraphs 目录。
+// 标准库部分按快照版本在进程内共享，/dynamic/ 部分在图集增长时追加；
+// 同时维护词法索引，可只取与当前提示最相关的前 k 项，减少提示词长度
+class SubgraphCatalog {
+public:
+    // 快照或图集大小未变时直接返回，否则重建目录与索引
+    void refresh(const LibrarySnapshotPtr& library, const std::vector<ParsedGraph>* graphs);
+
+    const nlohmann::json& all() const { return items_; }
+    size_t size() const { return items_.size(); }
+
+    // 按 BM25 得分返回前 k 项（同分保持目录顺序）；没有任何词命中时退回目录前 k 项
+    nlohmann::json top_k(std::string_view query, size_t k) const;
+
+    // ASCII 字母数字串小写化为一个词，非 ASCII 字符（如中文）逐字成词
+    static std::vector<std::string> tokenize(std::string_view text);
+
+    struct Document {
+        std::unordered_map<std::string, int> term_freq;
+        size_t length = 0;
+    };
+
+    // 某一快照版本的标准库部分，不可变，多个会话共享
+    struct LibraryPart {
+        std::uint64_t version = 0;
+        nlohmann::json items = nlohmann::json::array();
+        std::vector<Document> docs;
+    };
+
+private:
+    void add_item(nlohmann::json item, const std::string& text);
+
+    std::shared_ptr<const LibraryPart> library_part_;
+    size_t graph_count_ = 0;
+    bool built_ = false;
+
+    nlohmann::json items_ = nlohmann::json::array();
+    std::vector<Document> docs_;
+    std::unordered_map<std::string, size_t> doc_freq_;
+    double avg_length_ = 0.0;
+};
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_MODULES_LIBRARY_SUBGRAPH_CATALOG_H
@@ -0,0 +1,162 @@
+// modules/optimizer/src/dependency_analysis.cpp
+#include "optimizer/dependency_analysis.h"
+#include <cctype>
+
+namespace agenticdsl {
+
+namespace {
+
+bool is_ident_start(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool is_ident_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool is_keyword(std::string_view word) {
+    static const std::unordered_set<std::string_view> keywords = {
+        "and", "or", "not", "in", "if", "else", "endif", "for", "endfor", "set",
+        "true", "false", "null", "include", "extends", "block", "endblock", "raw", "endraw"};
+    return keywords.count(word) > 0;
+}
+
+// 写入的键按字面值落在顶层（"a.b" 即键 a.b），而模板把 a.b 解析为路径 a/b；两者都记入写集
+void add_written_key(const std::string& key, std::unordered_set<std::string>& out) {
+    out.insert(key);
+    out.insert(key.substr(0, key.find('.')));
+}
+
+// 扫描 {{ }} / {% %} 内的一段表达式：跳过字符串字面量、成员访问（.name）和函数名（name(）
+void scan_code(std::string_view code, std::unordered_set<std::string>& out) {
+    size_t i = 0;
+    while (i < code.size()) {
+        char c = code[i];
+        if (c == '"' || c == '\'') {
+            for (++i; i < code.size() && code[i] != c; ++i) {
+                if (code[i] == '\\') ++i;
+            }
+            ++i;
+            continue;
+        }
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            while (i < code.size() && (is_ident_char(code[i]) || code[i] == '.')) ++i;
+            continue;
+        }
+        if (!is_ident_start(c)) {
+            ++i;
+            continue;
+        }
+
+        size_t start = i;
+        while (i < code.size() && is_ident_char(code[i])) ++i;
+        std::string_view word = code.substr(start, i - start);
+
+        size_t before = start;
+        while (before > 0 && std::isspace(static_cast<unsigned char>(code[before - 1]))) --before;
+        bool member = before > 0 && code[before - 1] == '.';
+        size_t after = i;
+        while (after < code.size() && std::isspace(static_cast<unsigned char>(code[after]))) ++after;
+        bool call = after < code.size() && code[after] == '(';
+
+        if (!member && !call && !is_keyword(word)) out.emplace(word);
+    }
+}
+
+} // namespace
+
+bool AccessSet::conflicts_with(const AccessSet& other) const {
+    if (opaque || other.opaque) return true;
+    auto intersects = [](const std::unordered_set<std::string>& a, const std::unordered_set<std::string>& b) {
+        for (const auto& key : a) {
+            if (b.count(key) > 0) return true;
+        }
+        return false;
+    };
+    return intersects(writes, other.reads) || intersects(reads, other.writes) || intersects(writes, other.writes);
+}
+
+std::optional<std::unordered_set<std::string>> template_reads(std::string_view tmpl) {
+    std::unordered_set<std::string> reads;
+    size_t pos = 0;
+    while ((pos = tmpl.find('{', pos)) != std::string_view::npos) {
+        if (pos + 1 >= tmpl.size()) break;
+        char kind = tmpl[pos + 1];
+        if (kind != '{' && kind != '%' && kind != '#') {
+            ++pos;
+            continue;
+        }
+        const char* close = kind == '{' ? "}}" : (kind == '%' ? "%}" : "#}");
+        size_t end = tmpl.find(close, pos + 2);
+        if (end == std::string_view::npos) return std::nullopt; // 未闭合，交给渲染期报错
+        if (kind != '#') scan_code(tmpl.substr(pos + 2, end - pos - 2), reads);
+        pos = end + 2;
+    }
+
+    // Inja 的行语句（## 开头的行）不在定界符内，不做分析
+    for (size_t line = 0; line < tmpl.size();) {
+        size_t first = tmpl.find_first_not_of(" \t", line);
+        if (first != std::string_view::npos && tmpl.substr(first, 2) == "##") return std::nullopt;
+        size_t next = tmpl.find('\n', line);
+        if (next == std::string_view::npos) break;
+        line = next + 1;
+    }
+    return reads;
+}
+
+AccessSet analyze_access(const Node& node) {
+    AccessSet access;
+    auto add_writes = [&access](const std::vector<std::string>& output_keys) {
+        for (const auto& key : output_keys) add_written_key(key, access.writes);
+    };
+    auto add_reads = [&access](const std::string& tmpl) {
+        auto reads = template_reads(tmpl);
+        if (!reads) {
+            access.opaque = true;
+            return;
+        }
+        access.reads.insert(reads->begin(), reads->end());
+    };
+
+    switch (node.type) {
+        case NodeType::ASSIGN:
+            for (const auto& [key, tmpl] : static_cast<const AssignNode&>(node).assign) {
+                if (key.find("{{") != std::string::npos) access.opaque = true; // 运行期才知道写入哪个键
+                add_written_key(key, access.writes);
+                add_reads(tmpl);
+            }
+            break;
+        case NodeType::TOOL_CALL: {
+            const auto& tool = static_cast<const ToolCallNode&>(node);
+            for (const auto& [_, tmpl] : tool.arguments) add_reads(tmpl);
+            add_writes(tool.output_keys);
+            break;
+        }
+        case NodeType::DSL_CALL: {
+            const auto& dsl = static_cast<const DSLNode&>(node);
+            add_reads(dsl.prompt_template);
+            add_writes(dsl.output_keys);
+            break;
+        }
+        default:
+            access.opaque = true;
+            break;
+    }
+    return access;
+}
+
+bool is_parallelizable(const Node& node) {
+    // LLM 调用经 LlamaAdapter 的连续批处理同时解码；调度器在整批合并后才按第一个 LLM 调用暂停
+    if (node.type != NodeType::TOOL_CALL && node.type != NodeType::DSL_CALL) return false;
+    const auto& meta = node.metadata;
+    if (!meta.is_object()) return true;
+    auto flag = [&meta](const char* key, bool fallback) {
+        auto it = meta.find(key);
+        return it != meta.end() && it->is_boolean() ? it->get<bool>() : fallback;
+    };
+    if (meta.contains("wait_for") && meta["wait_for"].is_string()) return false;
+    if (flag("snapshot_before_execution", false) || flag("rollback_on_failure", false)) return false;
+    return flag("parallel", true);
+}
+
+} // namespace agenticdsl
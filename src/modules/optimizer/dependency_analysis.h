@@ -0,0 +1,34 @@
+// modules/optimizer/include/optimizer/dependency_analysis.h
+#ifndef AGENTICDSL_MODULES_OPTIMIZER_DEPENDENCY_ANALYSIS_H
+#define AGENTICDSL_MODULES_OPTIMIZER_DEPENDENCY_ANALYSIS_H
+
+#include "core/types/node.h" // 引入 Node
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace agenticdsl {
+
+// 节点读写的顶层上下文键（读取 a.b.c 记为 a；写入 a.b 同时记 a.b 与 a）
+struct AccessSet {
+    std::unordered_set<std::string> reads;
+    std::unordered_set<std::string> writes;
+    bool opaque = false; // 无法静态分析，视为读写整个上下文
+
+    // 存在读后写、写后读或写后写任一冲突时，两节点的相对顺序会影响结果
+    bool conflicts_with(const AccessSet& other) const;
+};
+
+// 模板中引用的顶层变量（保守超集：多报只会少并行）；含行语句等无法分析的语法时返回 nullopt
+std::optional<std::unordered_set<std::string>> template_reads(std::string_view tmpl);
+
+// 由模板、output_keys 和 assign 键推导读写集；assign / tool_call / dsl_call 之外的节点一律 opaque
+AccessSet analyze_access(const Node& node);
+
+// 可以与其他节点并发执行的工具 / LLM 调用：没有动态 wait_for、不触发快照、未声明 parallel: false
+bool is_parallelizable(const Node& node);
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_MODULES_OPTIMIZER_DEPENDENCY_ANALYSIS_H
@@ -0,0 +1,381 @@
+// modules/optimizer/src/graph_optimizer.cpp
+#include "optimizer/graph_optimizer.h"
+#include "optimizer/dependency_analysis.h"
+#include "common/utils/template_renderer.h"
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace agenticdsl {
+
+namespace {
+
+bool has_dynamic_wait_for(const Node& node) {
+    return node.metadata.is_object() && node.metadata.contains("wait_for") && node.metadata["wait_for"].is_string();
+}
+
+// 运行期才确定引用目标的节点：生成的子图或动态 wait_for 可能指向任何路径
+bool references_dynamically(const Node& node) {
+    return node.type == NodeType::GENERATE_SUBGRAPH || node.type == NodeType::DSL_CALL || has_dynamic_wait_for(node);
+}
+
+// 静态 wait_for 依赖，解析规则与 TopoScheduler::build_dag 一致
+void append_static_wait_for(const Node& node, std::vector<NodePath>& out) {
+    if (!node.metadata.is_object() || !node.metadata.contains("wait_for")) return;
+    const auto& wf = node.metadata["wait_for"];
+    auto append = [&out](const nlohmann::json& v) {
+        if (v.is_array()) {
+            for (const auto& item : v) out.push_back(item.get<std::string>());
+        } else if (v.is_string()) {
+            out.push_back(v.get<std::string>());
+        }
+    };
+    if (wf.is_object()) {
+        if (wf.contains("all_of")) append(wf["all_of"]);
+        if (wf.contains("any_of")) append(wf["any_of"]);
+    } else if (wf.is_array()) {
+        append(wf);
+    }
+}
+
+// next 之外对其他节点路径的引用；fork 分支是路径前缀，单独返回
+void collect_references(const Node& node, std::vector<NodePath>& paths, std::vector<NodePath>& branch_prefixes) {
+    append_static_wait_for(node, paths);
+    switch (node.type) {
+        case NodeType::FORK: {
+            const auto& branches = static_cast<const ForkNode&>(node).branches;
+            branch_prefixes.insert(branch_prefixes.end(), branches.begin(), branches.end());
+            break;
+        }
+        case NodeType::JOIN: {
+            const auto& deps = static_cast<const JoinNode&>(node).wait_for;
+            paths.insert(paths.end(), deps.begin(), deps.end());
+            break;
+        }
+        case NodeType::ASSERT:
+            if (const auto& target = static_cast<const AssertNode&>(node).on_failure) paths.push_back(*target);
+            break;
+        case NodeType::GENERATE_SUBGRAPH:
+            if (const auto& target = static_cast<const GenerateSubgraphNode&>(node).on_signature_violation) paths.push_back(*target);
+            break;
+        default:
+            break;
+    }
+}
+
+bool in_branch(const NodePath& path, const NodePath& prefix) {
+    return path == prefix || path.rfind(prefix + "/", 0) == 0;
+}
+
+// 没有签名、权限和元数据的节点才能被删除或合并，否则会丢失其语义
+bool is_plain(const Node& node) {
+    return !node.signature.has_value() && node.permissions.empty() &&
+           (node.metadata.is_null() || node.metadata.empty());
+}
+
+// 与 NodeExecutor::execute_assert 的判定一致；只认恒为真的条件
+bool always_passes(const AssertNode& node) {
+    if (!node.compiled_condition || !node.compiled_condition->is_constant()) return false;
+    Value value;
+    try {
+        value = InjaTemplateRenderer::evaluate(*node.compiled_condition, Context::object());
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (value.is_boolean()) return value.get<bool>();
+    if (value.is_number()) return value != 0;
+    if (value.is_string()) return value.get<std::string>() == "true";
+    return false;
+}
+
+// 模板文本中是否以标识符形式出现 name（保守判断：误判只会放弃合并）
+bool mentions_identifier(const std::string& text, const std::string& name) {
+    auto is_ident = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+    for (size_t pos = text.find(name); pos != std::string::npos; pos = text.find(name, pos + 1)) {
+        bool left_ok = pos == 0 || !is_ident(text[pos - 1]);
+        size_t end = pos + name.size();
+        bool right_ok = end >= text.size() || !is_ident(text[end]);
+        if (left_ok && right_ok) return true;
+    }
+    return false;
+}
+
+bool reads_any_key(const AssignNode& reader, const AssignNode& writer) {
+    for (const auto& [key, _] : writer.assign) {
+        std::string root = key.substr(0, key.find('.'));
+        for (const auto& [__, tmpl] : reader.assign) {
+            if (mentions_identifier(tmpl, root)) return true;
+        }
+    }
+    return false;
+}
+
+// 优化过程中的图视图：按路径索引节点，已删除的节点置空
+class GraphView {
+public:
+    explicit GraphView(std::vector<std::unique_ptr<Node>>& nodes) : nodes_(nodes) {
+        for (size_t i = 0; i < nodes_.size(); ++i) index_[nodes_[i]->path] = i;
+    }
+
+    Node* find(const NodePath& path) const {
+        auto it = index_.find(path);
+        return it != index_.end() ? nodes_[it->second].get() : nullptr;
+    }
+
+    void remove(const NodePath& path) {
+        auto it = index_.find(path);
+        if (it == index_.end()) return;
+        nodes_[it->second].reset();
+        index_.erase(it);
+    }
+
+    template <typename Fn>
+    void for_each(Fn fn) const {
+        for (const auto& node : nodes_) {
+            if (node) fn(*node);
+        }
+    }
+
+    // 被 next 以外的方式引用、不能删除或改名的节点
+    std::unordered_set<NodePath> pinned(const std::optional<NodePath>& entry) const {
+        std::unordered_set<NodePath> result;
+        if (entry) result.insert(*entry);
+        std::vector<NodePath> paths;
+        std::vector<NodePath> prefixes;
+        for_each([&](const Node& node) { collect_references(node, paths, prefixes); });
+        result.insert(paths.begin(), paths.end());
+        for (const auto& prefix : prefixes) {
+            for_each([&](const Node& node) {
+                if (in_branch(node.path, prefix)) result.insert(node.path);
+            });
+        }
+        return result;
+    }
+
+    std::unordered_map<NodePath, std::vector<Node*>> predecessors() const {
+        std::unordered_map<NodePath, std::vector<Node*>> preds;
+        for (const auto& node : nodes_) {
+            if (!node) continue;
+            for (const auto& next : node->next) preds[next].push_back(node.get());
+        }
+        return preds;
+    }
+
+    void compact() {
+        nodes_.erase(std::remove(nodes_.begin(), nodes_.end(), nullptr), nodes_.end());
+    }
+
+private:
+    std::vector<std::unique_ptr<Node>>& nodes_;
+    std::unordered_map<NodePath, size_t> index_;
+};
+
+size_t prune_unreachable(GraphView& graph, const NodePath& entry) {
+    std::unordered_set<NodePath> reachable;
+    std::vector<NodePath> stack = {entry};
+    // 系统节点始终保留（预算超限等由调度器按路径跳转）
+    graph.for_each([&](const Node& node) {
+        if (node.path.rfind("/__system__/", 0) == 0) stack.push_back(node.path);
+    });
+
+    while (!stack.empty()) {
+        NodePath path = std::move(stack.back());
+        stack.pop_back();
+        const Node* node = graph.find(path);
+        if (!node || !reachable.insert(path).second) continue;
+
+        stack.insert(stack.end(), node->next.begin(), node->next.end());
+        std::vector<NodePath> prefixes;
+        collect_references(*node, stack, prefixes);
+        for (const auto& prefix : prefixes) {
+            graph.for_each([&](const Node& candidate) {
+                if (in_branch(candidate.path, prefix)) stack.push_back(candidate.path);
+            });
+        }
+    }
+
+    std::vector<NodePath> unreachable;
+    graph.for_each([&](const Node& node) {
+        if (reachable.count(node.path) == 0) unreachable.push_back(node.path);
+    });
+    for (const auto& path : unreachable) graph.remove(path);
+    return unreachable.size();
+}
+
+size_t bypass_constant_asserts(GraphView& graph, const std::optional<NodePath>& entry) {
+    auto pinned = graph.pinned(entry);
+    std::vector<NodePath> candidates;
+    graph.for_each([&](const Node& node) {
+        if (node.type == NodeType::ASSERT && is_plain(node) && pinned.count(node.path) == 0 &&
+            std::find(node.next.begin(), node.next.end(), node.path) == node.next.end() &&
+            always_passes(static_cast<const AssertNode&>(node))) {
+            candidates.push_back(node.path);
+        }
+    });
+
+    for (const auto& path : candidates) {
+        const std::vector<NodePath> successors = graph.find(path)->next;
+        // 前驱直接连到 assert 的后继：后继仍然等待 assert 原先等待的全部节点
+        auto preds = graph.predecessors();
+        for (Node* pred : preds[path]) {
+            std::vector<NodePath> rewired;
+            auto add = [&rewired](const NodePath& n) {
+                if (std::find(rewired.begin(), rewired.end(), n) == rewired.end()) rewired.push_back(n);
+            };
+            for (const auto& next : pred->next) {
+                if (next == path) {
+                    for (const auto& n : successors) add(n);
+                } else {
+                    add(next);
+                }
+            }
+            pred->next = std::move(rewired);
+        }
+        graph.remove(path);
+    }
+    return candidates.size();
+}
+
+size_t fuse_assign_chains(GraphView& graph, const std::optional<NodePath>& entry) {
+    auto pinned = graph.pinned(entry);
+    auto preds = graph.predecessors();
+    std::vector<NodePath> order;
+    graph.for_each([&](const Node& node) { order.push_back(node.path); });
+
+    size_t fused = 0;
+    for (const auto& path : order) {
+        Node* head = graph.find(path);
+        if (!head || head->type != NodeType::ASSIGN) continue;
+        auto* first = static_cast<AssignNode*>(head);
+
+        while (first->next.size() == 1) {
+            const NodePath successor_path = first->next[0];
+            Node* successor = graph.find(successor_path);
+            if (!successor || successor == first || successor->type != NodeType::ASSIGN ||
+                !is_plain(*successor) || pinned.count(successor_path) > 0 || preds[successor_path].size() != 1 ||
+                std::find(successor->next.begin(), successor->next.end(), first->path) != successor->next.end()) {
+                break;
+            }
+            auto* second = static_cast<AssignNode*>(successor);
+            // 同一节点内的赋值都基于执行前的上下文求值，后者读取前者的结果时不能合并
+            if (reads_any_key(*second, *first)) break;
+
+            for (auto& [key, tmpl] : second->assign) {
+                first->assign[key] = std::move(tmpl); // 同名键后者覆盖，与顺序执行结果一致
+                auto compiled = second->compiled_assign.find(key);
+                if (compiled != second->compiled_assign.end()) {
+                    first->compiled_assign[key] = std::move(compiled->second);
+                } else {
+                    first->compiled_assign.erase(key);
+                }
+            }
+            first->next = std::move(second->next);
+            for (const auto& next : first->next) {
+                std::replace(preds[next].begin(), preds[next].end(), successor, static_cast<Node*>(first));
+            }
+            graph.remove(successor_path);
+            ++fused;
+        }
+    }
+    return fused;
+}
+
+// 去掉不承载数据依赖的 next 边 A -> B：B 改为等待 A 的前驱，B 的后继改为同时等待 A。
+// 只处理工具调用之间的边；两端都不被其他方式引用，A 没有静态 wait_for（否则 B 会丢失这部分等待）
+size_t relax_independent_edges(GraphView& graph, const std::optional<NodePath>& entry) {
+    auto pinned = graph.pinned(entry);
+    std::unordered_map<NodePath, AccessSet> access;
+    auto eligible = [&](const Node& node) {
+        if (!is_parallelizable(node) || pinned.count(node.path) > 0) return false;
+        if (access.count(node.path) == 0) access.emplace(node.path, analyze_access(node));
+        return !access.at(node.path).opaque;
+    };
+    auto add_unique = [](std::vector<NodePath>& list, const NodePath& path) {
+        if (std::find(list.begin(), list.end(), path) == list.end()) list.push_back(path);
+    };
+
+    std::vector<NodePath> order;
+    graph.for_each([&](const Node& node) { order.push_back(node.path); });
+
+    size_t relaxed = 0;
+    bool changed = true;
+    // 每次放松都会新增边，设上限防止异常图（如含环）无法收敛
+    for (size_t round = 0; changed && round < order.size(); ++round) {
+        changed = false;
+        for (const auto& path : order) {
+            Node* first = graph.find(path);
+            if (!first || !eligible(*first)) continue;
+            std::vector<NodePath> wf;
+            append_static_wait_for(*first, wf);
+            if (!wf.empty()) continue;
+
+            auto preds = graph.predecessors();
+            const auto& first_preds = preds[path];
+            if (first_preds.empty()) continue; // 入口或根节点：放松后 B 将失去调度起点
+
+            for (const NodePath& successor_path : std::vector<NodePath>(first->next)) {
+                Node* second = graph.find(successor_path);
+                if (!second || second == first || !eligible(*second) ||
+                    std::find(second->next.begin(), second->next.end(), path) != second->next.end() ||
+                    access.at(path).conflicts_with(access.at(successor_path))) {
+                    continue;
+                }
+
+                first->next.erase(std::find(first->next.begin(), first->next.end(), successor_path));
+                for (Node* pred : first_preds) add_unique(pred->next, successor_path);
+                for (const auto& next : second->next) add_unique(first->next, next);
+                ++relaxed;
+                changed = true;
+            }
+        }
+    }
+    return relaxed;
+}
+
+} // namespace
+
+OptimizerStats GraphOptimizer::optimize(std::vector<std::unique_ptr<Node>>& nodes, const std::optional<NodePath>& entry) const {
+    OptimizerStats stats;
+    GraphView graph(nodes);
+
+    // 只改边、不删除或改名节点，运行期按路径的引用不受影响
+    if (options_.relax_edges) {
+        stats.relaxed_edges = relax_independent_edges(graph, entry);
+    }
+
+    bool dynamic = false;
+    graph.for_each([&](const Node& node) { dynamic = dynamic || references_dynamically(node); });
+    if (dynamic) {
+        return stats; // 运行期可能引用任意节点路径，结构保持不变
+    }
+
+    if (options_.prune_unreachable && entry && graph.find(*entry)) {
+        stats.pruned_nodes = prune_unreachable(graph, *entry);
+    }
+    if (options_.fold_constants) {
+        stats.folded_nodes = bypass_constant_asserts(graph, entry);
+    }
+    if (options_.fuse_assigns) {
+        stats.fused_assigns = fuse_assign_chains(graph, entry);
+    }
+    graph.compact();
+    return stats;
+}
+
+std::optional<NodePath> GraphOptimizer::find_entry_point(const std::vector<ParsedGraph>& graphs) {
+    for (const auto& graph : graphs) {
+        // Check /__meta__ for entry_point
+        if (graph.path == "/__meta__" && graph.metadata.contains("entry_point")) {
+            return graph.metadata["entry_point"].get<std::string>();
+        }
+        // Also check /main for entry (v3.x format); entry is node ID, need to prepend graph path
+        if (graph.path == "/main" && graph.metadata.contains("entry")) {
+            return graph.path + "/" + graph.metadata["entry"].get<std::string>();
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace agenticdsl
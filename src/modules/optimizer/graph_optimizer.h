@@ -0,0 +1,51 @@
+// modules/optimizer/include/optimizer/graph_optimizer.h
+#ifndef AGENTICDSL_MODULES_OPTIMIZER_GRAPH_OPTIMIZER_H
+#define AGENTICDSL_MODULES_OPTIMIZER_GRAPH_OPTIMIZER_H
+
+#include "core/types/node.h" // 引入 Node, NodePath, ParsedGraph
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace agenticdsl {
+
+struct OptimizerStats {
+    size_t pruned_nodes = 0;   // 从入口不可达而删除的节点
+    size_t folded_nodes = 0;   // 条件恒为真而旁路的 assert 节点
+    size_t fused_assigns = 0;  // 并入前驱的 assign 节点
+    size_t relaxed_edges = 0;  // 去掉的无数据依赖 next 边
+};
+
+// 解析之后、TopoScheduler::build_dag() 之前的图优化：
+//   1. 删除从入口不可达的节点
+//   2. 条件在编译期折叠为真的 assert 节点直接旁路（模板本身的常量折叠见 InjaTemplateRenderer::compile）
+//   3. 把 A -> B 的 assign 链合并为一个节点（B 只有 A 一个前驱、且不读取 A 写入的键）
+//   4. 去掉读写集互不相交的工具调用之间的 next 边，使它们可以被调度器并发执行（见 dependency_analysis.h）
+// 图中存在 generate_subgraph / dsl_call 或动态 wait_for 时，运行期可能按路径引用任意节点，只做第 4 步和模板折叠
+class GraphOptimizer {
+public:
+    struct Options {
+        bool prune_unreachable = true;
+        bool fold_constants = true;
+        bool fuse_assigns = true;
+        bool relax_edges = true;
+        Options() = default;
+    };
+
+    GraphOptimizer() = default;
+    explicit GraphOptimizer(Options options) : options_(options) {}
+
+    // entry 为空时调度器从所有入度为 0 的节点开始，此时不做可达性裁剪
+    OptimizerStats optimize(std::vector<std::unique_ptr<Node>>& nodes, const std::optional<NodePath>& entry) const;
+
+    // 执行入口：/__meta__ 的 entry_point，否则 /main 的 entry
+    static std::optional<NodePath> find_entry_point(const std::vector<ParsedGraph>& graphs);
+
+private:
+    Options options_;
+};
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_MODULES_OPTIMIZER_GRAPH_OPTIMIZER_H
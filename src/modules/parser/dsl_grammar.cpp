@@ -0,0 +1,60 @@
+// modules/parser/src/dsl_grammar.cpp
+#include "dsl_grammar.h"
+#include <array>
+
+namespace agenticdsl {
+
+namespace {
+
+// 与 MarkdownParser::create_node_from_json 支持的类型保持一致
+constexpr std::array<std::string_view, 11> kNodeTypes = {
+    "start", "end", "assign", "dsl_call", "llm_call", "tool_call",
+    "resource", "fork", "join", "generate_subgraph", "assert",
+};
+
+// GBNF 字符串字面量
+std::string literal(std::string_view text) {
+    std::string out = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            default: out += c;
+        }
+    }
+    out += '"';
+    return out;
+}
+
+} // namespace
+
+std::string dsl_block_grammar(std::string_view path_prefix) {
+    std::string node_type;
+    for (auto type : kNodeTypes) {
+        if (!node_type.empty()) node_type += " | ";
+        node_type += literal(type);
+    }
+
+    std::string g;
+    g += "root ::= block (\"\\n\" block)*\n";
+    g += "block ::= \"### AgenticDSL `\" path \"`\\n```yaml\\n# --- BEGIN AgenticDSL ---\\n\" body "
+         "\"# --- END AgenticDSL ---\\n```\\n\"\n";
+    g += "path ::= " + literal(path_prefix) + " segment (\"/\" segment)*\n";
+    g += "segment ::= [a-zA-Z0-9_-]+\n";
+    g += "body ::= graph | node\n";
+    // 图：顶层字段（signature、permissions、metadata 等）+ nodes 列表
+    g += "graph ::= field* \"nodes:\\n\" item+\n";
+    g += "item ::= \"  - id: \" ident \"\\n    type: \" node-type \"\\n\" item-field*\n";
+    g += "item-field ::= \"    \" [^\\n]+ \"\\n\"\n";
+    // 单节点块
+    g += "node ::= \"type: \" node-type \"\\n\" field*\n";
+    g += "field ::= key \":\" [^\\n]* \"\\n\" nested*\n";
+    g += "nested ::= \"  \" [^\\n]* \"\\n\"\n";
+    g += "key ::= [a-z_] [a-z0-9_]*\n";
+    g += "ident ::= [a-zA-Z_] [a-zA-Z0-9_]*\n";
+    g += "node-type ::= " + node_type + "\n";
+    return g;
+}
+
+} // namespace agenticdsl
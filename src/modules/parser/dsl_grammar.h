@@ -0,0 +1,24 @@
+// modules/parser/include/parser/dsl_grammar.h
+#ifndef AGENTICDSL_MODULES_PARSER_DSL_GRAMMAR_H
+#define AGENTICDSL_MODULES_PARSER_DSL_GRAMMAR_H
+
+#include <string>
+#include <string_view>
+
+namespace agenticdsl {
+
+// generate_subgraph 输出的 GBNF 语法（根规则 root）：一个或多个
+//   ### AgenticDSL `<path_prefix>...`
+//   ```yaml
+//   # --- BEGIN AgenticDSL ---
+//   ...
+//   # --- END AgenticDSL ---
+//   ```
+// 块，块外不允许任何文字。块内约束到 YAML 的行结构：图（顶层字段 + nodes 列表，
+// 每项以 id、type 开头）或单节点（以 type 开头），type 只能是 parser 支持的节点类型；
+// 字段值本身不受约束，仍由 parser 与签名校验把关
+std::string dsl_block_grammar(std::string_view path_prefix = "/dynamic/");
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_MODULES_PARSER_DSL_GRAMMAR_H
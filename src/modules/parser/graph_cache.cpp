@@ -0,0 +1,203 @@
+// modules/parser/src/graph_cache.cpp
+#include "parser/graph_cache.h"
+#include "common/utils/cache_dir.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace agenticdsl {
+
+namespace {
+
+constexpr char kMagic[4] = {'A', 'D', 'G', 'C'};
+// 块文档的结构或节点构建规则变化时递增，使旧缓存失效
+// 2: YAML 到文档的转换与节点构建规则调整，版本 1 的条目不再可信
+constexpr std::uint8_t kFormatVersion = 2;
+constexpr size_t kHeaderSize = 4 + 1 + 3 + 8 + 8; // magic, version, reserved, hash, source_size
+
+void put_u64(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<std::uint8_t>((v >> (8 * i)) & 0xFF));
+}
+
+std::uint64_t get_u64(const std::uint8_t* p) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+// 只读映射整个文件；不支持 mmap 的平台退化为一次性读入
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path) {
+#if !defined(_WIN32)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st {};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data_ = static_cast<const std::uint8_t*>(addr);
+                size_ = static_cast<size_t>(st.st_size);
+            }
+        }
+        ::close(fd);
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return;
+        buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = reinterpret_cast<const std::uint8_t*>(buffer_.data());
+        size_ = buffer_.size();
+#endif
+    }
+
+    ~MappedFile() {
+#if !defined(_WIN32)
+        if (data_) ::munmap(const_cast<std::uint8_t*>(data_), size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const std::uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const std::uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32)
+    std::string buffer_;
+#endif
+};
+
+} // namespace
+
+GraphCache::GraphCache() : cache_dir_(default_directory()) {}
+
+GraphCache::GraphCache(std::filesystem::path cache_dir) : cache_dir_(std::move(cache_dir)) {}
+
+std::filesystem::path GraphCache::default_directory() {
+    if (const char* dir = std::getenv("AGENTICDSL_GRAPH_CACHE_DIR"); dir && *dir) {
+        return std::filesystem::path(dir);
+    }
+    return user_cache_directory("agenticdsl-graph-cache");
+}
+
+std::uint64_t GraphCache::source_hash(std::string_view content) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : content) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::filesystem::path GraphCache::entry_path(std::uint64_t hash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.adgc", static_cast<unsigned long long>(hash));
+    return cache_dir_ / name;
+}
+
+std::vector<ParsedGraph> GraphCache::load(const std::string& markdown_content, MarkdownParser& parser) {
+    if (!enabled()) {
+        return parser.build_graphs(parser.load_documents(markdown_content));
+    }
+
+    const std::uint64_t hash = source_hash(markdown_content);
+    if (auto cached = read_entry(hash, markdown_content.size())) {
+        return parser.build_graphs(*cached);
+    }
+
+    auto documents = parser.load_documents(markdown_content);
+    auto graphs = parser.build_graphs(documents); // 先构建，确保只缓存可用的文档
+    write_entry(hash, markdown_content.size(), documents);
+    return graphs;
+}
+
+std::vector<ParsedGraph> GraphCache::load_file(const std::string& file_path, MarkdownParser& parser) {
+    std::ifstream file(file_path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + file_path);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return load(buffer.str(), parser);
+}
+
+std::optional<std::vector<MarkdownParser::BlockDocument>> GraphCache::read_entry(std::uint64_t hash, size_t source_size) const {
+    MappedFile file(entry_path(hash));
+    const std::uint8_t* data = file.data();
+    if (!data || file.size() < kHeaderSize) return std::nullopt;
+
+    if (std::memcmp(data, kMagic, sizeof(kMagic)) != 0 || data[4] != kFormatVersion ||
+        get_u64(data + 8) != hash || get_u64(data + 16) != source_size) {
+        return std::nullopt; // 格式不符或哈希碰撞：视为未命中，稍后覆盖
+    }
+
+    try {
+        auto payload = nlohmann::json::from_cbor(data + kHeaderSize, data + file.size());
+        std::vector<MarkdownParser::BlockDocument> documents;
+        documents.reserve(payload.size());
+        for (auto& entry : payload) {
+            documents.push_back({entry.at(0).get<std::string>(), std::move(entry.at(1))});
+        }
+        return documents;
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "[WARNING] Ignoring corrupt graph cache entry " << entry_path(hash) << ": " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+void GraphCache::write_entry(std::uint64_t hash, size_t source_size,
+                             const std::vector<MarkdownParser::BlockDocument>& documents) const {
+    nlohmann::json payload = nlohmann::json::array();
+    for (const auto& doc : documents) {
+        payload.push_back(nlohmann::json::array({doc.path, doc.doc}));
+    }
+
+    std::vector<std::uint8_t> out(std::begin(kMagic), std::end(kMagic));
+    out.push_back(kFormatVersion);
+    out.insert(out.end(), 3, 0); // reserved
+    put_u64(out, hash);
+    put_u64(out, source_size);
+    nlohmann::json::to_cbor(payload, out);
+
+    std::error_code ec;
+    std::filesystem::create_directories(cache_dir_, ec);
+    if (ec) return;
+
+    // 先写临时文件再 rename，并发加载同一源文本的进程不会读到半截数据
+    const auto target = entry_path(hash);
+    auto tmp = target;
+    tmp += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()) ^
+                                   static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) return;
+        f.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+        if (!f) {
+            f.close();
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp, target, ec);
+    if (ec) std::filesystem::remove(tmp, ec);
+}
+
+} // namespace agenticdsl
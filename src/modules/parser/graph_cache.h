@@ -0,0 +1,45 @@
+// modules/parser/include/parser/graph_cache.h
+#ifndef AGENTICDSL_MODULES_PARSER_GRAPH_CACHE_H
+#define AGENTICDSL_MODULES_PARSER_GRAPH_CACHE_H
+
+#include "markdown_parser.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace agenticdsl {
+
+// 编译后的图缓存：以源文本哈希为键，保存每个块的 JSON 文档（CBOR 编码）。
+// 命中时通过 mmap 读取并直接构建节点，跳过 Markdown 扫描与 YAML 解析；
+// 源文本变化后哈希不同，旧条目自然失效并在下次加载时重建。
+class GraphCache {
+public:
+    // 默认目录：$AGENTICDSL_GRAPH_CACHE_DIR，否则为当前用户的缓存目录（见 user_cache_directory）；
+    // 目录为空时不读写缓存，每次都完整解析
+    GraphCache();
+    explicit GraphCache(std::filesystem::path cache_dir);
+
+    // 命中缓存则直接构建；否则解析 Markdown 并写入缓存（写入失败不影响结果）
+    std::vector<ParsedGraph> load(const std::string& markdown_content, MarkdownParser& parser);
+    std::vector<ParsedGraph> load_file(const std::string& file_path, MarkdownParser& parser);
+
+    const std::filesystem::path& directory() const { return cache_dir_; }
+    bool enabled() const { return !cache_dir_.empty(); }
+
+    static std::filesystem::path default_directory();
+    static std::uint64_t source_hash(std::string_view content); // FNV-1a 64
+
+private:
+    std::filesystem::path entry_path(std::uint64_t hash) const;
+    std::optional<std::vector<MarkdownParser::BlockDocument>> read_entry(std::uint64_t hash, size_t source_size) const;
+    void write_entry(std::uint64_t hash, size_t source_size, const std::vector<MarkdownParser::BlockDocument>& documents) const;
+
+    std::filesystem::path cache_dir_;
+};
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_MODULES_PARSER_GRAPH_CACHE_H
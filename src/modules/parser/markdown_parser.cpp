@@ -3,15 +3,19 @@
 #include "common/utils/parser_utils.h"
 #include "common/utils/yaml_json.h"
 #include "common/utils/template_renderer.h"
+#include "common/utils/signature.h"
 #include "core/types/node.h" 
 #include "core/types/resource.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
 #include <nlohmann/json.hpp>
 #include <yaml-cpp/yaml.h>
-#include <regex> // For parsing signature (if needed for output_schema)
 
 namespace agenticdsl {
 
@@ -34,6 +38,34 @@ inline std::vector<std::string> parse_output_keys(const nlohmann::json& node_jso
     }
 }
 
+// 解析期预编译模板；语法错误留到执行期按原路径报告
+inline CompiledTemplatePtr precompile_template(const std::string& source) {
+    try {
+        return InjaTemplateRenderer::compile(source);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+// 解析期编译签名；语法错误只告警，节点/图仍可加载（执行器按 signature_validation 处理）
+inline SignaturePtr compile_signature(const std::string& source) {
+    try {
+        return std::make_shared<const Signature>(Signature::parse(source));
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING] " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+// v3.1: 图签名及其 outputs 描述（供 available_subgraphs 展示）
+inline void set_graph_signature(ParsedGraph& graph, std::string signature, SignaturePtr compiled) {
+    graph.compiled_signature = std::move(compiled);
+    if (graph.compiled_signature && !graph.compiled_signature->outputs().empty()) {
+        graph.output_schema = graph.compiled_signature->outputs_json();
+    }
+    graph.signature = std::move(signature);
+}
+
 // Parse ResourceType from string
 inline ResourceType parse_resource_type(const std::string& type_str) {
     if (type_str == "file") return ResourceType::FILE;
@@ -46,62 +78,203 @@ inline ResourceType parse_resource_type(const std::string& type_str) {
     throw std::runtime_error("Unknown resource_type '" + type_str + "'");
 }
 
-std::vector<ParsedGraph> MarkdownParser::parse_from_string(const std::string& markdown_content) {
+size_t MarkdownParser::worker_count(size_t items) const {
+    size_t threads = parse_threads_ == 0 ? std::max(1u, std::thread::hardware_concurrency()) : parse_threads_;
+    return std::min(threads, items / kMinBlocksPerThread);
+}
+
+// 对 [0, count) 执行 fn；线程数 > 1 时工作线程按原子下标领取任务。
+// 结果由 fn 按下标写回，保证输出确定；出错时重新抛出下标最小（文档中最靠前）的异常
+template <typename Fn>
+static void run_indexed(size_t count, size_t threads, Fn&& fn) {
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(count);
+    std::atomic<size_t> next_index{0};
+    auto worker = [&]() {
+        for (size_t i = next_index++; i < count; i = next_index++) {
+            try {
+                fn(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& th : pool) {
+        th.join();
+    }
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+std::vector<ParsedGraph> MarkdownParser::assemble(std::vector<BlockResult> results) {
     std::vector<ParsedGraph> graphs;
     std::optional<ExecutionBudget> global_budget; // 临时存储 /__meta__ 中的预算
-    auto pathed_blocks = extract_pathed_blocks(markdown_content);
+    for (auto& result : results) {
+        if (result.budget.has_value()) {
+            global_budget = std::move(result.budget);
+        }
+        if (result.graph.has_value()) {
+            graphs.push_back(std::move(*result.graph));
+        }
+    }
+
+    // 将 global_budget 注入到 graphs 中（例如附加到第一个图，或单独存储）
+    // 方案：注入到第一个图（或任意图），TopoScheduler 会检查
+    if (global_budget.has_value() && !graphs.empty()) {
+        graphs[0].budget = std::move(global_budget);
+    }
+
+    return graphs;
+}
+
+std::vector<ParsedGraph> MarkdownParser::parse_from_string(const std::string& markdown_content) {
+    auto blocks = scan_pathed_blocks(markdown_content);
+    std::vector<BlockResult> results(blocks.size());
+    run_indexed(blocks.size(), worker_count(blocks.size()), [&](size_t i) {
+        results[i] = build_block(load_block(blocks[i].path, blocks[i].content));
+    });
+    return assemble(std::move(results));
+}
+
+std::vector<MarkdownParser::BlockDocument> MarkdownParser::load_documents(const std::string& markdown_content) {
+    auto blocks = scan_pathed_blocks(markdown_content);
+    std::vector<BlockDocument> documents(blocks.size());
+    run_indexed(blocks.size(), worker_count(blocks.size()), [&](size_t i) {
+        documents[i] = load_block(blocks[i].path, blocks[i].content);
+    });
+    return documents;
+}
+
+std::vector<ParsedGraph> MarkdownParser::build_graphs(const std::vector<BlockDocument>& documents) {
+    std::vector<BlockResult> results(documents.size());
+    run_indexed(documents.size(), worker_count(documents.size()), [&](size_t i) {
+        results[i] = build_block(documents[i]);
+    });
+    return assemble(std::move(results));
+}
+
+MarkdownParser::BlockDocument MarkdownParser::load_block(std::string_view path_view, std::string_view content) {
+    BlockDocument block;
+    block.path = NodePath(path_view);
+    if (!is_valid_node_path(block.path)) {
+        throw std::runtime_error("Invalid node path format: " + block.path);
+    }
+
+    try {
+        block.doc = parse_yaml_to_json(content); // 事件流直接构建 JSON，不生成 YAML::Node 树
+    } catch (const YAML::ParserException& e) {
+        throw std::runtime_error("YAML parse error in block '" + block.path + "': " + e.what());
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Error parsing block '" + block.path + "': " + std::string(e.what()));
+    }
+    return block;
+}
 
-    for (auto& [path, yaml_content] : pathed_blocks) {
-        if (!is_valid_node_path(path)) {
-            throw std::runtime_error("Invalid node path format: " + path);
+MarkdownParser::BlockResult MarkdownParser::build_block(const BlockDocument& block) {
+    BlockResult result;
+    const NodePath& path = block.path;
+    const nlohmann::json& json_doc = block.doc;
+
+    try {
+        if (path == "/__meta__") {
+            // 提取 execution_budget（如果存在）
+            if (json_doc.contains("execution_budget")) {
+                const auto& bj = json_doc["execution_budget"];
+                ExecutionBudget budget;
+                if (bj.contains("max_nodes") && bj["max_nodes"].is_number_integer()) {
+                    budget.max_nodes = bj["max_nodes"].get<int>();
+                }
+                if (bj.contains("max_llm_calls") && bj["max_llm_calls"].is_number_integer()) {
+                    budget.max_llm_calls = bj["max_llm_calls"].get<int>();
+                }
+                if (bj.contains("max_duration_sec") && bj["max_duration_sec"].is_number_integer()) {
+                    budget.max_duration_sec = bj["max_duration_sec"].get<int>();
+                }
+                if (bj.contains("max_subgraph_depth") && bj["max_subgraph_depth"].is_number_integer()) {
+                    budget.max_subgraph_depth = bj["max_subgraph_depth"].get<int>();
+                }
+                if (bj.contains("max_snapshots") && bj["max_snapshots"].is_number_integer()) {
+                    budget.max_snapshots = bj["max_snapshots"].get<int>();
+                }
+                if (bj.contains("snapshot_max_size_kb") && bj["snapshot_max_size_kb"].is_number_integer()) {
+                    budget.snapshot_max_size_kb = bj["snapshot_max_size_kb"].get<size_t>();
+                }
+                if (bj.contains("snapshot_format") && bj["snapshot_format"].is_string()) {
+                    budget.snapshot_format = bj["snapshot_format"].get<std::string>();
+                }
+                if (bj.contains("snapshot_compression") && bj["snapshot_compression"].is_boolean()) {
+                    budget.snapshot_compression = bj["snapshot_compression"].get<bool>();
+                }
+                result.budget = std::move(budget);
+            }
+            return result; // /__meta__ 不是可执行的子图，跳过
         }
 
-        try {
-            YAML::Node yaml_root = YAML::Load(yaml_content);
-            nlohmann::json json_doc = yaml_to_json(yaml_root);
-
-            if (path == "/__meta__") {
-                // 提取 execution_budget（如果存在）
-                if (json_doc.contains("execution_budget")) {
-                    const auto& bj = json_doc["execution_budget"];
-                    ExecutionBudget budget;
-                    if (bj.contains("max_nodes") && bj["max_nodes"].is_number_integer()) {
-                        budget.max_nodes = bj["max_nodes"].get<int>();
-                    }
-                    if (bj.contains("max_llm_calls") && bj["max_llm_calls"].is_number_integer()) {
-                        budget.max_llm_calls = bj["max_llm_calls"].get<int>();
-                    }
-                    if (bj.contains("max_duration_sec") && bj["max_duration_sec"].is_number_integer()) {
-                        budget.max_duration_sec = bj["max_duration_sec"].get<int>();
-                    }
-                    if (bj.contains("max_subgraph_depth") && bj["max_subgraph_depth"].is_number_integer()) {
-                        budget.max_subgraph_depth = bj["max_subgraph_depth"].get<int>();
+        // Handle subgraph (e.g., /main, /lib/reasoning/example)
+        if (json_doc.contains("graph_type") && json_doc["graph_type"] == "subgraph") {
+            ParsedGraph graph;
+            graph.path = path;
+            graph.metadata = json_doc.value("metadata", nlohmann::json::object());
+            // Also extract entry from root level if present
+            if (json_doc.contains("entry")) {
+                graph.metadata["entry"] = json_doc["entry"];
+            }
+
+            if (json_doc.contains("signature")) {
+                std::string signature = json_doc["signature"].get<std::string>();
+                SignaturePtr compiled = compile_signature(signature);
+                set_graph_signature(graph, std::move(signature), std::move(compiled));
+            }
+            if (json_doc.contains("permissions") && json_doc["permissions"].is_array()) {
+                for (const auto& p : json_doc["permissions"]) {
+                    if (p.is_string()) {
+                        graph.permissions.push_back(p.get<std::string>());
                     }
-                    if (bj.contains("max_snapshots") && bj["max_snapshots"].is_number_integer()) {
-                        budget.max_snapshots = bj["max_snapshots"].get<int>();
+                }
+            }
+            graph.is_standard_library = (path.rfind("/lib/", 0) == 0); // 以 /lib/ 开头
+
+            if (json_doc.contains("nodes") && json_doc["nodes"].is_array()) {
+                for (const auto& node_json : json_doc["nodes"]) {
+                    std::string id = node_json.value("id", "");
+                    if (id.empty()) {
+                        throw std::runtime_error("Node in subgraph '" + path + "' missing 'id'");
                     }
-                    if (bj.contains("snapshot_max_size_kb") && bj["snapshot_max_size_kb"].is_number_integer()) {
-                        budget.snapshot_max_size_kb = bj["snapshot_max_size_kb"].get<size_t>();
+                    NodePath node_path = path + "/" + id;
+                    auto node = create_node_from_json(node_path, node_json);
+                    if (node) {
+                        graph.nodes.push_back(std::move(node));
                     }
-                    global_budget = std::move(budget);
                 }
-                continue; // /__meta__ 不是可执行的子图，跳过
             }
+            result.graph = std::move(graph);
+            return result;
+        }
 
-            // Handle subgraph (e.g., /main, /lib/reasoning/example)
-            if (json_doc.contains("graph_type") && json_doc["graph_type"] == "subgraph") {
+        // Handle single node (standalone block representing one node)
+        if (json_doc.contains("type")) {
+            auto node = create_node_from_json(path, json_doc);
+            if (node) {
                 ParsedGraph graph;
                 graph.path = path;
                 graph.metadata = json_doc.value("metadata", nlohmann::json::object());
-                // Also extract entry from root level if present
-                if (json_doc.contains("entry")) {
-                    graph.metadata["entry"] = json_doc["entry"];
-                }
 
-                if (json_doc.contains("signature")) {
-                    graph.signature = json_doc["signature"].get<std::string>();
-                    // v3.1: Parse output_schema from signature
-                    graph.output_schema = parse_output_schema_from_signature(graph.signature.value());
+                // 单节点图也可有 signature
+                if (node->signature.has_value()) {
+                    set_graph_signature(graph, *node->signature, node->compiled_signature); // 与节点共用同一份编译结果
                 }
                 if (json_doc.contains("permissions") && json_doc["permissions"].is_array()) {
                     for (const auto& p : json_doc["permissions"]) {
@@ -110,66 +283,16 @@ std::vector<ParsedGraph> MarkdownParser::parse_from_string(const std::string& ma
                         }
                     }
                 }
-                graph.is_standard_library = (path.rfind("/lib/", 0) == 0); // 以 /lib/ 开头
-
-                if (json_doc.contains("nodes") && json_doc["nodes"].is_array()) {
-                    for (const auto& node_json : json_doc["nodes"]) {
-                        std::string id = node_json.value("id", "");
-                        if (id.empty()) {
-                            throw std::runtime_error("Node in subgraph '" + path + "' missing 'id'");
-                        }
-                        NodePath node_path = path + "/" + id;
-                        auto node = create_node_from_json(node_path, node_json);
-                        if (node) {
-                            graph.nodes.push_back(std::move(node));
-                        }
-                    }
-                }
-                graphs.push_back(std::move(graph));
-                continue;
-            }
-
-            // Handle single node (standalone block representing one node)
-            if (json_doc.contains("type")) {
-                auto node = create_node_from_json(path, json_doc);
-                if (node) {
-                    ParsedGraph graph;
-                    graph.path = path;
-                    graph.metadata = json_doc.value("metadata", nlohmann::json::object());
-
-                    // 单节点图也可有 signature
-                    if (json_doc.contains("signature")) {
-                        graph.signature = json_doc["signature"].get<std::string>();
-                        // v3.1: Parse output_schema from signature
-                        graph.output_schema = parse_output_schema_from_signature(graph.signature.value());
-                    }
-                    if (json_doc.contains("permissions") && json_doc["permissions"].is_array()) {
-                        for (const auto& p : json_doc["permissions"]) {
-                            if (p.is_string()) {
-                                graph.permissions.push_back(p.get<std::string>());
-                            }
-                        }
-                    }
-                    graph.is_standard_library = (path.rfind("/lib/", 0) == 0);
+                graph.is_standard_library = (path.rfind("/lib/", 0) == 0);
 
-                    graph.nodes.push_back(std::move(node));
-                    graphs.push_back(std::move(graph));
-                }
+                graph.nodes.push_back(std::move(node));
+                result.graph = std::move(graph);
             }
-        } catch (const YAML::ParserException& e) {
-            throw std::runtime_error("YAML parse error in block '" + path + "': " + e.what());
-        } catch (const std::exception& e) {
-            throw std::runtime_error("Error parsing block '" + path + "': " + std::string(e.what()));
         }
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Error parsing block '" + path + "': " + std::string(e.what()));
     }
-
-    // 将 global_budget 注入到 graphs 中（例如附加到第一个图，或单独存储）
-    // 方案：注入到第一个图（或任意图），TopoScheduler 会检查
-    if (global_budget.has_value() && !graphs.empty()) {
-        graphs[0].budget = std::move(global_budget);
-    }
-
-    return graphs;
+    return result;
 }
 
 std::vector<ParsedGraph> MarkdownParser::parse_from_file(const std::string& file_path) {
@@ -206,8 +329,10 @@ std::unique_ptr<Node> MarkdownParser::create_node_from_json(const NodePath& path
     // Extract node-level signature / permissions (v3.1)
     std::optional<std::string> signature = std::nullopt;
     std::vector<std::string> permissions;
+    SignaturePtr compiled_signature;
     if (node_json.contains("signature")) {
         signature = node_json["signature"].get<std::string>();
+        compiled_signature = compile_signature(*signature);
     }
     if (node_json.contains("permissions") && node_json["permissions"].is_array()) {
         for (const auto& p : node_json["permissions"]) {
@@ -221,6 +346,7 @@ std::unique_ptr<Node> MarkdownParser::create_node_from_json(const NodePath& path
         auto node = std::make_unique<StartNode>(path, std::move(next_paths));
         node->metadata = metadata;
         node->signature = signature;
+        node->compiled_signature = compiled_signature;
         node->permissions = permissions;
         return node;
     } else if (type_str == "end") {
@@ -228,6 +354,7 @@ std::unique_ptr<Node> MarkdownParser::create_node_from_json(const NodePath& path
         node->next = std::move(next_paths);
         node->metadata = metadata;
         node->signature = signature;
+        node->compiled_signature = compiled_signature;
         node->permissions = permissions;
         return node;
     } else if (type_str == "assign") {
@@ -238,8 +365,12 @@ std::unique_ptr<Node> MarkdownParser::create_node_from_json(const NodePath& path
             }
         }
         auto node = std::make_unique<AssignNode>(path, std::move(assign), std::move(next_paths));
+        for (const auto& [key, tmpl] : node->assign) {
+            node->compiled_assign[key] = precompile_template(tmpl);
+        }
         node->metadata = metadata;
         node->signature = signature;
+        node->compiled_signature = compiled_signature;
         node->permissions = permissions;
         return node;
     } else if (type_str == "dsl_call") {
@@ -254,15 +385,21 @@ std::unique_ptr<Node> MarkdownParser::create_node_from_json(const NodePath& path
             if (params.contains("temperature")) llm_params.temperature = params["temperature"].get<float>();
             if (params.contains("max_tokens")) llm_params.max_tokens = params["max_tokens"].get<int>();
             if (params.contains("top_p")) llm_params.top_p = params["top_p"].get<float>();
+            if (params.contains("top_k")) llm_params.top_k = params["top_k"].get<int>();
+            if (params.contains("min_p")) llm_params.min_p = params["min_p"].get<float>();
+            if (params.contains("seed")) llm_params.seed = params["seed"].get<int64_t>();
             if (params.contains("n_ctx")) llm_params.n_ctx = params["n_ctx"].get<int>();
             if (params.contains("n_threads")) llm_params.n_threads = params["n_threads"].get<int>();
             if (params.contains("model")) llm_params.model = params["model"].get<std::string>();
+            if (params.contains("grammar")) llm_params.grammar = params["grammar"].get<std::string>();
         }
         
         auto node = std::make_unique<DSLNode>(path, std::move(prompt), std::move(llm_tool_name), 
                                               std::move(llm_params), std::move(output_keys), std::move(next_paths));
+        node->compiled_prompt = precompile_template(node->prompt_template);
         node->metadata = metadata;
         node->signature = signature;
+        node->compiled_signature = compiled_signature;
         node->permissions = permissions;
         return node;
     } else if (type_str == "llm_call") {
@@ -276,8 +413,10 @@ std::unique_ptr<Node> MarkdownParser::create_node_from_json(const NodePath& path
         
         auto node = std::make_unique<DSLNode>(path, std::move(prompt), std::move(llm_tool_name), 
                                               std::move(llm_params), std::move(output_keys), std::move(next_paths));
+        node->compiled_prompt = precompile_template(node->prompt_template);
         node->metadata = metadata;
         node->signature = signature;
+        node->compiled_signature = compiled_signature;
         node->permissions = permissions;
         return node;
     } else if (type_str == "tool_call") {
@@ -293,8 +432,12 @@ std::unique_ptr<Node> MarkdownParser::create_node_from_json(const NodePath& path
             }
         }
         auto node = std::make_unique<ToolCallNode>(path, std::move(tool), std::move(args), std::move(output_keys), std::move(next_paths));
+        for (const auto& [key, tmpl] : node->arguments) {
+            node->compiled_arguments[key] = precompile_template(tmpl);
+        }
         node->metadata = metadata;
         node->signature = signature;
+        node->compiled_signature = compiled_signature;
         node->permissions = permissions;
         return node;
     } else if (type_str == "resource") {
@@ -304,6 +447,7 @@ std::unique_ptr<Node> MarkdownParser::create_node_from_json(const NodePath& path
         std::string scope = node_json.value("scope", std::string("global"));
         auto node = std::make_unique<ResourceNode>(path, rtype, std::move(uri), std::move(scope), metadata);
         node->signature = signature;
+        node->compiled_signature = compiled_signature;
         node->permissions = permissions;
         return node;
     } else if (type_str == "fork") {
@@ -321,6 +465,7 @@ std::unique_ptr<Node> MarkdownParser::create_node_from_json(const NodePath& path
         auto node = std::make_unique<ForkNode>(path, std::move(branches), std::move(next_paths));
         node->metadata = metadata;
         node->signature = signature;
+        node->compiled_signature = compiled_signature;
         node->permissions = permissions;
         return node;
     } else if (type_str == "join") {
@@ -345,6 +490,7 @@ std::unique_ptr<Node> MarkdownParser::create_node_from_json(const NodePath& path
         auto node = std::make_unique<JoinNode>(path, std::move(deps), std::move(strategy), std::move(next_paths));
         node->metadata = metadata;
         node->signature = signature;
+        node->compiled_signature = compiled_signature;
         node->permissions = permissions;
         return node;
     } else if (type_str == "generate_subgraph") {
@@ -358,8 +504,12 @@ std::unique_ptr<Node> MarkdownParser::create_node_from_json(const NodePath& path
         auto node = std::make_unique<GenerateSubgraphNode>(path, std::move(prompt), std::move(output_keys), std::move(next_paths));
         node->signature_validation = sig_validation;
         node->on_signature_violation = on_violation;
+        node->max_subgraphs = node_json.value("max_subgraphs", size_t{0});
+        node->constrain_output = node_json.value("constrain_output", true);
+        node->llm_tool_name = node_json.value("llm_tool_name", std::string());
         node->metadata = metadata;
         node->signature = signature;
+        node->compiled_signature = compiled_signature;
         node->permissions = permissions;
         return node;
     } else if (type_str == "assert") {
@@ -369,8 +519,10 @@ std::unique_ptr<Node> MarkdownParser::create_node_from_json(const NodePath& path
             on_failure = node_json["on_failure"].get<std::string>();
         }
         auto node = std::make_unique<AssertNode>(path, std::move(condition), std::move(on_failure), std::move(next_paths));
+        node->compiled_condition = precompile_template(node->condition);
         node->metadata = metadata;
         node->signature = signature;
+        node->compiled_signature = compiled_signature;
         node->permissions = permissions;
         return node;
     }
@@ -385,27 +537,4 @@ void MarkdownParser::validate_nodes(const std::vector<std::unique_ptr<Node>>& no
     // For v1, rely on executor-level validation
 }
 
-// v3.1: Helper to parse signature.outputs into JSON Schema
-std::optional<nlohmann::json> MarkdownParser::parse_output_schema_from_signature(const std::string& signature_str) {
-    // This is a simplified example. A full implementation would require a proper parser
-    // for the signature format defined in the spec (e.g., "(input: string) -> {result: number}")
-    // For now, we'll look for a pattern like " -> { ... }" and assume it's valid JSON schema.
-    std::regex output_pattern(R"(\s*->\s*(\{.*\}))");
-    std::smatch match;
-    if (std::regex_search(signature_str, match, output_pattern)) {
-        try {
-            std::string schema_str = match[1].str();
-            nlohmann::json schema = nlohmann::json::parse(schema_str);
-            return schema;
-        } catch (const std::exception& e) {
-            // If parsing the output part fails, log a warning but don't fail the whole parse
-            std::cerr << "[WARNING] Could not parse output schema from signature '" << signature_str << "': " << e.what() << std::endl;
-            // Return empty object or null if parsing fails
-            return nlohmann::json::object();
-        }
-    }
-    // If no output part is found, return nullopt
-    return std::nullopt;
-}
-
 } // namespace agenticdsl
@@ -5,6 +5,7 @@
 #include "core/types/node.h" // 引入 Node, NodePath, ParsedGraph
 #include "core/types/budget.h" // 引入 ExecutionBudget
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <nlohmann/json.hpp>
@@ -14,15 +15,45 @@ namespace agenticdsl {
 
 class MarkdownParser {
 public:
+    MarkdownParser() = default;
+    // parse_threads: 并行解析块的线程数；1 = 串行（默认），0 = hardware_concurrency
+    explicit MarkdownParser(size_t parse_threads) : parse_threads_(parse_threads) {}
+
+    void set_parse_threads(size_t parse_threads) { parse_threads_ = parse_threads; }
+
     std::vector<ParsedGraph> parse_from_string(const std::string& markdown_content);
     std::vector<ParsedGraph> parse_from_file(const std::string& file_path);
 
+    // 块的中间表示：路径 + 由 YAML 事件直接构建的 JSON 文档（不经过 YAML::Node 树，见 parse_yaml_to_json）。
+    // 节点仍从该文档构建而不是直接从事件构建：文档是 GraphCache 的存储单元，命中时整个 YAML 阶段被跳过；
+    // 未命中时耗时主要在 yaml-cpp 的扫描，文档到节点的转换只占一小部分
+    struct BlockDocument {
+        NodePath path;
+        nlohmann::json doc;
+    };
+    // 两阶段解析：parse_from_string == build_graphs(load_documents(...))
+    std::vector<BlockDocument> load_documents(const std::string& markdown_content);
+    std::vector<ParsedGraph> build_graphs(const std::vector<BlockDocument>& documents);
+    // 校验路径并将单个块的 YAML 转为 JSON 文档（增量解析时逐块调用）
+    BlockDocument load_block(std::string_view path, std::string_view content);
+
     std::unique_ptr<Node> create_node_from_json(const NodePath& path, const nlohmann::json& node_json);
 
 private:
+    // 单个块的解析结果：普通块产出图，/__meta__ 产出预算
+    struct BlockResult {
+        std::optional<ParsedGraph> graph;
+        std::optional<ExecutionBudget> budget;
+    };
+    BlockResult build_block(const BlockDocument& block);
+    static std::vector<ParsedGraph> assemble(std::vector<BlockResult> results);
+    size_t worker_count(size_t items) const;
+
+    // 每个线程至少分到的块数，块太少时并行的线程开销得不偿失
+    static constexpr size_t kMinBlocksPerThread = 4;
+    size_t parse_threads_ = 1;
+
     void validate_nodes(const std::vector<std::unique_ptr<Node>>& nodes);
-    // Helper to parse signature.outputs into JSON Schema
-    std::optional<nlohmann::json> parse_output_schema_from_signature(const std::string& signature_str);
 };
 
 } // namespace agenticdsl
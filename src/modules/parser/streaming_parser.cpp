@@ -0,0 +1,47 @@
+// modules/parser/src/streaming_parser.cpp
+#include "parser/streaming_parser.h"
+#include "common/utils/parser_utils.h"
+#include <stdexcept>
+
+namespace agenticdsl {
+
+StreamingDSLParser::StreamingDSLParser(MarkdownParser& parser, GraphsCallback on_graphs)
+    : parser_(parser), on_graphs_(std::move(on_graphs)) {}
+
+void StreamingDSLParser::feed(std::string_view chunk) {
+    if (finished_) {
+        throw std::logic_error("StreamingDSLParser::feed called after finish");
+    }
+    buffer_.append(chunk);
+    // 块只会在 closing ``` 到达时闭合，其余 token 无需重新扫描
+    if (chunk.find('`') != std::string_view::npos) {
+        emit_closed_blocks();
+    }
+}
+
+void StreamingDSLParser::finish() {
+    if (finished_) return;
+    emit_closed_blocks();
+    finished_ = true;
+}
+
+void StreamingDSLParser::emit_closed_blocks() {
+    std::string_view pending = std::string_view(buffer_).substr(consumed_);
+    auto blocks = scan_pathed_blocks(pending);
+    if (blocks.empty()) return;
+
+    std::vector<MarkdownParser::BlockDocument> documents;
+    documents.reserve(blocks.size());
+    for (const auto& block : blocks) {
+        documents.push_back(parser_.load_block(block.path, block.content));
+    }
+    consumed_ += blocks.back().end_offset;
+    blocks_emitted_ += blocks.size();
+
+    auto graphs = parser_.build_graphs(documents);
+    if (!graphs.empty() && on_graphs_) {
+        on_graphs_(std::move(graphs));
+    }
+}
+
+} // namespace agenticdsl
@@ -0,0 +1,42 @@
+// modules/parser/include/parser/streaming_parser.h
+#ifndef AGENTICDSL_MODULES_PARSER_STREAMING_PARSER_H
+#define AGENTICDSL_MODULES_PARSER_STREAMING_PARSER_H
+
+#include "markdown_parser.h"
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace agenticdsl {
+
+// 增量 DSL 解析器：按 token 追加 LLM 输出，每当一个块的 closing ``` 到达就立即解析并回调，
+// 无需等待整段生成结束。对同一段文本，产出的块与 MarkdownParser::parse_from_string 一致。
+class StreamingDSLParser {
+public:
+    using GraphsCallback = std::function<void(std::vector<ParsedGraph>)>;
+
+    StreamingDSLParser(MarkdownParser& parser, GraphsCallback on_graphs);
+
+    // 追加一段文本；解析错误或回调中的异常直接抛出
+    void feed(std::string_view chunk);
+    // 输入结束：未闭合的尾部块被忽略
+    void finish();
+
+    const std::string& text() const { return buffer_; }
+    size_t blocks_emitted() const { return blocks_emitted_; }
+
+private:
+    void emit_closed_blocks();
+
+    MarkdownParser& parser_;
+    GraphsCallback on_graphs_;
+    std::string buffer_;
+    size_t consumed_ = 0; // 已回调的块在 buffer_ 中的结束偏移
+    size_t blocks_emitted_ = 0;
+    bool finished_ = false;
+};
+
+} // namespace agenticdsl
+
+#endif // AGENTICDSL_MODULES_PARSER_STREAMING_PARSER_H
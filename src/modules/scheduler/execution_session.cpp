@@ -1,9 +1,11 @@
 // modules/scheduler/src/execution_session.cpp
 #include "scheduler/execution_session.h"
+#include "modules/optimizer/dependency_analysis.h" // 引入 template_reads
 #include "common/utils/template_renderer.h" // 引入 InjaTemplateRenderer (for Trace context delta)
 //#include "agenticdsl/llm/prompt_builder.h" // 引入 PromptBuilder
 #include <stdexcept>
 #include <algorithm> // For std::find
+#include <iostream>
 
 namespace agenticdsl {
 
@@ -13,67 +15,77 @@ ExecutionSession::ExecutionSession(
     LlamaAdapter* llm_adapter,
     ResourceManager& resource_manager, // ← 新增
     const std::vector<ParsedGraph>* full_graphs,
+    LibrarySnapshotPtr library_snapshot,
     AppendGraphsCallback append_graphs_callback)
     : budget_controller_(std::move(initial_budget)),
       node_executor_(tool_registry, llm_adapter),
       resource_manager_(resource_manager), // ← 初始化
       full_graphs_(full_graphs),
+      library_snapshot_(library_snapshot ? std::move(library_snapshot) : StandardLibraryLoader::instance().snapshot()),
       append_graphs_callback_(std::move(append_graphs_callback)) { // Store callback
 
     node_executor_.set_append_graphs_callback(append_graphs_callback_);
-    if (initial_budget.has_value()) {
-        size_t max_snapshots = (initial_budget->max_snapshots >= 0) 
-            ? static_cast<size_t>(initial_budget->max_snapshots) : 10;
-        context_engine_.set_snapshot_limits(max_snapshots, initial_budget->snapshot_max_size_kb);
+    // initial_budget 已移动到 budget_controller_，从那里读取配置
+    const auto& budget = budget_controller_.get_budget();
+    if (budget.has_value()) {
+        size_t max_snapshots = (budget->max_snapshots >= 0) 
+            ? static_cast<size_t>(budget->max_snapshots) : 10;
+        context_engine_.set_snapshot_limits(max_snapshots, budget->snapshot_max_size_kb);
+        auto format = parse_snapshot_format(budget->snapshot_format);
+        if (!format.has_value()) {
+            std::cerr << "[WARNING] Unknown snapshot_format '" << budget->snapshot_format << "', using cbor" << std::endl;
+        }
+        context_engine_.set_snapshot_encoding(format.value_or(SnapshotFormat::CBOR), budget->snapshot_compression);
     } else {
         context_engine_.set_snapshot_limits(10, 512); // dev default
     }
 }
-nlohmann::json ExecutionSession::build_available_subgraphs_context() const {
-    nlohmann::json libs = nlohmann::json::array();
-    
-    // 1. 静态标准库（/lib/**）
-    auto& loader = StandardLibraryLoader::instance();
-    for (const auto& entry : loader.get_available_libraries()) {
-        if (entry.is_subgraph) {
-            nlohmann::json lib;
-            lib["path"] = entry.path;
-            if (entry.output_schema && !entry.output_schema->is_null()) {
-                lib["signature"] = {
-                    {"outputs", entry.output_schema}
-                };
-            }
-            lib["permissions"] = entry.permissions;
-            lib["stability"] = "stable";
-            libs.push_back(std::move(lib));
-        }
+nlohmann::json ExecutionSession::build_available_subgraphs_context(std::string_view query, size_t top_k) const {
+    // 静态标准库（/lib/**，取会话快照）+ 动态生成子图（/dynamic/**）
+    std::lock_guard<std::mutex> lock(catalog_mutex_);
+    subgraph_catalog_.refresh(library_snapshot_, full_graphs_);
+    return top_k == 0 ? subgraph_catalog_.all() : subgraph_catalog_.top_k(query, top_k);
+}
+
+std::string ExecutionSession::inject_subgraphs_into_prompt(
+    const GenerateSubgraphNode& node,
+    Context& context) const {
+    auto reads = template_reads(node.prompt_template);
+    if (reads && reads->count("available_subgraphs") == 0) {
+        return InjaTemplateRenderer::render(node.prompt_template, context); // 模板不引用目录，无需构建
     }
-    
-    // 2. 动态生成子图（/dynamic/**）
-    if (full_graphs_) {
-        for (const auto& graph : *full_graphs_) {
-            if (graph.path.rfind("/dynamic/", 0) == 0 && !graph.output_schema->is_null()) {
-                nlohmann::json lib;
-                lib["path"] = graph.path;
-                lib["signature"] = {
-                    {"outputs", graph.output_schema}
-                };
-                lib["permissions"] = graph.permissions;
-                lib["stability"] = "dynamic";
-                libs.push_back(std::move(lib));
+
+    // 检索查询：提示模板本身加上它引用的顶层字符串变量（通常是任务描述）
+    std::string query;
+    if (node.max_subgraphs > 0) {
+        query = node.prompt_template;
+        for (const auto& key : reads.value_or(std::unordered_set<std::string>{})) {
+            auto it = context.find(key);
+            if (it != context.end() && it->is_string()) {
+                query += ' ';
+                query += it->get_ref<const std::string&>();
             }
         }
     }
-    
-    return libs;
-}
 
-std::string ExecutionSession::inject_subgraphs_into_prompt(
-    const std::string& base_prompt,
-    const Context& context) const {
-    Context ctx = context;
-    ctx["available_subgraphs"] = build_available_subgraphs_context();
-    return InjaTemplateRenderer::render(base_prompt, ctx);
+    std::optional<Value> previous;
+    if (auto it = context.find("available_subgraphs"); it != context.end()) previous = std::move(*it);
+    context["available_subgraphs"] = build_available_subgraphs_context(query, node.max_subgraphs);
+    auto restore = [&] {
+        if (previous) {
+            context["available_subgraphs"] = std::move(*previous);
+        } else {
+            context.erase("available_subgraphs");
+        }
+    };
+    try {
+        std::string rendered = InjaTemplateRenderer::render(node.prompt_template, context);
+        restore();
+        return rendered;
+    } catch (...) {
+        restore();
+        throw;
+    }
 }
 
 
@@ -118,7 +130,10 @@ ExecutionSession::ExecutionResult ExecutionSession::execute_node(Node* node, con
 
     // 2. 记录 Trace 开始
     nlohmann::json initial_ctx_json = context_with_resources;
-    trace_exporter_.on_node_start(node->path, node->type, initial_ctx_json, budget_controller_.get_budget());
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex_);
+        trace_exporter_.on_node_start(node->path, node->type, initial_ctx_json, budget_controller_.get_budget());
+    }
 
     // 3. 执行节点
     try {
@@ -128,9 +143,8 @@ ExecutionSession::ExecutionResult ExecutionSession::execute_node(Node* node, con
                 // 对于 GENERATE_SUBGRAPH，注入 available_subgraphs
                 if (node->type == NodeType::GENERATE_SUBGRAPH) {
                     const GenerateSubgraphNode* gsn = static_cast<const GenerateSubgraphNode*>(node);
-                    std::string rendered_prompt = this->inject_subgraphs_into_prompt(gsn->prompt_template, ctx);
                     Context new_ctx = ctx;
-                    new_ctx["__rendered_prompt__"] = rendered_prompt; // 临时存储
+                    new_ctx["__rendered_prompt__"] = this->inject_subgraphs_into_prompt(*gsn, new_ctx); // 临时存储
                     return node_executor_.execute_node(node, new_ctx);
                 }
                 return node_executor_.execute_node(node, ctx);
@@ -166,6 +180,7 @@ ExecutionSession::ExecutionResult ExecutionSession::execute_node(Node* node, con
 
     // 4. 记录 Trace 结束
     nlohmann::json final_ctx_json = result.new_context;
+    std::lock_guard<std::mutex> lock(trace_mutex_);
     trace_exporter_.on_node_end(
         node->path,
         result.success ? "success" : "failed",
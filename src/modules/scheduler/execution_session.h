@@ -13,11 +13,14 @@
 #include "common/llm/llama_adapter.h"
 #include "modules/parser/markdown_parser.h" // 引入 MarkdownParser (for GenerateSubgraph)
 #include "modules/library/library_loader.h" // ← 新增：用于构建 available_subgraphs
+#include "modules/library/subgraph_catalog.h"
 #include "resource_manager.h" // ← 新增：用于构建 available_subgraphs
 #include <optional>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <functional> // For std::function (callback)
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -37,6 +40,7 @@ public:
         LlamaAdapter* llm_adapter,
         ResourceManager& resource_manager, // ← 新增参数
         const std::vector<ParsedGraph>* full_graphs, // ← 新增：指向完整图集
+        LibrarySnapshotPtr library_snapshot, // 本次运行使用的标准库版本；为空时取当前快照
         AppendGraphsCallback append_graphs_callback = nullptr // New parameter
     );
 
@@ -71,16 +75,22 @@ private:
     ContextEngine context_engine_;
     BudgetController budget_controller_;
     TraceExporter trace_exporter_;
+    std::mutex trace_mutex_; // TopoScheduler 并发执行工具节点时保护 trace_exporter_
     NodeExecutor node_executor_;
     const std::vector<ParsedGraph>* full_graphs_; // ← 指向完整图集
+    LibrarySnapshotPtr library_snapshot_; // 会话开始时的标准库版本，热更新不影响进行中的运行
+    mutable SubgraphCatalog subgraph_catalog_; // available_subgraphs 缓存，图集增长时重建
+    mutable std::mutex catalog_mutex_;
     std::vector<NodePath> call_stack_; // 用于 soft end
     std::unordered_map<NodePath, std::vector<NodePath>> pending_dynamic_deps_; // NodePath -> [list of unresolved deps]
     std::unordered_map<NodePath, nlohmann::json> dynamic_wait_for_expressions_; // NodePath -> original wait_for expression
     AppendGraphsCallback append_graphs_callback_; // Callback for dynamic graphs
 
     //Context execute_generate_subgraph_with_callback(const GenerateSubgraphNode* node, const Context& ctx);
-    nlohmann::json build_available_subgraphs_context() const;
-    std::string inject_subgraphs_into_prompt(const std::string& base_prompt, const Context& context) const;
+    // top_k == 0 时返回完整目录，否则按与 query 的相关度取前 top_k 项
+    nlohmann::json build_available_subgraphs_context(std::string_view query = {}, size_t top_k = 0) const;
+    // 临时把 available_subgraphs 放入 context 渲染提示词，返回前恢复 context
+    std::string inject_subgraphs_into_prompt(const GenerateSubgraphNode& node, Context& context) const;
 
     // Helper to determine if snapshot is needed for a node type
     bool needs_snapshot(Node* node) const;
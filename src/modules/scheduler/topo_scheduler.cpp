@@ -1,8 +1,10 @@
 // modules/scheduler/src/topo_scheduler.cpp
 #include "scheduler/topo_scheduler.h"
 #include "common/utils/template_renderer.h"
+#include "modules/optimizer/graph_optimizer.h"
 #include <stdexcept>
 #include <algorithm>
+#include <future>
 #include <set>
 #include <queue>
 
@@ -14,13 +16,40 @@ struct HardEndException : public std::exception {
     }
 };
 
+// 解析期即确定的 wait_for 依赖（all_of / any_of / 数组 / 对象中的字符串）；
+// 顶层为字符串的是运行期渲染的动态表达式，由 execute 处理，此处返回 std::nullopt
+static std::optional<std::vector<NodePath>> static_wait_for(const Node& node) {
+    auto it = node.metadata.find("wait_for");
+    if (it == node.metadata.end() || it->is_string()) return std::nullopt;
+    const auto& wf = *it;
+    std::vector<NodePath> deps;
+    auto collect = [&deps](const nlohmann::json& value) {
+        if (value.is_array()) {
+            for (const auto& item : value) deps.push_back(item.get<std::string>());
+        } else if (value.is_string()) {
+            deps.push_back(value.get<std::string>());
+        }
+    };
+    if (wf.is_object()) {
+        if (wf.contains("all_of")) collect(wf["all_of"]);
+        // Note: 'any_of' requires more complex scheduling logic (e.g., event-based)
+        // For simplicity in a basic topo scheduler, we treat 'any_of' as 'all_of'.
+        if (wf.contains("any_of")) collect(wf["any_of"]);
+    } else {
+        collect(wf);
+    }
+    return deps;
+}
+
 TopoScheduler::TopoScheduler(Config config, ToolRegistry& tool_registry, LlamaAdapter* llm_adapter, const std::vector<ParsedGraph>* full_graphs)
     : full_graphs_(full_graphs),
       resource_manager_(),
       session_(std::move(config.initial_budget), tool_registry, llm_adapter, resource_manager_, 
-               full_graphs_,
+               full_graphs_, std::move(config.library),
                [this](std::vector<ParsedGraph> graphs) { this->append_dynamic_graphs(std::move(graphs)); }) { // Pass callback to ExecutionSession
     // Initial budget is now handled by ExecutionSession
+    max_parallel_nodes_ = std::max<size_t>(1, config.max_parallel_nodes);
+    session_.node_executor_.set_llm_stream_callback(std::move(config.llm_stream));
 }
 
 void TopoScheduler::register_node(std::unique_ptr<Node> node) {
@@ -31,20 +60,23 @@ void TopoScheduler::register_node(std::unique_ptr<Node> node) {
 
 void TopoScheduler::register_resources() {
     for (const auto& node_ptr : all_nodes_) {
-        if (node_ptr->type == NodeType::RESOURCE) {
-            const ResourceNode* res_node = static_cast<const ResourceNode*>(node_ptr.get());
-            Resource res{
-                .path = res_node->path,
-                .resource_type = res_node->resource_type,
-                .uri = res_node->uri,
-                .scope = res_node->scope,
-                .metadata = res_node->metadata
-            };
-            resource_manager_.register_resource(res);
-        }
+        register_resource(*node_ptr);
     }
 }
 
+void TopoScheduler::register_resource(const Node& node) {
+    if (node.type != NodeType::RESOURCE) return;
+    const ResourceNode* res_node = static_cast<const ResourceNode*>(&node);
+    Resource res{
+        .path = res_node->path,
+        .resource_type = res_node->resource_type,
+        .uri = res_node->uri,
+        .scope = res_node->scope,
+        .metadata = res_node->metadata
+    };
+    resource_manager_.register_resource(res);
+}
+
 void TopoScheduler::build_dag() {
     register_resources();
 
@@ -76,39 +108,8 @@ void TopoScheduler::build_dag() {
 
         // Handle 'wait_for' dependencies (static dependencies defined at parse time)
         // This covers all_of, any_of, static arrays/strings
-        if (node->metadata.contains("wait_for") && !node->metadata["wait_for"].is_string()) { // Only process if NOT a dynamic string
-            const auto& wf = node->metadata["wait_for"];
-            std::vector<NodePath> deps;
-
-            // Parse wait_for structure
-            if (wf.is_object()) {
-                if (wf.contains("all_of")) {
-                    const auto& all = wf["all_of"];
-                    if (all.is_array()) {
-                        for (const auto& item : all) deps.push_back(item.get<std::string>());
-                    } else if (all.is_string()) {
-                        deps.push_back(all.get<std::string>());
-                    }
-                }
-                if (wf.contains("any_of")) {
-                // Note: 'any_of' requires more complex scheduling logic (e.g., event-based)
-                // For simplicity in a basic topo scheduler, we treat 'any_of' as 'all_of'
-                // or handle it differently in execute_node. Here, we treat as all_of.
-                // A full implementation would require a different scheduling model.
-                    const auto& any = wf["any_of"];
-                    if (any.is_array()) {
-                        for (const auto& item : any) deps.push_back(item.get<std::string>());
-                    } else if (any.is_string()) {
-                        deps.push_back(any.get<std::string>());
-                    }
-                }
-            } else if (wf.is_array()) {
-                for (const auto& item : wf) deps.push_back(item.get<std::string>());
-            } else if (wf.is_string()) {
-                deps.push_back(wf.get<std::string>());
-            }
-
-            for (const auto& dep_path : deps) {
+        if (auto deps = static_wait_for(*node)) {
+            for (const auto& dep_path : *deps) {
                 if (node_map_.count(dep_path) == 0) {
                     throw std::runtime_error("wait_for dependency not found: " + dep_path);
                 }
@@ -141,21 +142,15 @@ void TopoScheduler::build_dag() {
 ExecutionResult TopoScheduler::execute(Context initial_context) {
     Context context = std::move(initial_context);
 
+    // 任何提前返回都先等后台生成结束，生成线程不会比本次执行活得更久
+    struct GenerationGuard {
+        TopoScheduler& scheduler;
+        ~GenerationGuard() { scheduler.abandon_generation(); }
+    } generation_guard{*this};
+
     std::optional<NodePath> entry_point;
     if (full_graphs_) {
-        for (const auto& graph : *full_graphs_) {
-            // Check /__meta__ for entry_point
-            if (graph.path == "/__meta__" && graph.metadata.contains("entry_point")) {
-                entry_point = graph.metadata["entry_point"].get<std::string>();
-                break;
-            }
-            // Also check /main for entry (v3.x format)
-            if (graph.path == "/main" && graph.metadata.contains("entry")) {
-                // entry is node ID, need to prepend graph path
-                entry_point = graph.path + "/" + graph.metadata["entry"].get<std::string>();
-                break;
-            }
-        }
+        entry_point = GraphOptimizer::find_entry_point(*full_graphs_);
     }
 
     if (entry_point.has_value()) {
@@ -168,11 +163,21 @@ ExecutionResult TopoScheduler::execute(Context initial_context) {
         ready_queue_.push(entry_point.value());
     }
 
-    while (!ready_queue_.empty() || !session_.get_pending_dynamic_deps().empty() || is_executing_fork_branches_) { // Continue while queue has items OR fork branches are running
+    while (!ready_queue_.empty() || !session_.get_pending_dynamic_deps().empty() || is_executing_fork_branches_ || generation_) { // Continue while queue has items OR fork branches are running
         NodePath current_path;
         Node* current_node = nullptr;
         bool found_ready_node = false;
 
+        // 后台生成进行中：并入已闭合的块；没有可执行的节点时等待下一个块或生成结束
+        if (generation_) {
+            if (auto error = advance_generation(context, ready_queue_.empty())) {
+                return {false, *error, context, std::nullopt};
+            }
+            if (ready_queue_.empty()) {
+                continue;
+            }
+        }
+
         if (is_executing_fork_branches_) {
              // If we are in the middle of executing fork branches, do that first.
              // This happens after a ForkNode sets the flag but before a JoinNode is encountered.
@@ -283,6 +288,32 @@ ExecutionResult TopoScheduler::execute(Context initial_context) {
             continue;
         }
 
+        // 需要快照、会暂停或结束流程的节点不与后台生成重叠，先等生成收尾
+        if (generation_ && !can_overlap_generation(current_node)) {
+            if (auto error = finish_generation(context)) {
+                return {false, *error, context, std::nullopt};
+            }
+        }
+
+        // generate_subgraph 在后台生成，调度线程继续执行已就绪的节点和陆续生成的节点
+        if (current_node->type == NodeType::GENERATE_SUBGRAPH && !is_executing_fork_branches_) {
+            start_generation(current_node, context);
+            if (max_parallel_nodes_ <= 1) {
+                if (auto error = finish_generation(context)) {
+                    return {false, *error, context, std::nullopt};
+                }
+            }
+            continue;
+        }
+
+        // 与其他就绪的工具 / LLM 调用节点互不读写对方的键时一起并发执行（见 GraphOptimizer 的 next 边放松）
+        if (auto wave = collect_parallel_wave(current_node); wave.size() > 1) {
+            if (auto stop = execute_parallel_wave(wave, context)) {
+                return std::move(*stop);
+            }
+            continue;
+        }
+
         // --- Execute Node via ExecutionSession ---
         // Check node type here
         //if (current_node->type == NodeType::FORK || current_node->type == NodeType::GENERATE_SUBGRAPH) {
@@ -292,6 +323,8 @@ ExecutionResult TopoScheduler::execute(Context initial_context) {
         auto session_result = session_.execute_node(current_node, context);
 
         if (!session_result.success) {
+            discard_dynamic_graphs(); // 失败节点已暂存的动态图不并入
+
              if (session_result.message.find("Jumping to:") != std::string::npos) {
                 // Extract jump target (simplified)
                 size_t pos = session_result.message.find("Jumping to:");
@@ -360,47 +393,9 @@ ExecutionResult TopoScheduler::execute(Context initial_context) {
             // Soft end: continue scheduling, but might pop call_stack_ in a more complex impl
         }
 
-        if (!dynamic_graphs_.empty()) {
-             // Load new graphs into the scheduler's data structures
-             //load_graphs(std::vector<ParsedGraph>()); // This is a hack to clear and reload. Better: add nodes incrementally.
-             // A better way: have append_dynamic_graphs call register_node and update in_degree_ directly.
-             // For now, let's just add nodes and rebuild the relevant parts.
-             // Let's assume load_graphs can handle appending new nodes correctly.
-             // We need to call build_dag again to incorporate new nodes and dependencies.
-             // This is expensive. A better approach is incremental DAG update.
-             // For this example, we'll rebuild. In practice, incremental updates are preferred.
-             // Let's clear the current structures and reload everything (including dynamic ones).
-             // This is inefficient but demonstrates the concept.
-             std::vector<std::unique_ptr<Node>> all_nodes_copy; // Create a new list to avoid modifying while iterating
-             for (auto& n : all_nodes_) {
-                 all_nodes_copy.push_back(n->clone()); // Clone existing nodes
-             }
-             // Register dynamic nodes
-             for (const auto& graph : dynamic_graphs_) {
-                 for (const auto& node_ptr : graph.nodes) {
-                     if (node_ptr) {
-                         all_nodes_copy.push_back(node_ptr->clone());
-                     }
-                 }
-             }
-             // Clear old structures
-             node_map_.clear();
-             reverse_edges_.clear();
-             in_degree_.clear();
-             // Rebuild DAG with all nodes (existing + dynamic)
-             all_nodes_ = std::move(all_nodes_copy);
-             build_dag(); // This will recreate ready_queue_ with new nodes if their deps are met
-             dynamic_graphs_.clear(); // Clear the list after processing
-             // Re-check the current node's dependencies after rebuild
-             // If current node's deps are now satisfied, it might be added back to ready_queue_ by build_dag
-             // If not, it will be skipped in this loop iteration.
-             // We need to ensure the main loop continues correctly.
-             // This approach is disruptive. A better scheduler would handle this more gracefully.
-             // Let's just continue the loop. The current node might be re-queued by build_dag if its deps are now ready.
-             // Or, we can restart the main loop logic from the beginning.
-             // For simplicity in this example, let's just continue the loop.
-             // The ready_queue_ might now contain nodes that were previously unready.
-             // This is the most straightforward way to handle the rebuild.
+        // 暂存的动态图（若有）此时并入 DAG；后台生成未结束时引用未解析的块继续等待
+        if (auto error = commit_dynamic_graphs(!generation_)) {
+            return {false, *error, context, std::nullopt};
         }
 
         // Update successors' in-degrees and add to ready queue if ready
@@ -421,16 +416,13 @@ ExecutionResult TopoScheduler::execute(Context initial_context) {
     }
 
     // Final check for unexecuted nodes (exclude system nodes)
-    std::unordered_set<NodePath> all_node_paths;
+    // executed_ 是无序集合，不能用 std::set_difference
+    std::set<NodePath> unexecuted;
     for (const auto& n : all_nodes_) {
         // Skip system nodes from unexecuted check
         if (n->path.rfind("/__system__/", 0) == 0) continue;
-        all_node_paths.insert(n->path);
+        if (executed_.count(n->path) == 0) unexecuted.insert(n->path);
     }
-    std::set<NodePath> unexecuted;
-    std::set_difference(all_node_paths.begin(), all_node_paths.end(),
-                        executed_.begin(), executed_.end(),
-                        std::inserter(unexecuted, unexecuted.begin()));
 
     if (!unexecuted.empty()) {
         return {false, "Execution stopped: Unmet dependencies or cycles. Unexecuted nodes: " + nlohmann::json(unexecuted).dump(), context, std::nullopt};
@@ -440,10 +432,308 @@ ExecutionResult TopoScheduler::execute(Context initial_context) {
 }
 
 void TopoScheduler::append_dynamic_graphs(std::vector<ParsedGraph> new_graphs) {
-    // Store the new graphs temporarily
-    // In a more complex system, this might trigger an event or flag for the main loop
-    dynamic_graphs_.insert(dynamic_graphs_.end(), std::make_move_iterator(new_graphs.begin()), std::make_move_iterator(new_graphs.end()));
-    // The main execute loop will check this list and rebuild the DAG if necessary.
+    // 在锁外完成克隆与读写集分析，生成线程只在追加时短暂持锁
+    std::vector<StagedNode> staged;
+    for (const auto& graph : new_graphs) {
+        for (const auto& node_ptr : graph.nodes) {
+            if (!node_ptr) continue;
+            auto node = node_ptr->clone();
+            AccessSet access = analyze_access(*node);
+            staged.push_back({std::move(node), std::move(access)});
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(staged_mutex_);
+        staged_nodes_.insert(staged_nodes_.end(), std::make_move_iterator(staged.begin()), std::make_move_iterator(staged.end()));
+    }
+    staged_cv_.notify_all();
+}
+
+std::optional<std::string> TopoScheduler::commit_dynamic_graphs(bool final) {
+    std::vector<StagedNode> staged;
+    {
+        std::lock_guard<std::mutex> lock(staged_mutex_);
+        staged.swap(staged_nodes_);
+    }
+    if (staged.empty() && (!final || unresolved_nodes_.empty())) return std::nullopt;
+
+    // 路径不得与已有节点或其他暂存节点重复，否则会覆盖 node_map_ 并重置入度
+    std::unordered_set<NodePath> pending;
+    for (const auto& s : unresolved_nodes_) pending.insert(s.node->path);
+    for (const auto& s : staged) {
+        const NodePath& path = s.node->path;
+        if (node_map_.count(path) > 0 || !pending.insert(path).second) {
+            return "Generated graph rejected: duplicate node path: " + path;
+        }
+    }
+    unresolved_nodes_.insert(unresolved_nodes_.end(), std::make_move_iterator(staged.begin()), std::make_move_iterator(staged.end()));
+
+    // next 与静态 wait_for 只能指向已有节点或同批节点；逐轮剔除引用了不可解析节点的暂存节点
+    std::unordered_set<NodePath> batch = pending;
+    auto missing_reference = [&](const Node& node, const std::unordered_set<NodePath>& known) -> std::optional<std::string> {
+        for (const auto& next_path : node.next) {
+            if (node_map_.count(next_path) == 0 && known.count(next_path) == 0) return "next node not found: " + next_path;
+        }
+        if (auto deps = static_wait_for(node)) {
+            for (const auto& dep_path : *deps) {
+                if (node_map_.count(dep_path) == 0 && known.count(dep_path) == 0) return "wait_for dependency not found: " + dep_path;
+            }
+        }
+        return std::nullopt;
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto& s : unresolved_nodes_) {
+            if (batch.count(s.node->path) > 0 && missing_reference(*s.node, batch)) {
+                batch.erase(s.node->path);
+                changed = true;
+            }
+        }
+    }
+    if (final && batch.size() < unresolved_nodes_.size()) {
+        for (const auto& s : unresolved_nodes_) {
+            if (auto missing = missing_reference(*s.node, pending)) return "Generated graph rejected: " + *missing;
+        }
+    }
+    if (batch.empty()) return std::nullopt;
+
+    std::vector<StagedNode> committing;
+    std::vector<StagedNode> waiting;
+    for (auto& s : unresolved_nodes_) {
+        (batch.count(s.node->path) > 0 ? committing : waiting).push_back(std::move(s));
+    }
+    unresolved_nodes_ = std::move(waiting);
+
+    // 增量注册：只为新节点建立边，已有节点的入度与已执行状态保持不变
+    for (auto& s : committing) {
+        const NodePath& path = s.node->path;
+        node_map_[path] = s.node.get();
+        in_degree_[path] = 0;
+        reverse_edges_[path] = {};
+        access_sets_[path] = std::move(s.access);
+        register_resource(*s.node);
+    }
+    for (const auto& s : committing) {
+        const NodePath& path = s.node->path;
+        for (const auto& next_path : s.node->next) {
+            // 指向更早并入、已经就绪或执行过的节点的边不再约束它
+            if (batch.count(next_path) == 0 && in_degree_[next_path] == 0) continue;
+            reverse_edges_[next_path].push_back(path);
+            in_degree_[next_path]++;
+        }
+        if (auto deps = static_wait_for(*s.node)) {
+            for (const auto& dep_path : *deps) {
+                if (executed_.count(dep_path) > 0) continue; // 已满足
+                reverse_edges_[path].push_back(dep_path);
+                in_degree_[path]++;
+            }
+        }
+    }
+    for (auto& s : committing) {
+        if (in_degree_[s.node->path] == 0) ready_queue_.push(s.node->path);
+        all_nodes_.push_back(std::move(s.node));
+    }
+    return std::nullopt;
+}
+
+void TopoScheduler::discard_dynamic_graphs() {
+    std::lock_guard<std::mutex> lock(staged_mutex_);
+    staged_nodes_.clear();
+    unresolved_nodes_.clear();
+}
+
+void TopoScheduler::start_generation(Node* node, const Context& context) {
+    {
+        std::lock_guard<std::mutex> lock(staged_mutex_);
+        generation_done_ = false;
+    }
+    generation_.emplace();
+    generation_->node = node;
+    generation_->input = context;
+    generation_->result = std::async(std::launch::async, [this, node, input = &generation_->input] {
+        auto mark_done = [this] {
+            {
+                std::lock_guard<std::mutex> lock(staged_mutex_);
+                generation_done_ = true;
+            }
+            staged_cv_.notify_all();
+        };
+        try {
+            auto result = session_.execute_node(node, *input);
+            mark_done();
+            return result;
+        } catch (...) {
+            mark_done();
+            throw;
+        }
+    });
+}
+
+std::optional<std::string> TopoScheduler::advance_generation(Context& context, bool wait) {
+    bool done = false;
+    {
+        std::unique_lock<std::mutex> lock(staged_mutex_);
+        if (wait) {
+            staged_cv_.wait(lock, [this] { return !staged_nodes_.empty() || generation_done_; });
+        }
+        done = generation_done_;
+    }
+    if (auto error = commit_dynamic_graphs(false)) {
+        return error;
+    }
+    return done ? finish_generation(context) : std::nullopt;
+}
+
+std::optional<std::string> TopoScheduler::finish_generation(Context& context) {
+    generation_->result.wait(); // 生成线程仍引用 input，等它结束后才能移走；其全部暂存此时都已完成
+    Generation generation = std::move(*generation_);
+    generation_.reset();
+    auto result = generation.result.get();
+
+    if (!result.success) {
+        discard_dynamic_graphs();
+        return result.message;
+    }
+    if (auto error = commit_dynamic_graphs()) {
+        return error;
+    }
+
+    // 只合并生成节点自己改动的键；生成期间被其他节点改写的键保留新值（那些节点逻辑上在它之后）
+    for (auto it = result.new_context.begin(); it != result.new_context.end(); ++it) {
+        auto before = generation.input.find(it.key());
+        bool before_exists = before != generation.input.end();
+        if (before_exists && *before == it.value()) continue;
+        auto current = context.find(it.key());
+        bool untouched = before_exists ? current != context.end() && *current == *before : current == context.end();
+        if (untouched) context[it.key()] = std::move(it.value());
+    }
+
+    const Node* node = generation.node;
+    executed_.insert(node->path);
+    for (const auto& next_path : node->next) {
+        if (--in_degree_[next_path] == 0) {
+            ready_queue_.push(next_path);
+        }
+    }
+    std::unordered_set<NodePath> newly_executed = {node->path};
+    session_.check_and_requeue_dynamic_deps(newly_executed);
+    return std::nullopt;
+}
+
+void TopoScheduler::abandon_generation() {
+    if (!generation_) return;
+    generation_->result.wait();
+    generation_.reset();
+    discard_dynamic_graphs();
+}
+
+bool TopoScheduler::can_overlap_generation(Node* node) const {
+    // ContextEngine 的快照不是线程安全的；fork/join、暂停与结束节点依赖完整的上下文
+    switch (node->type) {
+        case NodeType::FORK:
+        case NodeType::JOIN:
+        case NodeType::GENERATE_SUBGRAPH:
+        case NodeType::DSL_CALL:
+        case NodeType::END:
+            return false;
+        default:
+            return !session_.needs_snapshot(node);
+    }
+}
+
+const AccessSet& TopoScheduler::access_of(const Node* node) {
+    auto it = access_sets_.find(node->path);
+    if (it == access_sets_.end()) {
+        it = access_sets_.emplace(node->path, analyze_access(*node)).first;
+    }
+    return it->second;
+}
+
+bool TopoScheduler::can_run_in_parallel(Node* node) {
+    return is_parallelizable(*node) && !session_.needs_snapshot(node) && !access_of(node).opaque;
+}
+
+std::vector<Node*> TopoScheduler::collect_parallel_wave(Node* first) {
+    std::vector<Node*> wave = {first};
+    if (max_parallel_nodes_ <= 1 || is_executing_fork_branches_ || !can_run_in_parallel(first)) {
+        return wave;
+    }
+
+    // 按原顺序遍历就绪队列：选中的节点出队，其余保持相对顺序放回
+    std::queue<NodePath> remaining;
+    while (!ready_queue_.empty()) {
+        NodePath path = std::move(ready_queue_.front());
+        ready_queue_.pop();
+
+        auto it = node_map_.find(path);
+        Node* candidate = it != node_map_.end() ? it->second : nullptr;
+        bool selected = candidate && wave.size() < max_parallel_nodes_ && executed_.count(path) == 0 &&
+                        std::find(wave.begin(), wave.end(), candidate) == wave.end() &&
+                        can_run_in_parallel(candidate) &&
+                        std::none_of(wave.begin(), wave.end(), [&](const Node* member) {
+                            return access_of(member).conflicts_with(access_of(candidate));
+                        });
+        if (selected) {
+            wave.push_back(candidate);
+        } else {
+            remaining.push(std::move(path));
+        }
+    }
+    ready_queue_.swap(remaining);
+    return wave;
+}
+
+std::optional<ExecutionResult> TopoScheduler::execute_parallel_wave(const std::vector<Node*>& wave, Context& context) {
+    std::vector<std::future<ExecutionSession::ExecutionResult>> pending;
+    pending.reserve(wave.size());
+    for (Node* node : wave) {
+        pending.push_back(std::async(std::launch::async, [this, node, &context] {
+            return session_.execute_node(node, context);
+        }));
+    }
+    std::vector<ExecutionSession::ExecutionResult> results;
+    results.reserve(wave.size());
+    for (auto& future : pending) {
+        results.push_back(future.get());
+    }
+
+    // 各节点的 new_context 都是同一输入的副本，只取回各自写入的键；合并顺序与顺序执行一致。
+    // 失败的成员不影响其他成员：它们的工具已经执行过，写入照常合并，最后再报告第一个错误
+    std::optional<std::string> first_error;
+    std::optional<NodePath> paused_at;
+    for (size_t i = 0; i < wave.size(); ++i) {
+        Node* node = wave[i];
+        auto& result = results[i];
+        if (!result.success) {
+            if (!first_error) first_error = result.message;
+            continue;
+        }
+        for (const auto& key : access_of(node).writes) {
+            if (result.new_context.contains(key)) context[key] = std::move(result.new_context[key]);
+        }
+        if (result.new_context.contains("resources")) {
+            context["resources"] = std::move(result.new_context["resources"]);
+        }
+        if (!paused_at) paused_at = result.paused_at;
+
+        executed_.insert(node->path);
+        for (const auto& next_path : node->next) {
+            if (--in_degree_[next_path] == 0) {
+                ready_queue_.push(next_path);
+            }
+        }
+        std::unordered_set<NodePath> newly_executed = {node->path};
+        session_.check_and_requeue_dynamic_deps(newly_executed);
+    }
+
+    if (first_error) {
+        return ExecutionResult{false, *first_error, context, std::nullopt};
+    }
+    // 与顺序执行一样在 LLM 调用后暂停；同批的其他调用已经完成并合并
+    if (paused_at) {
+        return ExecutionResult{true, "Paused at LLM call", context, paused_at};
+    }
+    return std::nullopt;
 }
 
 void TopoScheduler::start_fork_simulation(const ForkNode* fork_node, const Context& fork_context_snapshot) {
@@ -460,7 +750,7 @@ void TopoScheduler::start_fork_simulation(const ForkNode* fork_node, const Conte
 void TopoScheduler::execute_fork_branches() {
     if (!is_executing_fork_branches_ || current_fork_branches_.empty()) return;
 
-    const Context* fork_snapshot = session_.get_context_engine().get_snapshot(current_fork_node_path_.value());
+    std::optional<Context> fork_snapshot = session_.get_context_engine().get_snapshot(current_fork_node_path_.value());
     if (!fork_snapshot) {
         throw std::runtime_error("Snapshot for fork node not found: " + current_fork_node_path_.value());
     }
@@ -664,10 +954,7 @@ void TopoScheduler::finish_join_simulation(Context& main_context) {
 void TopoScheduler::load_graphs(const std::vector<std::unique_ptr<Node>>& nodes) {
     // This method should register nodes and prepare for DAG building.
     // It's likely called during initial setup.
-    // For dynamic loading, we use append_dynamic_graphs and rebuild DAG.
-    // This method might need to be refactored or called differently for dynamic graphs.
-    // For the current example, it's implicitly handled by the execute loop when dynamic_graphs_ is not empty.
-    // If needed, add logic here to append nodes incrementally.
+    // Dynamic graphs go through append_dynamic_graphs / commit_dynamic_graphs instead.
     for (const auto& node_ptr : nodes) {
         register_node(node_ptr->clone()); // Use clone to avoid moving out of the vector if it's const
     }
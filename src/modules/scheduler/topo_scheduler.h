@@ -10,11 +10,15 @@
 #include "common/llm/llama_adapter.h" // 引入 LlamaAdapter
 #include "modules/parser/markdown_parser.h" // 引入 ParsedGraph
 #include "modules/scheduler/resource_manager.h" // 引入 ParsedGraph
+#include "modules/optimizer/dependency_analysis.h" // 引入 AccessSet
 #include <vector>
 #include <memory> // For unique_ptr<Node>
 #include <unordered_map>
 #include <unordered_set>
 #include <queue>
+#include <condition_variable>
+#include <future>
+#include <mutex>
 #include <optional>
 
 namespace agenticdsl {
@@ -23,6 +27,12 @@ class TopoScheduler {
 public:
     struct Config {
         std::optional<ExecutionBudget> initial_budget;
+        // 同时就绪、读写集互不相交的工具 / LLM 调用节点并发执行的上限；1 表示顺序执行
+        // （generate_subgraph 也不再与其生成节点的执行重叠）。
+        // 工具调用多在等待 I/O，上限不按 CPU 核数取
+        size_t max_parallel_nodes = 8;
+        LLMStreamCallback llm_stream; // LLM 节点的流式输出回调，可为空；并发执行时可能从多个线程调用
+        LibrarySnapshotPtr library;   // 本次运行使用的标准库快照；为空时取当前快照
         // Add other config options if needed
         Config() = default;
     };
@@ -33,7 +43,9 @@ public:
     void build_dag(); // 构建依赖图
     ExecutionResult execute(Context initial_context);
 
-    // Method for DSLEngine to call to add new graphs dynamically
+    // 暂存动态生成的图（克隆节点、预先计算读写集），可在推理线程上调用。
+    // generate_subgraph 在后台生成时，调度线程每收到一个块就并入 DAG 并执行其中就绪的节点，
+    // 与后续块的解码重叠；引用尚未生成的节点的块留待目标出现后再并入
     void append_dynamic_graphs(std::vector<ParsedGraph> new_graphs);
 
     std::vector<TraceRecord> get_last_traces() const {
@@ -51,11 +63,48 @@ private:
     std::queue<NodePath> ready_queue_;
     std::unordered_set<NodePath> executed_;
     std::vector<NodePath> call_stack_; // 用于 soft end
+    size_t max_parallel_nodes_ = 1;
+    std::unordered_map<NodePath, AccessSet> access_sets_; // 按需计算的节点读写集
     //
 
     void register_resources();
+    void register_resource(const Node& node);
 
-    std::vector<ParsedGraph> dynamic_graphs_; // Store newly generated graphs
+    // 并发执行：从就绪队列中取出与 first 互不冲突的工具 / LLM 调用节点，按队列顺序合并各自写入的键。
+    // 成员失败或暂停时返回 execute 应返回的结果（所有成功成员的写入都已合并）
+    const AccessSet& access_of(const Node* node);
+    bool can_run_in_parallel(Node* node);
+    std::vector<Node*> collect_parallel_wave(Node* first);
+    std::optional<ExecutionResult> execute_parallel_wave(const std::vector<Node*>& wave, Context& context);
+
+    // 暂存的动态节点，见 append_dynamic_graphs
+    struct StagedNode {
+        std::unique_ptr<Node> node;
+        AccessSet access;
+    };
+    std::mutex staged_mutex_;
+    std::condition_variable staged_cv_; // 有新暂存节点或后台生成结束
+    std::vector<StagedNode> staged_nodes_;
+    bool generation_done_ = false;      // 受 staged_mutex_ 保护
+    std::vector<StagedNode> unresolved_nodes_; // 已取出、引用尚不能解析的节点（仅调度线程访问）
+    // 增量并入暂存节点：路径冲突时整体拒绝；只注册引用全部可解析的节点，其余留到下次。
+    // final 时剩余节点必须全部可解析，否则一个也不注册。返回错误信息时不修改 DAG
+    std::optional<std::string> commit_dynamic_graphs(bool final = true);
+    void discard_dynamic_graphs();
+
+    // 在后台执行的 generate_subgraph（同一时刻至多一个）
+    struct Generation {
+        Node* node = nullptr;
+        Context input; // 开始时的上下文：结束时只合并该节点自己改动的键
+        std::future<ExecutionSession::ExecutionResult> result;
+    };
+    std::optional<Generation> generation_;
+    void start_generation(Node* node, const Context& context);
+    // 并入已生成的块；生成结束时收尾（合并输出、释放后继）。wait 为 true 时先等到有进展
+    std::optional<std::string> advance_generation(Context& context, bool wait);
+    std::optional<std::string> finish_generation(Context& context);
+    void abandon_generation(); // 提前返回时等待后台生成结束并丢弃其结果
+    bool can_overlap_generation(Node* node) const;
     //
     void load_graphs(const std::vector<std::unique_ptr<Node>>& nodes); // Helper for registration/building
     //
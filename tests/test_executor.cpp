@@ -4,9 +4,15 @@
 #include "common/tools/registry.h"
 #include "common/llm/llm_tool.h"
 #include "core/types/context.h"
+#include "common/utils/template_renderer.h"
+#include "common/utils/signature.h"
 
+#include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace agenticdsl;
 
@@ -191,6 +197,118 @@ TEST_CASE("AssignNode execution", "[executor]") {
     REQUIRE(result["greeting"] == "Hello World");
 }
 
+// Test 6b: AssignNode with precompiled templates
+TEST_CASE("AssignNode execution with precompiled templates", "[executor][template]") {
+    ToolRegistry registry;
+    NodeExecutor executor(registry, nullptr);
+
+    AssignNode node(
+        "/main/assign",
+        {{"greeting", "Hello {{ name }}"}, {"label", "plain text"}},
+        {}
+    );
+    for (const auto& [key, tmpl] : node.assign) {
+        node.compiled_assign[key] = InjaTemplateRenderer::compile(tmpl);
+    }
+    REQUIRE(node.compiled_assign["label"]->is_constant());
+    REQUIRE_FALSE(node.compiled_assign["greeting"]->is_constant());
+
+    // clone 共享同一份编译结果
+    auto cloned = node.clone();
+    auto* cloned_assign = dynamic_cast<AssignNode*>(cloned.get());
+    REQUIRE(cloned_assign->compiled_assign["greeting"] == node.compiled_assign["greeting"]);
+
+    for (const char* name : {"World", "Again"}) {
+        Context ctx;
+        ctx["name"] = name;
+        Context result = executor.execute_node(cloned.get(), ctx);
+        REQUIRE(result["greeting"] == std::string("Hello ") + name);
+        REQUIRE(result["label"] == "plain text");
+    }
+}
+
+// Test 6c: pure variable references keep their JSON type
+TEST_CASE("AssignNode fast path preserves value types", "[executor][template]") {
+    ToolRegistry registry;
+    NodeExecutor executor(registry, nullptr);
+
+    AssignNode node(
+        "/main/assign",
+        {{"query", "{{ user.query }}"}, {"items", "{{ user.items }}"}, {"count", "{{ user.count }}"},
+         {"summary", "{{ user.count }} items"}},
+        {}
+    );
+    for (const auto& [key, tmpl] : node.assign) {
+        node.compiled_assign[key] = InjaTemplateRenderer::compile(tmpl);
+    }
+    REQUIRE(node.compiled_assign["query"]->is_variable());
+    REQUIRE_FALSE(node.compiled_assign["summary"]->is_variable());
+
+    Context ctx;
+    ctx["user"]["query"] = "weather";
+    ctx["user"]["items"] = {1, 2, 3};
+    ctx["user"]["count"] = 3;
+
+    Context result = executor.execute_node(&node, ctx);
+    REQUIRE(result["query"] == "weather");
+    REQUIRE(result["items"] == nlohmann::json::array({1, 2, 3}));
+    REQUIRE(result["count"] == 3);
+    REQUIRE(result["summary"] == "3 items");
+
+    Context missing;
+    REQUIRE_THROWS_WITH(executor.execute_node(&node, missing), Catch::Matchers::ContainsSubstring("not found"));
+}
+
+// Test 6c2: fast-path output matches inja for floats
+TEST_CASE("Template fast path renders floats like inja", "[executor][template]") {
+    auto variable = InjaTemplateRenderer::compile("{{ x }}");
+    auto mixed = InjaTemplateRenderer::compile("x = {{ x }}");
+    REQUIRE(variable->is_variable());
+
+    for (double x : {1.0, 0.1, 2.5, -3.0, 1e20, 1.0 / 3.0, 123456789.125}) {
+        Context ctx;
+        ctx["x"] = x;
+        const std::string expected = InjaTemplateRenderer::render("{{ x }}", ctx);
+        REQUIRE(expected == nlohmann::json(x).dump());
+        REQUIRE(InjaTemplateRenderer::render(*variable, ctx) == expected);
+        REQUIRE(InjaTemplateRenderer::render(*mixed, ctx) == "x = " + expected);
+    }
+
+    // 编译期折叠的浮点结果同样按 JSON 输出
+    auto folded = InjaTemplateRenderer::compile("{{ 6 / 2 }}");
+    REQUIRE(folded->is_constant());
+    REQUIRE(InjaTemplateRenderer::render(*folded, Context::object()) ==
+            InjaTemplateRenderer::render("{{ 6 / 2 }}", Context::object()));
+    REQUIRE(InjaTemplateRenderer::render(*folded, Context::object()) == "3.0");
+}
+
+// Test 6d: concurrent rendering from worker threads
+TEST_CASE("Template rendering is safe across threads", "[executor][template]") {
+    auto compiled = InjaTemplateRenderer::compile("{{ name }}-{{ index }}");
+    constexpr int kThreads = 8;
+    constexpr int kIterations = 200;
+    std::vector<int> mismatches(kThreads, 0);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < kIterations; ++i) {
+                Context ctx;
+                ctx["name"] = "w" + std::to_string(t);
+                ctx["index"] = i;
+                std::string expected = "w" + std::to_string(t) + "-" + std::to_string(i);
+                if (InjaTemplateRenderer::render(*compiled, ctx) != expected) ++mismatches[t];
+                if (InjaTemplateRenderer::render("{{ name }}-{{ index }}", ctx) != expected) ++mismatches[t];
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    for (int count : mismatches) {
+        REQUIRE(count == 0);
+    }
+}
+
 // Test 7: StartNode and EndNode execution
 TEST_CASE("StartNode and EndNode execution", "[executor]") {
     ToolRegistry registry;
@@ -208,3 +326,86 @@ TEST_CASE("StartNode and EndNode execution", "[executor]") {
     Context end_result = executor.execute_node(&end_node, ctx);
     REQUIRE(end_result["value"] == 42);
 }
+
+// Test 8: 节点签名声明的输出未写入时按 signature_validation 处理
+TEST_CASE("Node signature outputs are enforced per validation policy", "[executor][signature]") {
+    ToolRegistry registry;
+    registry.register_tool("lookup", [](const nlohmann::json&) {
+        return nlohmann::json::object({{"hits", 3}});
+    });
+    NodeExecutor executor(registry, nullptr);
+
+    // 签名声明了 total，但节点只写 result
+    ToolCallNode node("/main/lookup", "lookup", {}, {"result"}, {});
+    node.signature = "() -> {result: object, total: number}";
+    node.compiled_signature = std::make_shared<const Signature>(Signature::parse(*node.signature));
+
+    auto run = [&](const std::string& policy, std::string& warnings) {
+        node.metadata = {{"signature_validation", policy}};
+        std::ostringstream captured;
+        auto* old = std::cerr.rdbuf(captured.rdbuf());
+        try {
+            Context result = executor.execute_node(&node, Context::object());
+            std::cerr.rdbuf(old);
+            warnings = captured.str();
+            return result;
+        } catch (...) {
+            std::cerr.rdbuf(old);
+            throw;
+        }
+    };
+
+    std::string warnings;
+    REQUIRE_THROWS_WITH(run("strict", warnings), Catch::Matchers::ContainsSubstring("missing output 'total'"));
+
+    Context result = run("warn", warnings);
+    REQUIRE(result["result"]["hits"] == 3);
+    REQUIRE(warnings.find("missing output 'total'") != std::string::npos);
+
+    result = run("ignore", warnings);
+    REQUIRE(result["result"]["hits"] == 3);
+    REQUIRE(warnings.empty());
+}
+
+// Test 9: 生成子图缺少签名要求的输出时，strict 模式拒绝该子图
+TEST_CASE("Generated graphs missing a required output are rejected in strict mode", "[executor][signature]") {
+    MarkdownParser parser;
+    auto graphs = parser.parse_from_string(R"(
+### AgenticDSL `/dynamic/summarize`
+```yaml
+# --- BEGIN AgenticDSL ---
+type: assign
+signature: "(text: string) -> {summary: string, title: string}"
+assign:
+  summary: "short"
+# --- END AgenticDSL ---
+```
+)");
+    REQUIRE(graphs.size() == 1);
+
+    GenerateSubgraphNode node("/main/generate", "prompt", {"generated_graph_path"});
+    REQUIRE(node.signature_validation == "strict");
+    REQUIRE_THROWS_WITH(NodeExecutor::check_generated_graph(&node, graphs[0]),
+                        Catch::Matchers::ContainsSubstring("no node writes output 'title'"));
+
+    node.signature_validation = "warn";
+    REQUIRE_NOTHROW(NodeExecutor::check_generated_graph(&node, graphs[0]));
+    node.signature_validation = "ignore";
+    REQUIRE_NOTHROW(NodeExecutor::check_generated_graph(&node, graphs[0]));
+
+    // 写齐必填输出后 strict 也通过
+    auto complete = parser.parse_from_string(R"(
+### AgenticDSL `/dynamic/summarize`
+```yaml
+# --- BEGIN AgenticDSL ---
+type: assign
+signature: "(text: string) -> {summary: string, title: string}"
+assign:
+  summary: "short"
+  title: "Untitled"
+# --- END AgenticDSL ---
+```
+)");
+    node.signature_validation = "strict";
+    REQUIRE_NOTHROW(NodeExecutor::check_generated_graph(&node, complete[0]));
+}
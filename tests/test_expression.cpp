@@ -0,0 +1,78 @@
+// tests/test_expression.cpp
+#include "catch_amalgamated.hpp"
+#include "common/utils/expression.h"
+
+#include <string>
+
+using namespace agenticdsl;
+
+static Value eval(const std::string& source, const Context& ctx = Context::object()) {
+    auto expr = Expression::compile(source);
+    REQUIRE(expr.has_value());
+    return expr->evaluate(ctx);
+}
+
+TEST_CASE("Expression arithmetic keeps numeric types", "[expression]") {
+    Context ctx;
+    ctx["retry"]["count"] = 2;
+    ctx["score"] = 0.5;
+
+    REQUIRE(eval("retry.count + 1", ctx) == 3);
+    REQUIRE(eval("retry.count + 1", ctx).is_number_integer());
+    REQUIRE(eval("score * 2", ctx) == 1.0);
+    REQUIRE(eval("7 / 2") == 3.5);
+    REQUIRE(eval("7 % 4") == 3);
+    REQUIRE(eval("2 ^ 10") == 1024);
+    REQUIRE(eval("-(1 + 2) * 3") == -9);
+    REQUIRE(eval("\"ab\" + \"cd\"") == "abcd");
+    REQUIRE_THROWS_WITH(eval("1 / 0"), Catch::Matchers::ContainsSubstring("division by zero"));
+
+    // 整数溢出转为浮点，不产生未定义行为
+    REQUIRE(eval("9223372036854775807 + 1").is_number_float());
+    REQUIRE(eval("9223372036854775807 + 1") == 9223372036854775808.0);
+    REQUIRE(eval("0 - 9223372036854775807 - 2").is_number_float());
+    REQUIRE(eval("4294967296 * 4294967296").is_number_float());
+    REQUIRE(eval("2 ^ 63").is_number_float());
+    REQUIRE(eval("2 ^ 62") == std::int64_t{1} << 62);
+}
+
+TEST_CASE("Expression comparisons and boolean logic", "[expression]") {
+    Context ctx;
+    ctx["status"] = "ok";
+    ctx["items"] = {1, 2, 3};
+    ctx["limit"] = 3;
+
+    REQUIRE(eval("status == \"ok\"", ctx) == true);
+    REQUIRE(eval("items.2 >= limit and status != \"error\"", ctx) == true);
+    REQUIRE(eval("not (limit > 5) or false", ctx) == true);
+    REQUIRE(eval("limit < 3 or null", ctx) == false);
+    REQUIRE(eval("items", ctx) == nlohmann::json::array({1, 2, 3}));
+}
+
+TEST_CASE("Expression operator precedence follows Inja", "[expression]") {
+    // and / or 同级、左结合：(true or true) and false
+    REQUIRE(eval("true or true and false") == false);
+    REQUIRE(eval("false and false or true") == true);
+    REQUIRE(eval("true or (true and false)") == true);
+
+    // not 先于比较：(not 0) == false
+    REQUIRE(eval("not 0 == false") == false);
+    REQUIRE(eval("not (0 == false)") == true);
+    REQUIRE(eval("not 1 == 1") == false);
+
+    // 比较先于 and / or
+    REQUIRE(eval("1 < 2 and 3 > 4 or 5 == 5") == true);
+}
+
+TEST_CASE("Expression reports missing variables and rejects unsupported syntax", "[expression]") {
+    auto expr = Expression::compile("user.name");
+    REQUIRE(expr.has_value());
+    REQUIRE(expr->is_path());
+    REQUIRE_THROWS_WITH(expr->evaluate(Context::object()), Catch::Matchers::ContainsSubstring("variable 'user.name' not found"));
+
+    // 函数调用、过滤器、in 等交给 Inja
+    REQUIRE_FALSE(Expression::compile("length(items) > 0").has_value());
+    REQUIRE_FALSE(Expression::compile("name | upper").has_value());
+    REQUIRE_FALSE(Expression::compile("1 in items").has_value());
+    REQUIRE_FALSE(Expression::compile("a ==").has_value());
+}
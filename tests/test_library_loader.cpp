@@ -1,6 +1,12 @@
 // tests/test_library_loader.cpp
 #include "catch_amalgamated.hpp"
 #include "modules/library/library_loader.h"
+#include "modules/library/subgraph_catalog.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
 
 TEST_CASE("StandardLibraryLoader loads builtin noop", "[library][stage3]") {
     auto& loader = agenticdsl::StandardLibraryLoader::instance();
@@ -14,3 +20,226 @@ TEST_CASE("StandardLibraryLoader loads builtin noop", "[library][stage3]") {
     }
     REQUIRE(found);
 }
+
+TEST_CASE("StandardLibraryLoader indexes via manifest and parses graphs lazily", "[library]") {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "agenticdsl-test-lib";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "text");
+    const fs::path file = dir / "text" / "echo.md";
+
+    auto write_lib = [&](const std::string& output) {
+        std::ofstream out(file, std::ios::trunc);
+        out << "### AgenticDSL `/lib/text/echo`\n```yaml\n# --- BEGIN AgenticDSL ---\n"
+               "graph_type: subgraph\n"
+               "signature: \"(text: string) -> " << output << ": string\"\n"
+               "nodes:\n"
+               "  - id: copy\n"
+               "    type: assign\n"
+               "    assign:\n"
+               "      " << output << ": \"{{ text }}\"\n"
+               "# --- END AgenticDSL ---\n```\n";
+    };
+    agenticdsl::LibrarySnapshotPtr snapshot;
+    auto find_entry = [&snapshot](const std::string& path) -> const agenticdsl::LibraryEntry* {
+        snapshot = agenticdsl::StandardLibraryLoader::instance().snapshot();
+        for (const auto& lib : snapshot->entries) {
+            if (lib.path == path) return &lib;
+        }
+        return nullptr;
+    };
+
+    auto& loader = agenticdsl::StandardLibraryLoader::instance();
+    write_lib("echo");
+    loader.load_from_directory(dir.string());
+    const auto* entry = find_entry("/lib/text/echo");
+    REQUIRE(entry != nullptr);
+    REQUIRE(entry->signature == std::optional<std::string>("(text: string) -> echo: string"));
+    REQUIRE(entry->source_file == fs::weakly_canonical(file).string());
+
+    // mtime 与大小不变时信任清单，不重新解析（echo -> xcho 长度相同）
+    const auto mtime = fs::last_write_time(file);
+    write_lib("xcho");
+    fs::last_write_time(file, mtime);
+    loader.load_from_directory(dir.string());
+    REQUIRE(find_entry("/lib/text/echo")->signature == std::optional<std::string>("(text: string) -> echo: string"));
+
+    // mtime 变化后重新解析
+    fs::last_write_time(file, mtime + std::chrono::seconds(5));
+    loader.load_from_directory(dir.string());
+    REQUIRE(find_entry("/lib/text/echo")->signature == std::optional<std::string>("(text: string) -> xcho: string"));
+
+    const auto* graph = snapshot->find_graph("/lib/text/echo/copy");
+    REQUIRE(graph != nullptr);
+    REQUIRE(graph->path == "/lib/text/echo");
+    REQUIRE(graph->nodes.size() == 1);
+    REQUIRE(snapshot->find_graph("/lib/text/missing") == nullptr);
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("Manifest-indexed library files are read on first access and dropped if changed", "[library]") {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "agenticdsl-test-lib-lazy";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const fs::path file = dir / "upper.md";
+    {
+        std::ofstream out(file);
+        out << "### AgenticDSL `/lib/lazy/upper`\n```yaml\n# --- BEGIN AgenticDSL ---\n"
+               "graph_type: subgraph\n"
+               "nodes:\n"
+               "  - id: copy\n"
+               "    type: assign\n"
+               "    assign:\n"
+               "      upper: \"{{ text }}\"\n"
+               "# --- END AgenticDSL ---\n```\n";
+    }
+    // 与清单记录相同的编码
+    const auto mtime = static_cast<std::int64_t>(fs::last_write_time(file).time_since_epoch().count());
+    const auto size = static_cast<std::uint64_t>(fs::file_size(file));
+
+    auto snapshot_with = [&](std::shared_ptr<const agenticdsl::LibraryFile> lib) {
+        agenticdsl::LibrarySnapshot snap;
+        agenticdsl::LibraryEntry entry;
+        entry.path = "/lib/lazy/upper";
+        entry.is_subgraph = true;
+        entry.source_file = file.string();
+        snap.entries.push_back(entry);
+        snap.files[file.string()] = std::move(lib);
+        return snap;
+    };
+
+    auto unchanged = snapshot_with(std::make_shared<const agenticdsl::LibraryFile>(file.string(), mtime, size));
+    auto changed = snapshot_with(std::make_shared<const agenticdsl::LibraryFile>(file.string(), mtime, size));
+    const auto* graph = unchanged.find_graph("/lib/lazy/upper");
+    REQUIRE(graph != nullptr);
+    REQUIRE(graph->nodes.size() == 1);
+
+    // 首次访问前文件被改写：不读入新内容，该文件视为不在快照中
+    std::ofstream(file, std::ios::app) << "\n";
+    REQUIRE(changed.find_graph("/lib/lazy/upper") == nullptr);
+    // 已读入的快照不受影响
+    REQUIRE(unchanged.find_graph("/lib/lazy/upper") == graph);
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("StandardLibraryLoader publishes a new snapshot when a file changes", "[library]") {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "agenticdsl-test-lib-reload";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const fs::path file = fs::weakly_canonical(dir) / "greet.md";
+
+    auto write_lib = [&](const std::string& output) {
+        std::ofstream out(file, std::ios::trunc);
+        out << "### AgenticDSL `/lib/reload/greet`\n```yaml\n# --- BEGIN AgenticDSL ---\n"
+               "graph_type: subgraph\n"
+               "signature: \"(name: string) -> " << output << ": string\"\n"
+               "nodes:\n"
+               "  - id: say\n"
+               "    type: assign\n"
+               "    assign:\n"
+               "      " << output << ": \"{{ name }}\"\n"
+               "# --- END AgenticDSL ---\n```\n";
+    };
+    auto signature_in = [](const agenticdsl::LibrarySnapshotPtr& snap) -> std::optional<std::string> {
+        for (const auto& lib : snap->entries) {
+            if (lib.path == "/lib/reload/greet") return lib.signature;
+        }
+        return std::nullopt;
+    };
+
+    auto assigned_key = [](const agenticdsl::LibrarySnapshotPtr& snap) -> std::string {
+        const auto* graph = snap->find_graph("/lib/reload/greet");
+        if (!graph || graph->nodes.size() != 1) return "";
+        const auto* node = dynamic_cast<const agenticdsl::AssignNode*>(graph->nodes[0].get());
+        return node && node->assign.size() == 1 ? node->assign.begin()->first : "";
+    };
+
+    auto& loader = agenticdsl::StandardLibraryLoader::instance();
+    write_lib("hello");
+    loader.load_from_directory(dir.string());
+    auto before = loader.snapshot();
+    REQUIRE(signature_in(before) == std::optional<std::string>("(name: string) -> hello: string"));
+
+    // 进行中的运行持有的旧快照不受重载影响：旧快照的图在文件改写之后才第一次访问，仍是旧内容
+    write_lib("greeting");
+    loader.reload_file(file.string());
+    auto after = loader.snapshot();
+    REQUIRE(after->version > before->version);
+    REQUIRE(signature_in(after) == std::optional<std::string>("(name: string) -> greeting: string"));
+    REQUIRE(signature_in(before) == std::optional<std::string>("(name: string) -> hello: string"));
+    REQUIRE(assigned_key(before) == "hello");
+    REQUIRE(assigned_key(after) == "greeting");
+
+    fs::remove(file);
+    loader.reload_file(file.string());
+    REQUIRE_FALSE(signature_in(loader.snapshot()).has_value());
+    REQUIRE(loader.snapshot()->find_graph("/lib/reload/greet") == nullptr);
+
+#if defined(__linux__)
+    // 监视线程在文件写入后自动重新索引
+    REQUIRE(loader.start_watching());
+    write_lib("watched");
+    bool reloaded = false;
+    for (int i = 0; i < 200 && !reloaded; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        reloaded = signature_in(loader.snapshot()) == std::optional<std::string>("(name: string) -> watched: string");
+    }
+    loader.stop_watching();
+    REQUIRE(reloaded);
+#endif
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("SubgraphCatalog ranks subgraphs by relevance to the prompt", "[library]") {
+    using agenticdsl::LibraryEntry;
+    auto entry = [](std::string path, std::string signature) {
+        LibraryEntry e;
+        e.path = std::move(path);
+        e.signature = std::move(signature);
+        e.output_schema = nlohmann::json::array({{{"name", "result"}, {"type", "string"}, {"required", true}}});
+        e.is_subgraph = true;
+        return e;
+    };
+    auto snapshot = std::make_shared<agenticdsl::LibrarySnapshot>();
+    snapshot->version = 1000; // 与全局加载器的版本区分
+    snapshot->entries = {
+        entry("/lib/text/summarize", "(text: string) -> summary: string"),
+        entry("/lib/data/parse_json", "(raw: string) -> data: object"),
+        entry("/lib/web/search", "(query: string) -> results: array"),
+    };
+
+    std::vector<agenticdsl::ParsedGraph> graphs(1);
+    graphs[0].path = "/dynamic/translate_text";
+    graphs[0].output_schema = nlohmann::json::array();
+
+    agenticdsl::SubgraphCatalog catalog;
+    catalog.refresh(snapshot, &graphs);
+    REQUIRE(catalog.size() == 4);
+    REQUIRE(catalog.all()[3]["stability"] == "dynamic");
+
+    auto top = catalog.top_k("请解析这段 JSON 数据", 1);
+    REQUIRE(top.size() == 1);
+    REQUIRE(top[0]["path"] == "/lib/data/parse_json");
+
+    top = catalog.top_k("search the web, then summarize the text", 2);
+    REQUIRE(top.size() == 2);
+    REQUIRE(top[0]["path"] == "/lib/web/search");
+    REQUIRE(top[1]["path"] == "/lib/text/summarize");
+
+    // 没有任何词命中时退回目录顺序；k 不小于目录大小时返回全部
+    REQUIRE(catalog.top_k("zzz", 2)[0]["path"] == "/lib/text/summarize");
+    REQUIRE(catalog.top_k("", 10).size() == 4);
+
+    // 图集增长后重建
+    graphs.emplace_back();
+    graphs.back().path = "/dynamic/fetch_web_page";
+    graphs.back().output_schema = nlohmann::json::array();
+    catalog.refresh(snapshot, &graphs);
+    REQUIRE(catalog.size() == 5);
+    REQUIRE(catalog.top_k("fetch a page", 1)[0]["path"] == "/dynamic/fetch_web_page");
+}
@@ -1,6 +1,11 @@
 #include "catch_amalgamated.hpp"
 #include "common/llm/llm_tool.h"
 #include "common/llm/llama_tool.h"
+#include "common/llm/caching_llm_tool.h"
+#include "common/llm/model_registry.h"
+#include "common/tools/registry.h"
+#include <filesystem>
+#include <fstream>
 #include <stdexcept>
 
 using namespace agenticdsl;
@@ -36,6 +41,336 @@ TEST_CASE("LlamaTool throws on missing model", "[llama_tool]") {
     REQUIRE(threw);
 }
 
+namespace {
+// 逐词流式输出的假 LLM 工具
+class WordStreamTool : public ILLMTool {
+public:
+    LLMResult generate(const std::string& prompt, const LLMParams& params = {}) override {
+        return generate_stream(prompt, nullptr, params);
+    }
+    LLMResult generate_stream(const std::string& prompt, const StreamCallback& on_chunk, const LLMParams&) override {
+        LLMResult result;
+        result.success = true;
+        for (const char* word : {"one ", "two ", "three "}) {
+            result.text += word;
+            ++result.tokens_generated;
+            if (on_chunk && !on_chunk(word)) {
+                result.stopped = true;
+                break;
+            }
+        }
+        return result;
+    }
+    bool is_available() const override { return true; }
+    std::string name() const override { return "words"; }
+};
+
+class WholeTextTool : public ILLMTool {
+public:
+    LLMResult generate(const std::string& prompt, const LLMParams&) override {
+        LLMResult result;
+        result.success = true;
+        result.text = "echo: " + prompt;
+        return result;
+    }
+    bool is_available() const override { return true; }
+    std::string name() const override { return "whole"; }
+};
+
+// 每次调用输出不同文本，便于区分是否命中缓存
+class CountingTool : public ILLMTool {
+public:
+    explicit CountingTool(int* calls) : calls_(calls) {}
+    LLMResult generate(const std::string& prompt, const LLMParams&) override {
+        LLMResult result;
+        result.success = true;
+        result.text = prompt + "#" + std::to_string(++*calls_);
+        return result;
+    }
+    bool is_available() const override { return true; }
+    std::string name() const override { return "counting"; }
+
+private:
+    int* calls_;
+};
+} // namespace
+
+TEST_CASE("ILLMTool streams chunks and stops early", "[llm_tool]") {
+    ToolRegistry registry;
+    registry.register_llm_tool("words", std::make_unique<WordStreamTool>());
+    registry.register_llm_tool("whole", std::make_unique<WholeTextTool>());
+
+    std::vector<std::string> chunks;
+    auto result = registry.call_llm_tool("words", "count", {}, [&](std::string_view chunk) {
+        chunks.emplace_back(chunk);
+        return chunks.size() < 2;
+    });
+    REQUIRE(chunks == std::vector<std::string>{"one ", "two "});
+    REQUIRE(result["text"] == "one two ");
+    REQUIRE(result["stopped"] == true);
+
+    // 不流式调用时结果不变
+    result = registry.call_llm_tool("words", "count");
+    REQUIRE(result["text"] == "one two three ");
+    REQUIRE_FALSE(result.contains("stopped"));
+
+    // 默认实现：整段文本作为一个块
+    chunks.clear();
+    result = registry.call_llm_tool("whole", "hi", {}, [&](std::string_view chunk) {
+        chunks.emplace_back(chunk);
+        return true;
+    });
+    REQUIRE(chunks == std::vector<std::string>{"echo: hi"});
+    REQUIRE(result["text"] == "echo: hi");
+}
+
+TEST_CASE("CachingLLMTool caches deterministic calls only", "[llm_tool]") {
+    int calls = 0;
+    ToolRegistry registry;
+    registry.register_llm_tool("cached", std::make_unique<CachingLLMTool>(std::make_unique<CountingTool>(&calls),
+                                                                         CachingLLMTool::Options{2, {}, "counting"}));
+    LLMParams greedy;
+    greedy.temperature = 0.0f;
+    REQUIRE(registry.call_llm_tool("cached", "a", greedy)["text"] == "a#1");
+    REQUIRE(registry.call_llm_tool("cached", "a", greedy)["text"] == "a#1");
+    REQUIRE(calls == 1);
+
+    // 参数不同即不同的键
+    greedy.max_tokens = 16;
+    REQUIRE(registry.call_llm_tool("cached", "a", greedy)["text"] == "a#2");
+
+    // 随机采样（未固定 seed）直接透传
+    REQUIRE(registry.call_llm_tool("cached", "a")["text"] == "a#3");
+    REQUIRE(registry.call_llm_tool("cached", "a")["text"] == "a#4");
+
+    // 固定 seed 可缓存；流式调用命中时整段回调
+    LLMParams seeded;
+    seeded.seed = 7;
+    REQUIRE(registry.call_llm_tool("cached", "b", seeded)["text"] == "b#5");
+    std::vector<std::string> chunks;
+    auto result = registry.call_llm_tool("cached", "b", seeded, [&](std::string_view chunk) {
+        chunks.emplace_back(chunk);
+        return true;
+    });
+    REQUIRE(result["text"] == "b#5");
+    REQUIRE(chunks == std::vector<std::string>{"b#5"});
+
+    // 容量为 2：最久未用的 "a"(max_tokens=512) 已被淘汰
+    greedy.max_tokens = 512;
+    REQUIRE(registry.call_llm_tool("cached", "a", greedy)["text"] == "a#6");
+}
+
+TEST_CASE("CachingLLMTool reuses disk entries across instances", "[llm_tool]") {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / "agenticdsl-llm-cache-test";
+    fs::remove_all(dir);
+
+    int calls = 0;
+    LLMParams greedy;
+    greedy.temperature = 0.0f;
+    {
+        CachingLLMTool tool(std::make_unique<CountingTool>(&calls), {16, dir, "model-a"});
+        REQUIRE(tool.generate("q", greedy).text == "q#1");
+        REQUIRE(tool.misses() == 1);
+    }
+    {
+        CachingLLMTool tool(std::make_unique<CountingTool>(&calls), {16, dir, "model-a"});
+        REQUIRE(tool.generate("q", greedy).text == "q#1");
+        REQUIRE(tool.hits() == 1);
+    }
+    {
+        // 模型标识不同，不共享条目
+        CachingLLMTool tool(std::make_unique<CountingTool>(&calls), {16, dir, "model-b"});
+        REQUIRE(tool.generate("q", greedy).text == "q#2");
+    }
+    REQUIRE(calls == 2);
+    fs::remove_all(dir);
+}
+
+TEST_CASE("CachingLLMTool keys entries by model file", "[llm_tool]") {
+    namespace fs = std::filesystem;
+    int calls = 0;
+    REQUIRE_THROWS_AS(CachingLLMTool(std::make_unique<CountingTool>(&calls), {16, {}, ""}), std::invalid_argument);
+
+    const fs::path dir = fs::temp_directory_path() / "agenticdsl-model-id-test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::ofstream(dir / "a.gguf") << "model a";
+    std::ofstream(dir / "b.gguf") << "model b!";
+
+    // 同名工具（都是 "llama"）加载不同文件：标识不同
+    const std::string a = LlamaTool::model_id((dir / "a.gguf").string());
+    REQUIRE(a != LlamaTool::model_id((dir / "b.gguf").string()));
+    // 同一文件经不同路径写法得到同一标识
+    REQUIRE(a == LlamaTool::model_id((dir / "." / "a.gguf").string()));
+    // 文件内容变化（大小不同）后标识随之变化
+    std::ofstream(dir / "a.gguf") << "model a, retrained";
+    REQUIRE(a != LlamaTool::model_id((dir / "a.gguf").string()));
+    fs::remove_all(dir);
+}
+
+TEST_CASE("LlamaAdapter reuses the longest shared token prefix", "[llama_tool]") {
+    using Tokens = std::vector<llama_token>;
+    // 系统提示相同、用户输入不同：截断到第一个差异处
+    REQUIRE(LlamaAdapter::reusable_prefix({1, 10, 11, 12, 20}, {1, 10, 11, 12, 30, 31}) == 4);
+    // 新 prompt 是缓存的延续：只预填充新增部分
+    REQUIRE(LlamaAdapter::reusable_prefix({1, 10, 11}, {1, 10, 11, 12}) == 3);
+    // 完全相同：保留最后一个 token 重新解码以得到 logits
+    REQUIRE(LlamaAdapter::reusable_prefix({1, 10, 11}, {1, 10, 11}) == 2);
+    // 缓存比 prompt 长（上次的回复）：截去多余部分
+    REQUIRE(LlamaAdapter::reusable_prefix({1, 10, 11, 40, 41}, {1, 10}) == 1);
+    REQUIRE(LlamaAdapter::reusable_prefix(Tokens{}, {1, 10}) == 0);
+    REQUIRE(LlamaAdapter::reusable_prefix({2, 10}, {1, 10}) == 0);
+}
+
+TEST_CASE("LlamaAdapter splits the context between parallel slots", "[llama_tool]") {
+    // 默认单序列：整个 n_ctx 归一个请求，与引入并行 slot 之前一致
+    LlamaAdapter::Config config;
+    REQUIRE(config.n_parallel == 1);
+    REQUIRE(LlamaAdapter::sequence_window(static_cast<uint32_t>(config.n_ctx), config.n_parallel) == 2048);
+
+    REQUIRE(LlamaAdapter::sequence_window(2048, 4) == 512);
+    REQUIRE(LlamaAdapter::sequence_window(8192, 4) == 2048);
+    REQUIRE(LlamaAdapter::sequence_window(2048, 0) == 2048);
+    REQUIRE(LlamaAdapter::sequence_window(3, 8) == 2);
+}
+
+TEST_CASE("LlamaAdapter assigns requests to the free slot with the longest prefix", "[llama_tool]") {
+    using Tokens = std::vector<llama_token>;
+    const Tokens empty;
+    const Tokens chat = {1, 10, 11, 12};
+    const Tokens other = {1, 20, 21};
+    const Tokens prompt = {1, 10, 11, 12, 13};
+
+    REQUIRE(LlamaAdapter::choose_slot({&empty, &chat, &other}, prompt) == 1);
+    // 最匹配的 slot 正忙：退而取其次
+    REQUIRE(LlamaAdapter::choose_slot({&empty, nullptr, &other}, prompt) == 2);
+    // 前缀长度相同取靠前的 slot
+    REQUIRE(LlamaAdapter::choose_slot({&empty, &empty}, prompt) == 0);
+    REQUIRE(LlamaAdapter::choose_slot({nullptr, nullptr}, prompt) == -1);
+}
+
+TEST_CASE("LlamaAdapter truncates prompts that overflow the context window", "[llama_tool]") {
+    using Tokens = std::vector<llama_token>;
+    Tokens tokens;
+    for (int i = 0; i < 20; ++i) tokens.push_back(i);
+
+    // 窗口足够：不变
+    Tokens fits = tokens;
+    LlamaAdapter::truncate_prompt(fits, 21, 4);
+    REQUIRE(fits == tokens);
+
+    // 保留开头 4 个与末尾 (16 - 4) / 2 = 6 个
+    Tokens cut = tokens;
+    LlamaAdapter::truncate_prompt(cut, 16, 4);
+    REQUIRE(cut == Tokens{0, 1, 2, 3, 14, 15, 16, 17, 18, 19});
+
+    // n_keep 过大时限制为半个窗口，仍为生成留出空间
+    cut = tokens;
+    LlamaAdapter::truncate_prompt(cut, 8, 100);
+    REQUIRE(cut.size() < 8);
+    REQUIRE(cut.front() == 0);
+    REQUIRE(cut.back() == 19);
+
+    // 默认 n_keep 保留半个窗口的开头（系统提示与指令），而不只是 BOS
+    REQUIRE(LlamaAdapter::Config{}.n_keep < 0);
+    const size_t keep = LlamaAdapter::keep_tokens(LlamaAdapter::Config{}.n_keep, 16);
+    REQUIRE(keep == 8);
+    cut = tokens;
+    LlamaAdapter::truncate_prompt(cut, 16, keep);
+    REQUIRE(cut == Tokens{0, 1, 2, 3, 4, 5, 6, 7, 16, 17, 18, 19});
+
+    REQUIRE(LlamaAdapter::keep_tokens(0, 16) == 1);   // BOS 总是保留
+    REQUIRE(LlamaAdapter::keep_tokens(5, 16) == 5);
+    REQUIRE(LlamaAdapter::keep_tokens(100, 16) == 8);
+    REQUIRE(LlamaAdapter::keep_tokens(-1, 1) == 1);
+}
+
+TEST_CASE("LlamaAdapter rolls back rejected draft tokens", "[llama_tool]") {
+    using Tokens = std::vector<llama_token>;
+    // 本轮开始：KV 中为 prompt {1, 2, 3}，待解码 4；草稿模型基于 {1, 2, 3, 4} 给出 {5, 6, 7}，
+    // 最后一个草稿 token 不在草稿 KV 中
+    const Tokens draft = {5, 6, 7};
+    const Tokens draft_cached = {1, 2, 3, 4, 5, 6};
+    const Tokens cached = {1, 2, 3, 4, 5, 6, 7}; // 主模型本轮送入 4 与全部草稿
+
+    // 第三个位置不一致：接受 2 个，丢弃 KV 位置 [6, 末尾)，主模型的 9 成为下一个待解码 token
+    auto verdict = LlamaAdapter::verify_draft(cached.size(), draft, {5, 6, 9});
+    REQUIRE(verdict.accepted == 2);
+    REQUIRE(verdict.keep == 6);
+    Tokens next_target(cached.begin(), cached.begin() + static_cast<std::ptrdiff_t>(verdict.keep));
+    next_target.push_back(9);
+    // 下一轮草稿同步只需补上 9
+    REQUIRE(LlamaAdapter::reusable_prefix(draft_cached, next_target) == 6);
+
+    // 全部接受：额外得到一个主模型 token，KV 不回退；草稿 KV 需补上 7 与 8
+    verdict = LlamaAdapter::verify_draft(cached.size(), draft, {5, 6, 7, 8});
+    REQUIRE(verdict.accepted == 3);
+    REQUIRE(verdict.keep == cached.size());
+    next_target = cached;
+    next_target.push_back(8);
+    REQUIRE(LlamaAdapter::reusable_prefix(draft_cached, next_target) == 6);
+
+    // 第一个位置就不一致：只保留本轮送入的 4
+    verdict = LlamaAdapter::verify_draft(cached.size(), draft, {8});
+    REQUIRE(verdict.accepted == 0);
+    REQUIRE(verdict.keep == 4);
+
+    // 生成在第二个位置结束（该 token 未被接受，不在 sampled 中）
+    verdict = LlamaAdapter::verify_draft(cached.size(), draft, {5});
+    REQUIRE(verdict.accepted == 1);
+    REQUIRE(verdict.keep == 5);
+}
+
+TEST_CASE("LlamaTool maps LLMParams onto per-call sampling parameters", "[llama_tool]") {
+    LlamaAdapter::SamplingParams defaults;
+    defaults.temperature = 0.7f;
+    defaults.min_p = 0.05f;
+    defaults.n_predict = 256;
+
+    // 默认 LLMParams 不引入 top_p / top_k 截断，min_p 与种子沿用 adapter 默认值
+    auto sampling = LlamaTool::sampling_for(LLMParams{}, defaults);
+    REQUIRE(sampling.temperature == 0.7f);
+    REQUIRE(sampling.top_p == 1.0f);
+    REQUIRE(sampling.top_k == 0);
+    REQUIRE(sampling.min_p == 0.05f);
+    REQUIRE(sampling.n_predict == 512);
+    REQUIRE(sampling.seed == defaults.seed);
+    REQUIRE(sampling.grammar.empty());
+
+    LLMParams params;
+    params.temperature = 0.0f;
+    params.max_tokens = 32;
+    params.top_p = 0.9f;
+    params.top_k = 40;
+    params.min_p = 0.1f;
+    params.seed = 42;
+    params.grammar = "root ::= \"a\"";
+    sampling = LlamaTool::sampling_for(params, defaults);
+    REQUIRE(sampling.temperature == 0.0f); // 贪心
+    REQUIRE(sampling.n_predict == 32);
+    REQUIRE(sampling.top_p == 0.9f);
+    REQUIRE(sampling.top_k == 40);
+    REQUIRE(sampling.min_p == 0.1f);
+    REQUIRE(sampling.seed == 42u);
+    REQUIRE(sampling.grammar == params.grammar);
+
+    // 负温度同样贪心；max_tokens <= 0 沿用默认长度
+    params = LLMParams{};
+    params.temperature = -1.0f;
+    params.max_tokens = 0;
+    sampling = LlamaTool::sampling_for(params, defaults);
+    REQUIRE(sampling.temperature == 0.0f);
+    REQUIRE(sampling.n_predict == 256);
+}
+
+TEST_CASE("ModelRegistry does not cache failed loads", "[llama_tool]") {
+    auto& registry = ModelRegistry::instance();
+    const size_t before = registry.loaded_count();
+    REQUIRE(registry.acquire("models/nonexistent.gguf") == nullptr);
+    REQUIRE(registry.loaded_count() == before);
+}
+
 TEST_CASE("LlamaTool name returns llama", "[llama_tool]") {
     REQUIRE(true);
 }
@@ -0,0 +1,202 @@
+// tests/test_optimizer.cpp
+#include "catch_amalgamated.hpp"
+#include "modules/optimizer/dependency_analysis.h"
+#include "modules/optimizer/graph_optimizer.h"
+#include "modules/parser/markdown_parser.h"
+#include "common/utils/template_renderer.h"
+
+#include <algorithm>
+#include <string>
+
+using namespace agenticdsl;
+
+static std::vector<std::unique_ptr<Node>> collect_nodes(const std::vector<ParsedGraph>& graphs) {
+    std::vector<std::unique_ptr<Node>> nodes;
+    for (const auto& graph : graphs) {
+        for (const auto& node : graph.nodes) nodes.push_back(node->clone());
+    }
+    return nodes;
+}
+
+static const Node* find_node(const std::vector<std::unique_ptr<Node>>& nodes, const std::string& path) {
+    auto it = std::find_if(nodes.begin(), nodes.end(), [&](const auto& n) { return n->path == path; });
+    return it != nodes.end() ? it->get() : nullptr;
+}
+
+TEST_CASE("Optimizer prunes unreachable nodes and fuses assign chains", "[optimizer]") {
+    std::string markdown = R"(
+### AgenticDSL `/main`
+```yaml
+# --- BEGIN AgenticDSL ---
+graph_type: subgraph
+entry: start
+nodes:
+  - id: start
+    type: start
+    next: ["/main/a"]
+  - id: a
+    type: assign
+    assign:
+      x: "one"
+    next: ["/main/check"]
+  - id: check
+    type: assert
+    condition: "{{ 2 > 1 }}"
+    next: ["/main/b"]
+  - id: b
+    type: assign
+    assign:
+      y: "two"
+    next: ["/main/c"]
+  - id: c
+    type: assign
+    assign:
+      z: "{{ y }}"
+    next: ["/main/end"]
+  - id: end
+    type: end
+  - id: orphan
+    type: assign
+    assign:
+      unused: "none"
+    next: ["/main/end"]
+# --- END AgenticDSL ---
+```
+)";
+    MarkdownParser parser;
+    auto graphs = parser.parse_from_string(markdown);
+    auto nodes = collect_nodes(graphs);
+    auto entry = GraphOptimizer::find_entry_point(graphs);
+    REQUIRE(entry == std::optional<NodePath>("/main/start"));
+
+    auto stats = GraphOptimizer().optimize(nodes, entry);
+    REQUIRE(stats.pruned_nodes == 1);
+    REQUIRE(stats.folded_nodes == 1);
+    REQUIRE(stats.fused_assigns == 1); // a + b 合并；c 读取 b 写入的 y，保持独立
+
+    REQUIRE(find_node(nodes, "/main/orphan") == nullptr);
+    REQUIRE(find_node(nodes, "/main/check") == nullptr);
+    REQUIRE(find_node(nodes, "/main/b") == nullptr);
+    auto* fused = static_cast<const AssignNode*>(find_node(nodes, "/main/a"));
+    REQUIRE(fused != nullptr);
+    REQUIRE(fused->assign.size() == 2);
+    REQUIRE(fused->next == std::vector<NodePath>{"/main/c"});
+    REQUIRE(find_node(nodes, "/main/c") != nullptr);
+}
+
+TEST_CASE("Optimizer leaves graphs with generated subgraphs untouched", "[optimizer]") {
+    std::string markdown = R"(
+### AgenticDSL `/main`
+```yaml
+# --- BEGIN AgenticDSL ---
+graph_type: subgraph
+entry: gen
+nodes:
+  - id: gen
+    type: generate_subgraph
+    prompt_template: "plan"
+    output_keys: ["plan"]
+    next: ["/main/a"]
+  - id: a
+    type: assign
+    assign:
+      x: "one"
+    next: ["/main/b"]
+  - id: b
+    type: assign
+    assign:
+      y: "two"
+  - id: later
+    type: assign
+    assign:
+      z: "three"
+# --- END AgenticDSL ---
+```
+)";
+    MarkdownParser parser;
+    auto graphs = parser.parse_from_string(markdown);
+    auto nodes = collect_nodes(graphs);
+    auto stats = GraphOptimizer().optimize(nodes, GraphOptimizer::find_entry_point(graphs));
+    REQUIRE(stats.pruned_nodes == 0);
+    REQUIRE(stats.fused_assigns == 0);
+    REQUIRE(nodes.size() == 4);
+}
+
+TEST_CASE("Templates without variables fold to typed constants", "[optimizer][template]") {
+    auto folded = InjaTemplateRenderer::compile("{{ 60 * 60 }}");
+    REQUIRE(folded->is_constant());
+    REQUIRE(InjaTemplateRenderer::evaluate(*folded, Context::object()) == 3600);
+    REQUIRE(InjaTemplateRenderer::render(*folded, Context::object()) == "3600");
+
+    // 求值出错的表达式保留到运行期报错
+    auto failing = InjaTemplateRenderer::compile("{{ 1 / 0 }}");
+    REQUIRE_FALSE(failing->is_constant());
+    REQUIRE_THROWS(InjaTemplateRenderer::evaluate(*failing, Context::object()));
+
+    REQUIRE_FALSE(InjaTemplateRenderer::compile("{{ x + 1 }}")->is_constant());
+}
+
+TEST_CASE("Template read sets skip literals, members and function names", "[optimizer][dependency]") {
+    auto reads = template_reads("{{ length(items) }} {% if user.name == 'bob' %}{{ \"x\" + greeting }}{% endif %}{# note #}");
+    REQUIRE(reads.has_value());
+    REQUIRE(*reads == std::unordered_set<std::string>{"items", "user", "greeting"});
+    REQUIRE_FALSE(template_reads("## if flag\nyes\n## endif").has_value());
+}
+
+TEST_CASE("Optimizer relaxes next edges between independent tool calls", "[optimizer][dependency]") {
+    std::string markdown = R"(
+### AgenticDSL `/main`
+```yaml
+# --- BEGIN AgenticDSL ---
+graph_type: subgraph
+entry: start
+nodes:
+  - id: start
+    type: assign
+    assign:
+      city: "Paris"
+      topic: "museums"
+    next: ["/main/weather"]
+  - id: weather
+    type: tool_call
+    tool: get_weather
+    arguments:
+      location: "{{ city }}"
+    output_keys: ["weather"]
+    next: ["/main/search"]
+  - id: search
+    type: tool_call
+    tool: web_search
+    arguments:
+      query: "{{ topic }}"
+    output_keys: ["search"]
+    next: ["/main/summary"]
+  - id: summary
+    type: tool_call
+    tool: web_search
+    arguments:
+      query: "{{ weather.condition }}"
+    output_keys: ["summary"]
+    next: ["/main/end"]
+  - id: end
+    type: end
+# --- END AgenticDSL ---
+```
+)";
+    MarkdownParser parser;
+    auto graphs = parser.parse_from_string(markdown);
+    auto nodes = collect_nodes(graphs);
+    auto stats = GraphOptimizer().optimize(nodes, GraphOptimizer::find_entry_point(graphs));
+
+    // summary 读取 weather 写入的键，这条边保留；其余两条 next 边不承载数据
+    REQUIRE(stats.relaxed_edges == 2);
+    auto next_of = [&](const std::string& path) {
+        auto next = find_node(nodes, path)->next;
+        std::sort(next.begin(), next.end());
+        return next;
+    };
+    REQUIRE(next_of("/main/start") == std::vector<NodePath>{"/main/search", "/main/summary", "/main/weather"});
+    REQUIRE(next_of("/main/weather") == std::vector<NodePath>{"/main/summary"});
+    REQUIRE(next_of("/main/search") == std::vector<NodePath>{"/main/end"});
+    REQUIRE(next_of("/main/summary") == std::vector<NodePath>{"/main/end"});
+}
@@ -4,6 +4,13 @@
 #include "core/types/node.h"
 #include "common/utils/parser_utils.h"
 #include "common/utils/yaml_json.h"
+#include "modules/parser/graph_cache.h"
+#include "modules/parser/streaming_parser.h"
+#include "modules/parser/dsl_grammar.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <string>
 #include <iostream>
 #include <yaml-cpp/yaml.h>
@@ -107,6 +114,7 @@ llm_params:
   temperature: 0.5
   max_tokens: 256
   top_p: 0.9
+  min_p: 0.1
   n_ctx: 4096
   n_threads: 8
   model: "llama-2-7b"
@@ -136,6 +144,7 @@ metadata:
     REQUIRE(dsl_node->llm_params.temperature == 0.5f);
     REQUIRE(dsl_node->llm_params.max_tokens == 256);
     REQUIRE(dsl_node->llm_params.top_p == 0.9f);
+    REQUIRE(dsl_node->llm_params.min_p == 0.1f);
     REQUIRE(dsl_node->llm_params.n_ctx == 4096);
     REQUIRE(dsl_node->llm_params.n_threads == 8);
     REQUIRE(dsl_node->llm_params.model == "llama-2-7b");
@@ -282,6 +291,276 @@ arguments: {}
     }
 }
 
+// Test 8b: Block scanner skips malformed blocks and reports offsets
+TEST_CASE("Scan pathed blocks without regex", "[parser][utils]") {
+    std::string markdown = R"(Intro prose mentioning AgenticDSL.
+
+### AgenticDSL `/main/a`
+```yaml
+# --- BEGIN AgenticDSL ---
+x: 1
+# --- END AgenticDSL ---
+```
+
+### AgenticDSL `/main/missing_begin`
+```yaml
+x: 2
+```
+
+## AgenticDSL `/main/b`
+
+```
+# --- BEGIN AgenticDSL ---
+y: 2
+# --- END AgenticDSL ---
+```
+trailing text)";
+
+    auto blocks = scan_pathed_blocks(markdown);
+    REQUIRE(blocks.size() == 2);
+    REQUIRE(blocks[0].path == "/main/a");
+    REQUIRE(blocks[0].content == "x: 1");
+    REQUIRE(blocks[1].path == "/main/b");
+    REQUIRE(blocks[1].content == "y: 2");
+    REQUIRE(markdown.substr(blocks[1].end_offset) == "\ntrailing text");
+
+    REQUIRE(is_valid_node_path("/lib/utils/my-tool_2"));
+    REQUIRE_FALSE(is_valid_node_path("/"));
+    REQUIRE_FALSE(is_valid_node_path("lib/x"));
+    REQUIRE_FALSE(is_valid_node_path("/lib/x y"));
+}
+
+// Test 8c: Parallel block parsing keeps document order
+TEST_CASE("Parallel parse matches serial parse", "[parser][parallel]") {
+    std::string markdown = R"(
+### AgenticDSL `/__meta__`
+```yaml
+# --- BEGIN AgenticDSL ---
+execution_budget:
+  max_nodes: 42
+# --- END AgenticDSL ---
+```
+)";
+    for (int i = 0; i < 40; ++i) {
+        markdown += "### AgenticDSL `/main/step_" + std::to_string(i) + "`\n"
+                    "```yaml\n"
+                    "# --- BEGIN AgenticDSL ---\n"
+                    "type: assign\n"
+                    "assign:\n"
+                    "  value: \"v" + std::to_string(i) + "\"\n"
+                    "# --- END AgenticDSL ---\n"
+                    "```\n\n";
+    }
+
+    MarkdownParser serial;
+    MarkdownParser parallel(4);
+    auto expected = serial.parse_from_string(markdown);
+    auto actual = parallel.parse_from_string(markdown);
+
+    REQUIRE(actual.size() == 40);
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        REQUIRE(actual[i].path == expected[i].path);
+        REQUIRE(actual[i].path == "/main/step_" + std::to_string(i));
+    }
+    REQUIRE(actual[0].budget.has_value());
+    REQUIRE(actual[0].budget->max_nodes == 42);
+
+    // 错误按文档顺序报告
+    markdown += "### AgenticDSL `bad_path`\n```yaml\n# --- BEGIN AgenticDSL ---\ntype: end\n# --- END AgenticDSL ---\n```\n";
+    REQUIRE_THROWS_WITH(parallel.parse_from_string(markdown), Catch::Matchers::ContainsSubstring("Invalid node path format"));
+}
+
+// Test 8d: Compiled graph cache round trip
+TEST_CASE("Graph cache rebuilds graphs without reparsing", "[parser][cache]") {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "agenticdsl-graph-cache-test";
+    fs::remove_all(dir);
+
+    std::string markdown = R"(
+### AgenticDSL `/__meta__`
+```yaml
+# --- BEGIN AgenticDSL ---
+execution_budget:
+  max_nodes: 7
+# --- END AgenticDSL ---
+```
+
+### AgenticDSL `/main`
+```yaml
+# --- BEGIN AgenticDSL ---
+graph_type: subgraph
+entry: start
+nodes:
+  - id: start
+    type: start
+    next: ["/main/greet"]
+  - id: greet
+    type: assign
+    assign:
+      greeting: "Hello {{ name }}"
+    next: ["/main/end"]
+  - id: end
+    type: end
+# --- END AgenticDSL ---
+```
+)";
+
+    MarkdownParser parser;
+    GraphCache cache(dir);
+    auto first = cache.load(markdown, parser);
+    fs::path entry = dir / [&] {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.adgc",
+                      static_cast<unsigned long long>(GraphCache::source_hash(markdown)));
+        return std::string(name);
+    }();
+    REQUIRE(fs::exists(entry));
+
+    auto second = cache.load(markdown, parser);
+    REQUIRE(second.size() == first.size());
+    REQUIRE(second[0].path == "/main");
+    REQUIRE(second[0].nodes.size() == 3);
+    REQUIRE(second[0].budget.has_value());
+    REQUIRE(second[0].budget->max_nodes == 7);
+    auto* assign = dynamic_cast<AssignNode*>(second[0].nodes[1].get());
+    REQUIRE(assign != nullptr);
+    REQUIRE(assign->assign.at("greeting") == "Hello {{ name }}");
+    REQUIRE(assign->compiled_assign.count("greeting") == 1);
+
+    // 损坏的缓存条目被忽略并重建
+    {
+        std::ofstream f(entry, std::ios::binary | std::ios::trunc);
+        f << "garbage";
+    }
+    auto rebuilt = cache.load(markdown, parser);
+    REQUIRE(rebuilt.size() == 1);
+    REQUIRE(fs::file_size(entry) > 7);
+
+    fs::remove_all(dir);
+}
+
+// Test 8d2: Default cache directory is private to the current user
+TEST_CASE("Graph cache defaults to a private per-user directory", "[parser][cache]") {
+    namespace fs = std::filesystem;
+    const fs::path base = fs::temp_directory_path() / "agenticdsl-xdg-test";
+    fs::remove_all(base);
+    const char* old_xdg = std::getenv("XDG_CACHE_HOME");
+    const std::string saved = old_xdg ? old_xdg : "";
+    ::setenv("XDG_CACHE_HOME", base.c_str(), 1);
+    ::unsetenv("AGENTICDSL_GRAPH_CACHE_DIR");
+
+    const fs::path dir = GraphCache::default_directory();
+    REQUIRE(dir == base / "agenticdsl-graph-cache");
+    REQUIRE((fs::status(dir).permissions() & (fs::perms::group_all | fs::perms::others_all)) == fs::perms::none);
+
+    // 已存在但权限过宽的目录被收紧
+    fs::permissions(dir, fs::perms::all);
+    REQUIRE(GraphCache::default_directory() == dir);
+    REQUIRE((fs::status(dir).permissions() & fs::perms::others_all) == fs::perms::none);
+
+    // 符号链接不被当作缓存目录
+    fs::remove_all(dir);
+    fs::create_directories(base / "elsewhere");
+    fs::create_directory_symlink(base / "elsewhere", dir);
+    REQUIRE(GraphCache::default_directory().empty());
+
+    // 没有缓存目录时照常解析，不写任何文件
+    GraphCache disabled{fs::path{}};
+    MarkdownParser parser;
+    auto graphs = disabled.load(R"(
+### AgenticDSL `/main`
+```yaml
+# --- BEGIN AgenticDSL ---
+graph_type: subgraph
+entry: start
+nodes:
+  - id: start
+    type: start
+    next: ["/main/end"]
+  - id: end
+    type: end
+# --- END AgenticDSL ---
+```
+)", parser);
+    REQUIRE(graphs.size() == 1);
+    REQUIRE(fs::is_empty(base / "elsewhere"));
+
+    if (old_xdg) ::setenv("XDG_CACHE_HOME", saved.c_str(), 1); else ::unsetenv("XDG_CACHE_HOME");
+    fs::remove_all(base);
+}
+
+// Test 8e: Streaming parser emits blocks as soon as they close
+TEST_CASE("Streaming parser emits closed blocks incrementally", "[parser][streaming]") {
+    std::string first = R"(Plan:
+### AgenticDSL `/dynamic/step_a`
+```yaml
+# --- BEGIN AgenticDSL ---
+type: assign
+assign:
+  a: "x"
+# --- END AgenticDSL ---
+```
+)";
+    std::string second = R"(
+### AgenticDSL `/dynamic/step_b`
+```yaml
+# --- BEGIN AgenticDSL ---
+type: end
+# --- END AgenticDSL ---
+```
+done)";
+
+    MarkdownParser parser;
+    std::vector<std::string> emitted;
+    StreamingDSLParser stream(parser, [&](std::vector<ParsedGraph> graphs) {
+        for (const auto& g : graphs) emitted.push_back(g.path);
+    });
+
+    // 逐字符喂入，模拟按 token 生成
+    for (char c : first) stream.feed(std::string_view(&c, 1));
+    REQUIRE(emitted == std::vector<std::string>{"/dynamic/step_a"});
+
+    for (char c : second) stream.feed(std::string_view(&c, 1));
+    stream.finish();
+    REQUIRE(emitted == std::vector<std::string>{"/dynamic/step_a", "/dynamic/step_b"});
+    REQUIRE(stream.blocks_emitted() == 2);
+
+    auto batch = parser.parse_from_string(stream.text());
+    REQUIRE(batch.size() == emitted.size());
+}
+
+TEST_CASE("Event-driven YAML conversion matches yaml_to_json", "[parser][yaml]") {
+    std::string yaml = R"(type: assign
+count: 3
+neg: -2
+plus: +5
+ratio: 0.25
+sci: 1e3
+big: 99999999999999999999
+hex: 0x10
+flag: true
+nothing: ~
+empty:
+label: "v1"
+base: &base {x: 1, y: [a, 2]}
+copy: *base
+next: ["/main/a", '/main/b']
+)";
+    auto direct = parse_yaml_to_json(yaml);
+    REQUIRE(direct == parse_yaml_str(yaml));
+    REQUIRE(direct["count"].is_number_integer());
+    REQUIRE(direct["plus"] == 5);
+    REQUIRE(direct["sci"].is_number_float());
+    REQUIRE(direct["big"] == "99999999999999999999"); // 超出 int64 保留为字符串
+    REQUIRE(direct["hex"] == "0x10");
+    REQUIRE(direct["empty"].is_null());
+    REQUIRE(direct["copy"] == direct["base"]);
+
+    REQUIRE(parse_yaml_to_json("").is_null());
+    REQUIRE_THROWS_AS(parse_yaml_to_json("a: [1, 2"), YAML::ParserException);
+}
+
 // Test 9: Invalid path format
 TEST_CASE("Invalid Path Format", "[parser]") {
     std::string markdown = R"(
@@ -368,3 +647,38 @@ next: ["/main/end"]
     REQUIRE(node->signature == "(query: string) -> results");
     REQUIRE(node->permissions == std::vector<std::string>{"network"});
 }
+
+// Test 13: generate_subgraph output grammar
+TEST_CASE("DSL block grammar covers block format and node types", "[parser][grammar]") {
+    std::string grammar = agenticdsl::dsl_block_grammar();
+    REQUIRE(grammar.rfind("root ::= ", 0) == 0);
+    REQUIRE(grammar.find("path ::= \"/dynamic/\"") != std::string::npos);
+    REQUIRE(grammar.find("# --- BEGIN AgenticDSL ---") != std::string::npos);
+    REQUIRE(grammar.find("# --- END AgenticDSL ---") != std::string::npos);
+    for (const char* type : {"start", "end", "assign", "tool_call", "generate_subgraph", "assert"}) {
+        REQUIRE(grammar.find("\"" + std::string(type) + "\"") != std::string::npos);
+    }
+
+    // 前缀中的引号需要转义
+    std::string custom = agenticdsl::dsl_block_grammar("/dynamic/\"x\"/");
+    REQUIRE(custom.find("path ::= \"/dynamic/\\\"x\\\"/\"") != std::string::npos);
+
+    std::string markdown = R"(
+### AgenticDSL `/main/gen`
+```yaml
+# --- BEGIN AgenticDSL ---
+type: generate_subgraph
+prompt_template: "plan"
+output_keys: ["out"]
+constrain_output: false
+# --- END AgenticDSL ---
+```
+)";
+    agenticdsl::MarkdownParser parser;
+    auto graphs = parser.parse_from_string(markdown);
+    REQUIRE(graphs.size() == 1);
+    auto* node = dynamic_cast<agenticdsl::GenerateSubgraphNode*>(graphs[0].nodes[0].get());
+    REQUIRE(node != nullptr);
+    REQUIRE_FALSE(node->constrain_output);
+    REQUIRE_FALSE(dynamic_cast<agenticdsl::GenerateSubgraphNode*>(node->clone().get())->constrain_output);
+}
@@ -1,7 +1,12 @@
 // tests/test_scheduler.cpp
 #include "catch_amalgamated.hpp"
 #include "core/engine.h"
+#include "modules/scheduler/topo_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
 #include <string>
 
 // Helper: 执行 DSL 并返回最终上下文
@@ -215,3 +220,335 @@ next: "/main/end"
     auto ctx = run_dsl(markdown);
     REQUIRE(ctx["side_done"] == "yes");
 }
+
+// Test: 读写集互不相交的工具调用被并发执行，结果与顺序执行一致
+// 记录同时在执行的调用数；每次调用最多等 2 秒让另一个调用进来，顺序执行时 max_in_flight 保持为 1
+struct OverlapProbe {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int in_flight = 0;
+    int max_in_flight = 0;
+
+    void enter_and_wait_for_peer() {
+        std::unique_lock<std::mutex> lock(mutex);
+        max_in_flight = std::max(max_in_flight, ++in_flight);
+        cv.notify_all();
+        cv.wait_until(lock, std::chrono::system_clock::now() + std::chrono::seconds(2), [this] { return max_in_flight >= 2; });
+        --in_flight;
+    }
+};
+
+TEST_CASE("Independent tool calls run in parallel", "[scheduler][dependency]") {
+    std::string markdown = R"(
+### AgenticDSL `/main`
+```yaml
+# --- BEGIN AgenticDSL ---
+graph_type: subgraph
+entry: start
+nodes:
+  - id: start
+    type: assign
+    assign:
+      city: "Paris"
+      topic: "museums"
+    next: /main/weather
+  - id: weather
+    type: tool_call
+    tool: probe
+    arguments:
+      value: "{{ city }}"
+    output_keys: ["weather"]
+    next: /main/search
+  - id: search
+    type: tool_call
+    tool: probe
+    arguments:
+      value: "{{ topic }}"
+    output_keys: ["search"]
+    next: /main/summary
+  - id: summary
+    type: tool_call
+    tool: echo
+    arguments:
+      value: "{{ weather.value }}"
+    output_keys: ["summary"]
+    next: /main/end
+  - id: end
+    type: end
+    termination_mode: hard
+# --- END AgenticDSL ---
+```
+)";
+
+    OverlapProbe probe;
+    auto engine = agenticdsl::DSLEngine::from_markdown(markdown);
+    engine->register_tool("probe", [&probe](const nlohmann::json& args) {
+        probe.enter_and_wait_for_peer();
+        return nlohmann::json{{"value", args.value("value", "")}};
+    });
+    engine->register_tool("echo", [](const nlohmann::json& args) {
+        return nlohmann::json{{"value", args.value("value", "")}};
+    });
+    auto result = engine->run();
+    INFO(result.message);
+    REQUIRE(result.success);
+
+    // weather 与 search 互不读写对方的键：next 边被放松，两次调用同时进行
+    REQUIRE(probe.max_in_flight == 2);
+    REQUIRE(result.final_context["weather"]["value"] == "Paris");
+    REQUIRE(result.final_context["search"]["value"] == "museums");
+    REQUIRE(result.final_context["summary"]["value"] == "Paris");
+}
+
+// 同时调用时等待另一个调用进入的 LLM 工具
+class ProbeLLM : public agenticdsl::ILLMTool {
+public:
+    explicit ProbeLLM(OverlapProbe& probe) : probe_(probe) {}
+
+    agenticdsl::LLMResult generate(const std::string& prompt, const agenticdsl::LLMParams& = {}) override {
+        probe_.enter_and_wait_for_peer();
+        agenticdsl::LLMResult result;
+        result.success = true;
+        result.text = "answer to " + prompt;
+        return result;
+    }
+    bool is_available() const override { return true; }
+    std::string name() const override { return "probe_llm"; }
+
+private:
+    OverlapProbe& probe_;
+};
+
+TEST_CASE("Independent LLM calls run in parallel and a failing peer keeps the others' writes", "[scheduler][dependency]") {
+    using namespace agenticdsl;
+    auto make_scheduler = [](ToolRegistry& registry, std::vector<std::unique_ptr<Node>> nodes) {
+        auto scheduler = std::make_unique<TopoScheduler>(TopoScheduler::Config{}, registry, nullptr);
+        for (auto& node : nodes) scheduler->register_node(std::move(node));
+        scheduler->build_dag();
+        return scheduler;
+    };
+
+    OverlapProbe probe;
+    ToolRegistry registry;
+    registry.register_llm_tool("probe_llm", std::make_unique<ProbeLLM>(probe));
+    {
+        // 两个互不相关的 LLM 调用同时解码；整批合并后按第一个调用暂停
+        std::vector<std::unique_ptr<Node>> nodes;
+        nodes.push_back(std::make_unique<DSLNode>("/main/a", "alpha", "probe_llm", LLMParams{},
+                                                  std::vector<std::string>{"a"}));
+        nodes.push_back(std::make_unique<DSLNode>("/main/b", "beta", "probe_llm", LLMParams{},
+                                                  std::vector<std::string>{"b"}));
+        auto scheduler = make_scheduler(registry, std::move(nodes));
+
+        auto result = scheduler->execute(Context::object());
+        INFO(result.message);
+        REQUIRE(result.success);
+        REQUIRE(probe.max_in_flight == 2);
+        REQUIRE(result.paused_at == std::optional<NodePath>("/main/a"));
+        REQUIRE(result.final_context.contains("a"));
+        REQUIRE(result.final_context.contains("b"));
+    }
+    {
+        // 同批的工具调用失败：已完成的成员写入仍然合并，再报告错误
+        registry.register_tool("ok", [](const nlohmann::json&) { return nlohmann::json{{"value", 1}}; });
+        std::vector<std::unique_ptr<Node>> nodes;
+        nodes.push_back(std::make_unique<ToolCallNode>("/main/ok", "ok", std::unordered_map<std::string, std::string>{},
+                                                       std::vector<std::string>{"ok_out"}));
+        nodes.push_back(std::make_unique<ToolCallNode>("/main/broken", "missing_tool",
+                                                       std::unordered_map<std::string, std::string>{},
+                                                       std::vector<std::string>{"broken_out"}));
+        auto scheduler = make_scheduler(registry, std::move(nodes));
+
+        auto result = scheduler->execute(Context::object());
+        REQUIRE_FALSE(result.success);
+        REQUIRE_THAT(result.message, Catch::Matchers::ContainsSubstring("missing_tool"));
+        REQUIRE(result.final_context["ok_out"]["value"] == 1);
+        REQUIRE_FALSE(result.final_context.contains("broken_out"));
+    }
+}
+
+// Test: 动态图在产生它的节点成功后才整体并入；引用不完整时整批拒绝
+TEST_CASE("Dynamic graphs are committed only as a whole", "[scheduler][dynamic]") {
+    using namespace agenticdsl;
+    auto make_graph = [](const std::string& path, const std::string& next) {
+        ParsedGraph graph;
+        graph.path = path;
+        graph.nodes.push_back(std::make_unique<StartNode>(path + "/start", std::vector<NodePath>{next}));
+        auto end = std::make_unique<EndNode>(path + "/end");
+        end->metadata["termination_mode"] = "soft";
+        graph.nodes.push_back(std::move(end));
+        return graph;
+    };
+    auto make_scheduler = [](ToolRegistry& registry) {
+        auto scheduler = std::make_unique<TopoScheduler>(TopoScheduler::Config{}, registry, nullptr);
+        scheduler->register_node(std::make_unique<StartNode>("/main/start", std::vector<NodePath>{"/main/end"}));
+        auto end = std::make_unique<EndNode>("/main/end");
+        end->metadata["termination_mode"] = "soft";
+        scheduler->register_node(std::move(end));
+        scheduler->build_dag();
+        return scheduler;
+    };
+    auto executed = [](const TopoScheduler& scheduler, const NodePath& path) {
+        auto traces = scheduler.get_last_traces();
+        return std::any_of(traces.begin(), traces.end(), [&](const TraceRecord& t) { return t.node_path == path; });
+    };
+
+    ToolRegistry registry;
+    {
+        // 两个块分别暂存，/main/start 成功后一起并入并执行
+        auto scheduler = make_scheduler(registry);
+        std::vector<ParsedGraph> first;
+        first.push_back(make_graph("/dynamic/a", "/dynamic/a/end"));
+        scheduler->append_dynamic_graphs(std::move(first));
+        std::vector<ParsedGraph> second;
+        second.push_back(make_graph("/dynamic/b", "/dynamic/a/end"));
+        scheduler->append_dynamic_graphs(std::move(second));
+
+        auto result = scheduler->execute(Context::object());
+        INFO(result.message);
+        REQUIRE(result.success);
+        REQUIRE(executed(*scheduler, "/dynamic/a/start"));
+        REQUIRE(executed(*scheduler, "/dynamic/b/start"));
+    }
+    {
+        // 第二个块引用了不存在的节点：第一个块也不并入
+        auto scheduler = make_scheduler(registry);
+        std::vector<ParsedGraph> graphs;
+        graphs.push_back(make_graph("/dynamic/a", "/dynamic/a/end"));
+        graphs.push_back(make_graph("/dynamic/b", "/dynamic/missing"));
+        scheduler->append_dynamic_graphs(std::move(graphs));
+
+        auto result = scheduler->execute(Context::object());
+        REQUIRE_FALSE(result.success);
+        REQUIRE_THAT(result.message, Catch::Matchers::ContainsSubstring("/dynamic/missing"));
+        REQUIRE_FALSE(executed(*scheduler, "/dynamic/a/start"));
+    }
+    {
+        // 两个块生成了同一路径：后者不得覆盖前者，整批拒绝
+        auto scheduler = make_scheduler(registry);
+        std::vector<ParsedGraph> first;
+        first.push_back(make_graph("/dynamic/a", "/dynamic/a/end"));
+        scheduler->append_dynamic_graphs(std::move(first));
+        std::vector<ParsedGraph> second;
+        second.push_back(make_graph("/dynamic/a", "/dynamic/a/end"));
+        scheduler->append_dynamic_graphs(std::move(second));
+
+        auto result = scheduler->execute(Context::object());
+        REQUIRE_FALSE(result.success);
+        REQUIRE_THAT(result.message, Catch::Matchers::ContainsSubstring("duplicate node path: /dynamic/a/start"));
+        REQUIRE_FALSE(executed(*scheduler, "/dynamic/a/start"));
+    }
+    {
+        // 与已有节点重名：不能重置 /main/end 的入度让它提前执行
+        auto scheduler = make_scheduler(registry);
+        ParsedGraph graph;
+        graph.path = "/dynamic/clash";
+        graph.nodes.push_back(std::make_unique<StartNode>("/main/end", std::vector<NodePath>{}));
+        std::vector<ParsedGraph> graphs;
+        graphs.push_back(std::move(graph));
+        scheduler->append_dynamic_graphs(std::move(graphs));
+
+        auto result = scheduler->execute(Context::object());
+        REQUIRE_FALSE(result.success);
+        REQUIRE_THAT(result.message, Catch::Matchers::ContainsSubstring("duplicate node path: /main/end"));
+    }
+}
+
+// 按块流式输出 DSL 的 LLM 工具：第一个块输出后等待其节点被执行，再输出其余块
+class BlockStreamingLLM : public agenticdsl::ILLMTool {
+public:
+    BlockStreamingLLM(std::vector<std::string> blocks, std::mutex& mutex, std::condition_variable& cv, bool& first_ran)
+        : blocks_(std::move(blocks)), mutex_(mutex), cv_(cv), first_ran_(first_ran) {}
+
+    agenticdsl::LLMResult generate(const std::string& prompt, const agenticdsl::LLMParams& params = {}) override {
+        return generate_stream(prompt, nullptr, params);
+    }
+
+    agenticdsl::LLMResult generate_stream(const std::string&, const StreamCallback& on_chunk,
+                                          const agenticdsl::LLMParams& = {}) override {
+        agenticdsl::LLMResult result;
+        for (size_t i = 0; i < blocks_.size(); ++i) {
+            if (on_chunk && !on_chunk(blocks_[i])) break;
+            result.text += blocks_[i];
+            if (i == 0) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                overlapped = cv_.wait_until(lock, std::chrono::system_clock::now() + std::chrono::seconds(10),
+                                              [this] { return first_ran_; });
+            }
+        }
+        result.success = true;
+        return result;
+    }
+
+    bool is_available() const override { return true; }
+    std::string name() const override { return "block_stream"; }
+
+    bool overlapped = false; // 生成仍在进行时第一个块的节点已执行
+
+private:
+    std::vector<std::string> blocks_;
+    std::mutex& mutex_;
+    std::condition_variable& cv_;
+    bool& first_ran_;
+};
+
+TEST_CASE("Generated nodes run while later blocks are still decoding", "[scheduler][dynamic]") {
+    using namespace agenticdsl;
+    auto block = [](const std::string& path, const std::string& tool, const std::string& next) {
+        std::string text = "### AgenticDSL `" + path + "`\n```yaml\n# --- BEGIN AgenticDSL ---\n"
+                           "type: tool_call\ntool: " + tool + "\noutput_keys: [\"" + tool + "_out\"]\n";
+        if (!next.empty()) text += "next: [\"" + next + "\"]\n";
+        return text + "# --- END AgenticDSL ---\n```\n";
+    };
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool first_ran = false;
+    std::vector<std::string> order;
+
+    ToolRegistry registry;
+    registry.register_tool("first", [&](const nlohmann::json&) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            first_ran = true;
+            order.push_back("first");
+        }
+        cv.notify_all();
+        return nlohmann::json::object();
+    });
+    for (std::string name : {"second", "third"}) {
+        registry.register_tool(name, [&, name](const nlohmann::json&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+            return nlohmann::json::object();
+        });
+    }
+    // 第二个块引用第三个块中的节点：第三个块到达前第二个块不能并入
+    auto llm = std::make_unique<BlockStreamingLLM>(std::vector<std::string>{
+        block("/dynamic/first", "first", ""),
+        block("/dynamic/second", "second", "/dynamic/third"),
+        block("/dynamic/third", "third", ""),
+    }, mutex, cv, first_ran);
+    BlockStreamingLLM* llm_ptr = llm.get();
+    registry.register_llm_tool("block_stream", std::move(llm));
+
+    TopoScheduler scheduler(TopoScheduler::Config{}, registry, nullptr);
+    scheduler.register_node(std::make_unique<StartNode>("/main/start", std::vector<NodePath>{"/main/generate"}));
+    auto generate = std::make_unique<GenerateSubgraphNode>("/main/generate", "plan",
+                                                           std::vector<std::string>{"generated"},
+                                                           std::vector<NodePath>{"/main/end"});
+    generate->llm_tool_name = "block_stream";
+    scheduler.register_node(std::move(generate));
+    auto end = std::make_unique<EndNode>("/main/end");
+    end->metadata["termination_mode"] = "soft";
+    scheduler.register_node(std::move(end));
+    scheduler.build_dag();
+
+    auto result = scheduler.execute(Context::object());
+    INFO(result.message);
+    REQUIRE(result.success);
+    REQUIRE(llm_ptr->overlapped);
+    REQUIRE(order == std::vector<std::string>{"first", "second", "third"});
+    REQUIRE(result.final_context["generated"] ==
+            nlohmann::json::array({"/dynamic/first", "/dynamic/second", "/dynamic/third"}));
+}
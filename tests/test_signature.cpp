@@ -0,0 +1,73 @@
+// tests/test_signature.cpp
+#include "catch_amalgamated.hpp"
+#include "common/utils/signature.h"
+#include "modules/parser/markdown_parser.h"
+
+#include <string>
+
+using namespace agenticdsl;
+
+TEST_CASE("Signature parses documented output forms", "[signature]") {
+    auto braced = Signature::parse("(a: number, b: number) -> {sum: number}");
+    REQUIRE(braced.inputs().size() == 2);
+    REQUIRE(braced.outputs().size() == 1);
+    REQUIRE(braced.outputs()[0].name == "sum");
+    REQUIRE(braced.outputs()[0].kind == Signature::Kind::Number);
+
+    auto bare = Signature::parse("(a: number, b: number) -> sum: number");
+    REQUIRE(bare.outputs_json() == braced.outputs_json());
+
+    auto untyped = Signature::parse("(query: string) -> results");
+    REQUIRE(untyped.outputs()[0].kind == Signature::Kind::Any);
+
+    auto rich = Signature::parse("(items: string[], limit?: int) -> {ok: bool, rows: object[]}");
+    REQUIRE_FALSE(rich.inputs()[1].required);
+    REQUIRE(rich.inputs()[0].kind == Signature::Kind::Array);
+    REQUIRE(rich.inputs()[0].item_kind == Signature::Kind::String);
+
+    REQUIRE(Signature::parse("()").outputs().empty());
+    REQUIRE_THROWS_WITH(Signature::parse("(a: numbr) -> x"), Catch::Matchers::ContainsSubstring("unknown type 'numbr'"));
+    REQUIRE_THROWS(Signature::parse("(a: number -> x"));
+    REQUIRE_THROWS(Signature::parse("(a, a)"));
+}
+
+TEST_CASE("Signature validates values without throwing", "[signature]") {
+    auto sig = Signature::parse("(a: number, tags?: string[]) -> {sum: number, note?: string}");
+
+    REQUIRE_FALSE(sig.check_inputs({{"a", 1}, {"tags", {"x", "y"}}}).has_value());
+    REQUIRE_FALSE(sig.check_inputs({{"a", 1.5}}).has_value());
+    REQUIRE(sig.check_inputs({{"tags", {"x"}}}).value() == "missing input 'a'");
+    REQUIRE(sig.check_inputs({{"a", 1}, {"tags", {"x", 2}}}).value() == "input 'tags' expected string[], got array");
+
+    REQUIRE_FALSE(sig.check_outputs({{"sum", 3}, {"other", "ignored"}}).has_value());
+    REQUIRE(sig.check_outputs({{"sum", "3"}}).value() == "output 'sum' expected number, got string");
+    REQUIRE(sig.check_outputs(nullptr).value() == "output must be an object");
+
+    REQUIRE_FALSE(sig.check_declared_outputs({"sum"}).has_value());
+    REQUIRE(sig.check_declared_outputs({"note"}).value() == "no node writes output 'sum'");
+}
+
+TEST_CASE("Parser compiles graph signatures into output schemas", "[signature][parser]") {
+    std::string markdown = R"(
+### AgenticDSL `/lib/math/double`
+```yaml
+# --- BEGIN AgenticDSL ---
+graph_type: subgraph
+signature: "(x: number) -> {result: number}"
+nodes:
+  - id: calc
+    type: assign
+    assign:
+      result: "{{ inputs.x * 2 }}"
+    next: ["/end_soft"]
+# --- END AgenticDSL ---
+```
+)";
+    MarkdownParser parser;
+    auto graphs = parser.parse_from_string(markdown);
+    REQUIRE(graphs.size() == 1);
+    REQUIRE(graphs[0].compiled_signature != nullptr);
+    REQUIRE(graphs[0].output_schema.has_value());
+    REQUIRE((*graphs[0].output_schema)[0]["name"] == "result");
+    REQUIRE((*graphs[0].output_schema)[0]["type"] == "number");
+}
@@ -0,0 +1,113 @@
+// tests/test_snapshot_codec.cpp
+#include "catch_amalgamated.hpp"
+#include "common/utils/snapshot_codec.h"
+#include "common/utils/lz_codec.h"
+#include "modules/context/context_engine.h"
+
+#include <string>
+#include <vector>
+
+using namespace agenticdsl;
+
+static Context make_context(int entries) {
+    Context ctx = Context::object();
+    for (int i = 0; i < entries; ++i) {
+        ctx["item_" + std::to_string(i)] = {
+            {"id", i},
+            {"text", "repeated payload text for snapshot compression"},
+            {"tags", nlohmann::json::array({"a", "b", "c"})}
+        };
+    }
+    return ctx;
+}
+
+TEST_CASE("LZ codec round-trips data", "[snapshot][lz]") {
+    std::string text;
+    for (int i = 0; i < 200; ++i) text += "abcabcabc-" + std::to_string(i % 7);
+    std::vector<std::uint8_t> input(text.begin(), text.end());
+
+    auto packed = lz_compress(input);
+    REQUIRE(packed.size() < input.size());
+    REQUIRE(lz_decompress(packed, input.size()) == input);
+
+    std::vector<std::uint8_t> tiny = {'x', 'y'};
+    REQUIRE(lz_decompress(lz_compress(tiny), tiny.size()) == tiny);
+    REQUIRE_THROWS(lz_decompress(packed, input.size() + 1));
+}
+
+TEST_CASE("Snapshot codec round-trips all formats", "[snapshot]") {
+    Context ctx = make_context(20);
+    for (auto format : {SnapshotFormat::CBOR, SnapshotFormat::MSGPACK, SnapshotFormat::JSON}) {
+        for (bool compress : {false, true}) {
+            auto encoded = encode_snapshot(ctx, format, compress);
+            REQUIRE(decode_snapshot(encoded) == ctx);
+
+            auto blob = serialize_snapshot(encoded);
+            auto restored = deserialize_snapshot(blob);
+            REQUIRE(restored.format == format);
+            REQUIRE(decode_snapshot(restored) == ctx);
+        }
+    }
+
+    auto cbor = encode_snapshot(ctx, SnapshotFormat::CBOR);
+    REQUIRE(cbor.size_bytes() < ctx.dump().size());
+    REQUIRE(encode_snapshot(ctx, SnapshotFormat::CBOR, true).size_bytes() < cbor.size_bytes());
+    REQUIRE(parse_snapshot_format("msgpack") == SnapshotFormat::MSGPACK);
+    REQUIRE_FALSE(parse_snapshot_format("xml").has_value());
+}
+
+TEST_CASE("Snapshot blobs with an implausible raw size are rejected", "[snapshot]") {
+    auto encoded = encode_snapshot(make_context(20), SnapshotFormat::CBOR, true);
+    REQUIRE(encoded.compressed);
+    auto blob = serialize_snapshot(encoded);
+
+    // 头部第 7..14 字节是小端 raw_size；伪造成远超压缩比上限的长度
+    auto forge = [](std::vector<std::uint8_t> b, std::uint64_t raw_size) {
+        for (int i = 0; i < 8; ++i) b[7 + i] = static_cast<std::uint8_t>((raw_size >> (8 * i)) & 0xFF);
+        return b;
+    };
+    REQUIRE_THROWS_AS(deserialize_snapshot(forge(blob, std::uint64_t{1} << 40)), std::runtime_error);
+    REQUIRE_THROWS_AS(deserialize_snapshot(forge(blob, UINT64_MAX)), std::runtime_error);
+    REQUIRE_THROWS_AS(lz_decompress(encoded.bytes, lz_max_decompressed_size(encoded.bytes.size()) + 1),
+                      std::runtime_error);
+
+    auto plain = serialize_snapshot(encode_snapshot(make_context(2), SnapshotFormat::JSON));
+    REQUIRE_THROWS_AS(deserialize_snapshot(forge(plain, plain.size())), std::runtime_error);
+    REQUIRE_NOTHROW(deserialize_snapshot(blob));
+}
+
+TEST_CASE("ContextEngine stores compressed cold snapshots", "[snapshot][context]") {
+    ContextEngine engine;
+    engine.set_snapshot_limits(10, 512);
+    engine.set_snapshot_encoding(SnapshotFormat::CBOR, true, 1);
+
+    Context first = make_context(50);
+    Context second = make_context(60);
+    engine.save_snapshot("/main/first", first);
+    size_t hot_bytes = engine.snapshot_bytes();
+    engine.save_snapshot("/main/second", second);
+
+    // /main/first 变冷后被压缩，总量小于两份未压缩快照
+    REQUIRE(engine.snapshot_bytes() < hot_bytes + encode_snapshot(second).size_bytes());
+    REQUIRE(engine.get_snapshot("/main/first") == first);
+    REQUIRE(engine.get_snapshot("/main/second") == second);
+    REQUIRE_FALSE(engine.get_snapshot("/main/missing").has_value());
+
+    auto blob = engine.export_snapshot("/main/first");
+    REQUIRE(blob.has_value());
+    ContextEngine other;
+    other.import_snapshot("/restored", *blob);
+    REQUIRE(other.get_snapshot("/restored") == first);
+}
+
+TEST_CASE("ContextEngine evicts oldest snapshots FIFO", "[snapshot][context]") {
+    ContextEngine engine;
+    engine.set_snapshot_limits(2, 512);
+    engine.save_snapshot("/a", make_context(1));
+    engine.save_snapshot("/b", make_context(2));
+    engine.save_snapshot("/c", make_context(3));
+
+    REQUIRE_FALSE(engine.get_snapshot("/a").has_value());
+    REQUIRE(engine.get_snapshot("/b").has_value());
+    REQUIRE(engine.get_snapshot("/c").has_value());
+}